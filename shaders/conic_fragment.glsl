@@ -0,0 +1,25 @@
+#version 330 core
+in vec2 vLocal;
+out vec4 FragColor;
+
+// Phương trình ẩn của conic đã dời về tâm quad (CPU tính hệ số bằng double rồi chuẩn hóa):
+// f(p) = p^T M p + g.p + h, p là độ lệch pixel so với tâm quad (luôn nhỏ, kể cả khi zoom rất sâu)
+uniform vec3 u_quad;       // M = [x y; y z]
+uniform vec2 u_linear;     // g
+uniform float u_const;     // h
+uniform vec3 u_color;
+uniform float u_halfWidth; // Nửa độ dày nét (pixel)
+
+void main()
+{
+    vec2 p = vLocal;
+    vec2 mp = vec2(u_quad.x * p.x + u_quad.y * p.y, u_quad.y * p.x + u_quad.z * p.y);
+    float f = dot(p, mp) + dot(u_linear, p) + u_const;
+    vec2 grad = 2.0 * mp + u_linear;
+    // Khoảng cách xấp xỉ bậc 1 tới đường cong: |f| / |grad f|, nét đều độ dày ở mọi mức zoom
+    float d = abs(f) / max(length(grad), 1e-20);
+    float alpha = clamp(u_halfWidth + 0.5 - d, 0.0, 1.0);
+    if (alpha <= 0.0)
+        discard;
+    FragColor = vec4(u_color, alpha);
+}
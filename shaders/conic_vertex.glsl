@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;   // NDC
+layout (location = 1) in vec2 aLocal; // Độ lệch (pixel, theo trục World) so với tâm quad
+
+out vec2 vLocal;
+void main()
+{
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vLocal = aLocal;
+}
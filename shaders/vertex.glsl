@@ -1,10 +1,10 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec4 aColor; // RGBA8 chuẩn hóa
 
 out vec3 vertexColor;
 void main()
 {
-    gl_Position = vec4(aPos, 1.0);
-    vertexColor = aColor;
-}
\ No newline at end of file
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vertexColor = aColor.rgb;
+}
@@ -0,0 +1,86 @@
+#ifndef ASYNC_TASK_H
+#define ASYNC_TASK_H
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <functional>
+#include <exception>
+
+// Chạy một công việc (đọc/ghi file...) trên luồng nền, luồng UI hỏi trạng thái mỗi frame.
+// Hàm work nhận chính task để báo tiến độ/lỗi và kiểm tra yêu cầu hủy.
+class AsyncTask {
+public:
+    using Work = std::function<bool(AsyncTask &)>;
+
+    ~AsyncTask() {
+        cancel();
+        if (worker.joinable()) worker.join();
+    }
+
+    // false nếu đang có việc khác chạy
+    bool start(Work work) {
+        if (running) return false;
+        if (worker.joinable()) worker.join();
+        running = true;
+        cancelFlag = false;
+        progressValue = 0.0f;
+        ok = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            errorMsg.clear();
+        }
+        worker = std::thread([this, work]() {
+            // Ngoại lệ (file hỏng -> bad_alloc...) không được thoát khỏi luồng (std::terminate): báo lỗi cho UI
+            bool result = false;
+            try {
+                result = work(*this);
+            } catch (const std::exception &e) {
+                setError(e.what());
+            } catch (...) {
+                setError("Unexpected error");
+            }
+            ok = result;
+            running = false;
+        });
+        return true;
+    }
+
+    bool busy() const { return running || worker.joinable(); }
+
+    // Gọi mỗi frame ở luồng UI: trả về true đúng một lần khi việc vừa xong
+    bool poll() {
+        if (running || !worker.joinable()) return false;
+        worker.join();
+        return true;
+    }
+
+    bool succeeded() const { return ok; }
+    float progress() const { return progressValue; }
+    std::string error() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return errorMsg;
+    }
+
+    void cancel() { cancelFlag = true; }
+
+    // Dùng bên trong work
+    bool cancelled() const { return cancelFlag; }
+    void setProgress(float p) { progressValue = p; }
+    void setError(const std::string &msg) {
+        std::lock_guard<std::mutex> lock(mtx);
+        errorMsg = msg;
+    }
+
+private:
+    std::thread worker;
+    std::mutex mtx;
+    std::atomic<bool> running{false};
+    std::atomic<bool> cancelFlag{false};
+    std::atomic<bool> ok{false};
+    std::atomic<float> progressValue{0.0f};
+    std::string errorMsg;
+};
+
+#endif // ASYNC_TASK_H
@@ -0,0 +1,163 @@
+#ifndef AUTOSAVE_DIR_H
+#define AUTOSAVE_DIR_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <share.h>
+#include <sys/stat.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+// Thư mục autosave riêng cho mỗi phiên chạy: <app-data của user>/autosave/<pid>-<n>/, trong đó có file "lock"
+// được khóa độc quyền suốt phiên. Hệ điều hành tự nhả khóa khi tiến trình chết, nên thư mục có dữ liệu mà
+// khóa được là của một phiên đã crash: phiên mới nhận lại (khôi phục rồi ghi tiếp vào đó). Nhiều phiên chạy
+// cùng lúc không bao giờ đụng file của nhau.
+class AutosaveDir {
+public:
+    ~AutosaveDir() { unlock(); }
+
+    // <LOCALAPPDATA>/OpenGL2DGeometryApp/autosave (Windows) hoặc <XDG_STATE_HOME | ~/.local/state>/OpenGL2DGeometryApp/autosave
+    static std::filesystem::path defaultBase() {
+        namespace fs = std::filesystem;
+#ifdef _WIN32
+        const char *env = std::getenv("LOCALAPPDATA");
+        if (!env || !*env) env = std::getenv("APPDATA");
+        fs::path root = (env && *env) ? fs::path(env) : fs::temp_directory_path();
+#else
+        const char *state = std::getenv("XDG_STATE_HOME");
+        const char *home = std::getenv("HOME");
+        fs::path root = (state && *state) ? fs::path(state)
+                        : (home && *home) ? fs::path(home) / ".local" / "state"
+                                          : fs::temp_directory_path();
+#endif
+        return root / "OpenGL2DGeometryApp" / "autosave";
+    }
+
+    // Nhận thư mục cho phiên này: ưu tiên thư mục mới nhất của phiên đã crash (recovered() = true),
+    // không có thì tạo thư mục mới. false nếu không tạo/khóa được (autosave tắt)
+    bool acquire(const std::filesystem::path &base) {
+        namespace fs = std::filesystem;
+        unlock();
+        recoveredDir = false;
+        std::error_code ec;
+        fs::create_directories(base, ec);
+        if (ec) return false;
+
+        // Thư mục bỏ lại, mới nhất trước
+        struct Candidate { fs::path path; fs::file_time_type time; };
+        std::vector<Candidate> orphans;
+        for (fs::directory_iterator it(base, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code dirEc;
+            if (!it->is_directory(dirEc)) continue;
+            orphans.push_back({it->path(), newestFile(it->path())});
+        }
+        std::sort(orphans.begin(), orphans.end(), [](const Candidate &a, const Candidate &b) { return a.time > b.time; });
+        for (const Candidate &c : orphans) {
+            if (!lock(c.path)) continue; // Phiên khác đang chạy
+            if (hasData(c.path)) {
+                dir = c.path;
+                recoveredDir = true;
+                return true;
+            }
+            // Thư mục rỗng của phiên đã thoát dở: dọn đi
+            unlock();
+            fs::remove_all(c.path, ec);
+        }
+
+        for (int n = 0; n < 1000; ++n) {
+            fs::path p = base / (std::to_string(processId()) + "-" + std::to_string(n));
+            if (fs::exists(p, ec)) continue;
+            fs::create_directory(p, ec);
+            if (!ec && lock(p)) {
+                dir = p;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool active() const { return lockFd >= 0; }
+    bool recovered() const { return recoveredDir; }
+    const std::filesystem::path &path() const { return dir; }
+    std::string file(const std::string &name) const { return (dir / name).string(); }
+
+    // Thoát bình thường (các file autosave đã được xóa): nhả khóa và xóa thư mục
+    void release() {
+        if (!active()) return;
+        unlock();
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+
+private:
+    std::filesystem::path dir;
+    int lockFd = -1;
+    bool recoveredDir = false;
+
+    static int processId() {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return (int)getpid();
+#endif
+    }
+
+    // Khóa độc quyền không chờ; giữ file mở tới khi unlock
+    bool lock(const std::filesystem::path &d) {
+        std::string p = (d / "lock").string();
+#ifdef _WIN32
+        int fd = -1;
+        // _SH_DENYRW: phiên khác không mở được file cho tới khi ta đóng (hoặc tiến trình chết)
+        if (_sopen_s(&fd, p.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _SH_DENYRW, _S_IREAD | _S_IWRITE) != 0) return false;
+#else
+        int fd = ::open(p.c_str(), O_RDWR | O_CREAT, 0600);
+        if (fd < 0) return false;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            ::close(fd);
+            return false;
+        }
+#endif
+        lockFd = fd;
+        return true;
+    }
+
+    void unlock() {
+        if (lockFd < 0) return;
+#ifdef _WIN32
+        _close(lockFd);
+#else
+        ::close(lockFd);
+#endif
+        lockFd = -1;
+    }
+
+    static bool hasData(const std::filesystem::path &d) {
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(d, ec), end; !ec && it != end; it.increment(ec))
+            if (it->path().filename() != "lock") return true;
+        return false;
+    }
+
+    static std::filesystem::file_time_type newestFile(const std::filesystem::path &d) {
+        std::error_code ec;
+        std::filesystem::file_time_type t = std::filesystem::file_time_type::min();
+        for (std::filesystem::directory_iterator it(d, ec), end; !ec && it != end; it.increment(ec)) {
+            std::filesystem::file_time_type w = it->last_write_time(ec);
+            if (!ec && w > t) t = w;
+        }
+        return t;
+    }
+};
+
+#endif // AUTOSAVE_DIR_H
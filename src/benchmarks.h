@@ -0,0 +1,320 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <functional>
+#include "segment_simd.h"
+#include "conic_simd.h"
+#include "predicates.h"
+#include "intersections.h"
+#include "point_sets.h"
+#include "scene_index.h"
+
+// Benchmark chạy từ dòng lệnh (app --bench), không mở cửa sổ; in kết quả ra stdout.
+
+namespace bench {
+
+// Thời gian trung bình (ms) của fn qua nhiều lần chạy, bỏ lần chạy đầu (làm nóng cache)
+inline double timeMs(int repeats, const std::function<void()> &fn) {
+    fn();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / repeats;
+}
+
+// Khoảng cách điểm - 1M đoạn: vòng lặp vô hướng trên mảng Vec2 so với các kernel SoA
+inline void segmentDistance() {
+    const size_t N = 1000000;
+    const int QUERIES = 16;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+    // Đầu vào float sẵn để so sánh bit-exact với kernel (Vec2 là double)
+    struct PointF { float x, y; };
+    std::vector<PointF> poly(N + 1);
+    poly[0] = {0.0f, 0.0f};
+    for (size_t i = 1; i <= N; ++i) poly[i] = {poly[i - 1].x + step(rng), poly[i - 1].y + step(rng)};
+    SegmentChain chain;
+    chain.reserve(poly.size());
+    for (const PointF &v : poly) chain.push({v.x, v.y});
+    std::vector<PointF> queries(QUERIES);
+    for (PointF &q : queries) q = {step(rng) * 500.0f, step(rng) * 500.0f};
+
+    std::printf("== Point-to-segment distance, %zu segments, %d queries ==\n", N, QUERIES);
+
+    std::vector<SegmentHit> reference(QUERIES);
+    double aos = timeMs(5, [&] {
+        for (int q = 0; q < QUERIES; ++q) {
+            float best = INFINITY;
+            size_t bestIdx = 0;
+            PointF p = queries[q];
+            for (size_t i = 0; i < N; ++i) {
+                PointF a = poly[i], b = poly[i + 1];
+                float abx = b.x - a.x, aby = b.y - a.y;
+                float l2 = abx * abx + aby * aby;
+                float t = (l2 > 0.0f) ? ((p.x - a.x) * abx + (p.y - a.y) * aby) / l2 : 0.0f;
+                t = std::max(0.0f, std::min(1.0f, t));
+                float dx = (a.x + t * abx) - p.x, dy = (a.y + t * aby) - p.y;
+                float d = dx * dx + dy * dy;
+                if (d < best) { best = d; bestIdx = i; }
+            }
+            reference[q] = {std::sqrt(best), bestIdx};
+        }
+    });
+    std::printf("  %-14s %9.3f ms/query\n", "scalar (AoS)", aos / QUERIES);
+
+    segsimd::Level best = segsimd::detectLevel();
+    for (int lv = segsimd::LEVEL_SCALAR; lv <= best; ++lv) {
+        segsimd::Level level = (segsimd::Level)lv;
+        size_t mismatches = 0;
+        double ms = timeMs(5, [&] {
+            mismatches = 0;
+            for (int q = 0; q < QUERIES; ++q) {
+                SegmentHit h = segsimd::nearest(level, chain.x.data(), chain.y.data(), chain.segments(), queries[q].x, queries[q].y);
+                if (h.index != reference[q].index || h.dist != reference[q].dist) ++mismatches;
+            }
+        });
+        std::printf("  %-14s %9.3f ms/query  x%.2f  mismatches %zu\n", segsimd::levelName(level), ms / QUERIES, aos / ms, mismatches);
+    }
+}
+
+// Tessellation tròn/ellipse/hyperbola: cosf/sinf/coshf/sinhf mỗi mẫu so với kernel SIMD.
+// Sai số đo so với tham chiếu double, chia cho bán kính (ellipse) hoặc a*cosh(tMax) (hyperbola).
+inline void conicTessellation() {
+    const int SEGMENTS = 4096, SHAPES = 256;
+    const VertexColor white = packColor(1.0f, 1.0f, 1.0f);
+    const conic::NdcTransform identity = {1.0f, 0.0f, 1.0f, 0.0f};
+    const float a = 37.0f, b = 21.0f, angle = 0.6f, cx = 12.5f, cy = -7.25f;
+    std::vector<Vertex> verts(SEGMENTS + 1);
+    std::printf("== Conic tessellation, %d samples x %d shapes ==\n", SEGMENTS, SHAPES);
+
+    auto report = [&](const char *name, double refMs, double ms) {
+        double samples = (double)SEGMENTS * SHAPES;
+        std::printf("  %-22s %8.1f Msamples/s (baseline %.1f)  x%.2f\n", name, samples / ms / 1e3, samples / refMs / 1e3, refMs / ms);
+    };
+
+    // Ellipse
+    double ref = timeMs(5, [&] {
+        for (int k = 0; k < SHAPES; ++k) conic::ellipseScalar(verts.data(), identity, cx, cy, a, b, angle, SEGMENTS, white);
+    });
+    double simd = timeMs(5, [&] {
+        for (int k = 0; k < SHAPES; ++k) conic::tessellateEllipse(verts.data(), identity, cx, cy, a, b, angle, SEGMENTS, white);
+    });
+    double maxErr = 0.0;
+    for (int i = 0; i < SEGMENTS; ++i) {
+        double t = 2.0 * 3.14159265358979323846 * i / SEGMENTS;
+        double x = a * std::cos(t), y = b * std::sin(t);
+        double ex = cx + x * std::cos((double)angle) - y * std::sin((double)angle);
+        double ey = cy + x * std::sin((double)angle) + y * std::cos((double)angle);
+        const Vertex &v = verts[i];
+        maxErr = std::max(maxErr, std::hypot(v.x - ex, v.y - ey) / a);
+    }
+    report("ellipse (rotation)", ref, simd);
+    std::printf("  %-22s max error %.2e * radius (bound %.2e)\n", "", maxErr, 3.0 * conic::RESEED / 16777216.0);
+
+    // Hyperbola (một nhánh)
+    const float tMax = 7.0f;
+    ref = timeMs(5, [&] {
+        for (int k = 0; k < SHAPES; ++k) {
+            for (int i = 0; i <= SEGMENTS; ++i) {
+                float t = -tMax + (float)i * (2.0f * tMax / (float)SEGMENTS);
+                conic::writeVertex(&verts[i], cx + a * coshf(t), cy + b * sinhf(t), white);
+            }
+        }
+    });
+    simd = timeMs(5, [&] {
+        for (int k = 0; k < SHAPES; ++k) conic::tessellateHyperbolaBranch(verts.data(), identity, cx, cy, a, b, false, 1.0f, tMax, SEGMENTS, white);
+    });
+    maxErr = 0.0;
+    for (int i = 0; i <= SEGMENTS; ++i) {
+        double t = -tMax + (double)(float)i * (double)(2.0f * tMax / (float)SEGMENTS);
+        const Vertex &v = verts[i];
+        maxErr = std::max(maxErr, std::hypot(v.x - (cx + a * std::cosh(t)), v.y - (cy + b * std::sinh(t))));
+    }
+    report("hyperbola (exp)", ref, simd);
+    std::printf("  %-22s max error %.2e * a*cosh(tMax)\n", "", maxErr / (a * std::cosh((double)tMax)));
+}
+
+// Vị từ: float thuần (không bền vững) so với bộ lọc + fallback chính xác, trên điểm ngẫu nhiên
+// (bộ lọc quyết định được gần như mọi lần) và điểm thẳng hàng/đồng viên (luôn rơi vào nhánh chính xác)
+inline void predicates() {
+    const size_t N = 1 << 20;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    std::vector<Vec2> pts(N + 3);
+    for (Vec2 &p : pts) p = {coord(rng), coord(rng)};
+    // Điểm nguyên thẳng hàng / đồng viên (tọa độ nguyên, trên đường chéo và đường tròn bán kính 5)
+    std::vector<Vec2> line(N + 3), circle(N + 3);
+    const Vec2 ring[4] = {{5, 0}, {0, 5}, {-5, 0}, {0, -5}};
+    for (size_t i = 0; i < line.size(); ++i) {
+        float k = (float)(i % 2048);
+        line[i] = {k, 3.0f * k + 1.0f};
+        circle[i] = {ring[i % 4].x + 1000.0f, ring[i % 4].y - 1000.0f};
+    }
+    std::printf("== Predicates, %zu calls ==\n", N);
+
+    auto run = [&](const char *name, const std::vector<Vec2> &in, auto fn) {
+        long long acc = 0;
+        double ms = timeMs(3, [&] {
+            acc = 0;
+            for (size_t i = 0; i < N; ++i) acc += fn(&in[i]);
+        });
+        std::printf("  %-34s %7.2f ns/call  (checksum %lld)\n", name, ms * 1e6 / N, acc);
+    };
+    auto orientFloat = [](const Vec2 *p) {
+        float x0 = (float)p[0].x, y0 = (float)p[0].y, x1 = (float)p[1].x, y1 = (float)p[1].y;
+        float x2 = (float)p[2].x, y2 = (float)p[2].y;
+        float det = (x0 - x2) * (y1 - y2) - (y0 - y2) * (x1 - x2);
+        return (det > 0.0f) - (det < 0.0f);
+    };
+    auto orientFiltered = [](const Vec2 *p) { return pred::orient2d(p[0], p[1], p[2]); };
+    auto orientExact = [](const Vec2 *p) { return pred::crossSignExact(p[2], p[0], p[2], p[1]); };
+    auto incircleFiltered = [](const Vec2 *p) { return pred::incircle(p[0], p[1], p[2], p[3]); };
+    auto incircleExact = [](const Vec2 *p) { return pred::incircleExact(p[0], p[1], p[2], p[3]); };
+
+    run("orient2d float (not robust)", pts, orientFloat);
+    run("orient2d filtered, random", pts, orientFiltered);
+    run("orient2d exact only, random", pts, orientExact);
+    run("orient2d filtered, collinear", line, orientFiltered);
+    run("incircle filtered, random", pts, incircleFiltered);
+    run("incircle exact only, random", pts, incircleExact);
+    run("incircle filtered, cocircular", circle, incircleFiltered);
+}
+
+// Mọi giao điểm: đường quét Bentley–Ottmann so với thử từng cặp (có loại nhanh bằng hộp bao).
+// Brute force chỉ chạy 1 lần vì là O(n^2); hai cách phải cho đúng cùng danh sách giao điểm.
+inline void intersections() {
+    auto runCase = [](const char *name, const isect::Scene &scene) {
+        std::vector<IntersectionHit> fast, slow;
+        double sweepMs = timeMs(1, [&] { fast = isect::sweep(scene); });
+        auto t0 = std::chrono::steady_clock::now();
+        slow = isect::bruteForce(scene);
+        double bruteMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        size_t mismatches = std::max(fast.size(), slow.size()) - std::min(fast.size(), slow.size());
+        for (size_t i = 0; i < std::min(fast.size(), slow.size()); ++i) {
+            const IntersectionHit &a = fast[i], &b = slow[i];
+            if (a.shapeA != b.shapeA || a.shapeB != b.shapeB || a.p.x != b.p.x || a.p.y != b.p.y) ++mismatches;
+        }
+        std::printf("  %-26s %zu curves, %zu hits: sweep %9.1f ms, brute force %9.1f ms  x%.1f  mismatches %zu\n",
+                    name, scene.size(), fast.size(), sweepMs, bruteMs, bruteMs / sweepMs, mismatches);
+    };
+    std::printf("== All intersections ==\n");
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coord(0.0, 1000.0), delta(-4.0, 4.0), radius(0.5, 10.0);
+    isect::Scene segments;
+    for (int i = 0; i < 100000; ++i) {
+        Vec2 a = {coord(rng), coord(rng)};
+        segments.addSegment(a, {a.x + delta(rng), a.y + delta(rng)}, i);
+    }
+    runCase("100k random segments", segments);
+
+    // Trộn: đoạn, đường tròn, vài đường thẳng/tia cắt ngang toàn bộ
+    isect::Scene mixed;
+    int id = 0;
+    for (int i = 0; i < 20000; ++i, ++id) {
+        Vec2 a = {coord(rng), coord(rng)};
+        mixed.addSegment(a, {a.x + delta(rng), a.y + delta(rng)}, id);
+    }
+    for (int i = 0; i < 5000; ++i, ++id) mixed.addCircle({coord(rng), coord(rng)}, radius(rng), id);
+    for (int i = 0; i < 8; ++i, ++id) {
+        Vec2 a = {coord(rng), coord(rng)}, b = {coord(rng), coord(rng)};
+        if (i % 2) mixed.addRay(a, b, id);
+        else mixed.addLine(a, b, id);
+    }
+    runCase("segments + circles + lines", mixed);
+}
+
+// Tập điểm 1M: tuần tự (1 luồng) so với chia để trị song song. Kiểm tra chéo hai kết quả,
+// Delaunay kiểm tra thêm công thức Euler: số cạnh = 3n - 3 - h (điểm ở vị trí tổng quát).
+inline void pointSets() {
+    const size_t N = 1000000;
+    const int threads = pset::defaultThreads();
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+    std::vector<Vec2> pts(N);
+    for (Vec2 &p : pts) p = {coord(rng), coord(rng)};
+    std::printf("== Point sets, %zu points, %d threads ==\n", N, threads);
+
+    auto report = [](const char *name, double serial, double parallel, const char *check) {
+        std::printf("  %-16s serial %8.1f ms, parallel %8.1f ms  x%.2f  %s\n", name, serial, parallel, serial / parallel, check);
+    };
+
+    std::vector<int> hull1, hullT;
+    double s = timeMs(3, [&] { hull1 = pset::convexHull(pts, 1); });
+    double p = timeMs(3, [&] { hullT = pset::convexHull(pts, threads); });
+    report("convex hull", s, p, hull1.size() == hullT.size() ? "same" : "MISMATCH");
+
+    pset::ClosestPair cp1, cpT;
+    s = timeMs(3, [&] { cp1 = pset::closestPair(pts, 1); });
+    p = timeMs(3, [&] { cpT = pset::closestPair(pts, threads); });
+    report("closest pair", s, p, cp1.dist == cpT.dist ? "same" : "MISMATCH");
+
+    size_t edges1 = 0, edgesT = 0;
+    s = timeMs(1, [&] {
+        pset::DelaunayMesh mesh;
+        mesh.build(pts, 1);
+        edges1 = mesh.edges().size();
+    });
+    pset::DelaunayMesh mesh;
+    p = timeMs(1, [&] { mesh.build(pts, threads); });
+    edgesT = mesh.edges().size();
+    bool euler = edgesT == 3 * mesh.pointCount() - 3 - hullT.size();
+    report("delaunay", s, p, edges1 == edgesT && euler ? "same, Euler ok" : "MISMATCH");
+
+    pset::VoronoiDiagram vor;
+    double v = timeMs(1, [&] { vor = mesh.voronoi(); });
+    std::printf("  %-16s %8.1f ms from mesh: %zu vertices, %zu edges, %zu rays\n", "voronoi", v, vor.vertices.size(), vor.edges.size(), vor.rays.size());
+}
+
+// Khung chọn trên 200k hộp: dựng chỉ mục 1 lần rồi truy vấn nhiều khung (như khi kéo chuột)
+// so với duyệt tuyến tính từng hình. Kiểm tra cùng số hình được chọn.
+inline void selection() {
+    const size_t N = 200000;
+    const int QUERIES = 200;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> coord(-1000.0, 1000.0), size(0.0, 4.0);
+    std::vector<SceneIndex::Box> boxes(N);
+    for (SceneIndex::Box &b : boxes) {
+        double x = coord(rng), y = coord(rng);
+        b = {x, y, x + size(rng), y + size(rng)};
+    }
+    std::vector<SceneIndex::Box> queries(QUERIES);
+    for (SceneIndex::Box &q : queries) {
+        double x = coord(rng), y = coord(rng), w = 4.0 * size(rng) * size(rng) * size(rng);
+        q = {x, y, x + w, y + w};
+    }
+    std::printf("== Box selection, %zu shapes, %d queries ==\n", N, QUERIES);
+
+    SceneIndex index;
+    double build = timeMs(3, [&] { index.build(boxes); });
+    size_t hitsLinear = 0, hitsIndex = 0;
+    double linear = timeMs(3, [&] {
+        hitsLinear = 0;
+        for (const SceneIndex::Box &q : queries)
+            for (const SceneIndex::Box &b : boxes) hitsLinear += q.contains(b);
+    });
+    double indexed = timeMs(3, [&] {
+        hitsIndex = 0;
+        for (const SceneIndex::Box &q : queries) index.forEachInside(q, [&](uint32_t) { ++hitsIndex; });
+    });
+    std::printf("  build %.2f ms, linear %.2f ms/query, index %.4f ms/query  x%.0f  hits %zu %s\n", build,
+                linear / QUERIES, indexed / QUERIES, linear / indexed, hitsIndex, hitsIndex == hitsLinear ? "same" : "MISMATCH");
+}
+
+} // namespace bench
+
+inline int runBenchmarks() {
+    bench::segmentDistance();
+    bench::conicTessellation();
+    bench::predicates();
+    bench::intersections();
+    bench::pointSets();
+    bench::selection();
+    return 0;
+}
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,175 @@
+#ifndef CONIC_SIMD_H
+#define CONIC_SIMD_H
+
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "vertex.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CONIC_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Kernel lấy mẫu đường conic cho tessellation, ghi thẳng ra mảng đỉnh của GeometryRenderer.
+// - Tròn/ellipse: không gọi cosf/sinf mỗi mẫu mà quay dần (nhân số phức với e^{i*W*dt}),
+//   4 làn SSE2 chạy song song; cứ RESEED bước lại tính chính xác bằng cosf/sinf để chặn sai số tích lũy.
+//   Mỗi bước quay sai tối đa ~3 ulp (góc + độ dài) nên sai số <= 3 * RESEED * 2^-24 * bán kính
+//   (~2.9e-6 * bán kính, nhỏ hơn nhiều so với 1 pixel).
+// - Hyperbola: cosh/sinh tính từ exp(t) vectơ hóa (đa thức Cephes, sai ~2 ulp),
+//   cosh = (e + 1/e)/2, sinh = (e - 1/e)/2; sai số tuyệt đối <= ~4 ulp * cosh(t).
+namespace conic {
+
+const int RESEED = 16;
+
+// Phép biến đổi tọa độ (đã rebase theo camera) -> NDC: nx = x * sx + ox
+struct NdcTransform {
+    float sx, ox, sy, oy;
+};
+
+inline void writeVertex(Vertex *out, float nx, float ny, VertexColor color) {
+    out->x = nx;
+    out->y = ny;
+    out->color = color;
+}
+
+// Bản vô hướng (tham chiếu, dùng khi không có SSE2)
+inline void ellipseScalar(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                          float angleRad, int segments, VertexColor color) {
+    float cosA = cosf(angleRad), sinA = sinf(angleRad);
+    for (int i = 0; i < segments; ++i) {
+        float t = 2.0f * 3.14159265358979323846f * float(i) / float(segments);
+        float x = a * cosf(t), y = b * sinf(t);
+        float xr = x * cosA - y * sinA + cx;
+        float yr = x * sinA + y * cosA + cy;
+        writeVertex(out + i, xr * ndc.sx + ndc.ox, yr * ndc.sy + ndc.oy, color);
+    }
+}
+
+inline void hyperbolaScalar(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                            bool isVertical, float sign, float tMax, int segs, VertexColor color) {
+    for (int i = 0; i <= segs; ++i) {
+        float t = -tMax + (float)i * (2.0f * tMax / (float)segs);
+        float e = expf(t), ie = 1.0f / e;
+        float ch = 0.5f * (e + ie), sh = 0.5f * (e - ie);
+        float x = isVertical ? a * sh : sign * a * ch;
+        float y = isVertical ? sign * b * ch : b * sh;
+        writeVertex(out + i, (cx + x) * ndc.sx + ndc.ox, (cy + y) * ndc.sy + ndc.oy, color);
+    }
+}
+
+#ifdef CONIC_SIMD_SSE2
+
+// Ghi n (<= 4) đỉnh từ các làn nx, ny
+inline void storeLanes(Vertex *out, __m128 nx, __m128 ny, int n, VertexColor color) {
+    alignas(16) float xs[4], ys[4];
+    _mm_store_ps(xs, nx);
+    _mm_store_ps(ys, ny);
+    for (int k = 0; k < n; ++k) writeVertex(out + k, xs[k], ys[k], color);
+}
+
+inline void ellipseSSE2(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                        float angleRad, int segments, VertexColor color) {
+    const int W = 4;
+    float cosA = cosf(angleRad), sinA = sinf(angleRad);
+    double step = 2.0 * 3.14159265358979323846 / segments;
+    __m128 rc = _mm_set1_ps((float)std::cos(W * step)), rs = _mm_set1_ps((float)std::sin(W * step));
+    __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b);
+    __m128 vCosA = _mm_set1_ps(cosA), vSinA = _mm_set1_ps(sinA);
+    __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+    __m128 sx = _mm_set1_ps(ndc.sx), ox = _mm_set1_ps(ndc.ox), sy = _mm_set1_ps(ndc.sy), oy = _mm_set1_ps(ndc.oy);
+    __m128 c = _mm_setzero_ps(), s = _mm_setzero_ps();
+    for (int i = 0, blk = 0; i < segments; i += W, ++blk) {
+        if (blk % RESEED == 0) {
+            alignas(16) float cs[4], ss[4];
+            for (int k = 0; k < W; ++k) {
+                float t = 2.0f * 3.14159265358979323846f * float(i + k) / float(segments);
+                cs[k] = cosf(t);
+                ss[k] = sinf(t);
+            }
+            c = _mm_load_ps(cs);
+            s = _mm_load_ps(ss);
+        } else {
+            __m128 nc = _mm_sub_ps(_mm_mul_ps(c, rc), _mm_mul_ps(s, rs));
+            s = _mm_add_ps(_mm_mul_ps(s, rc), _mm_mul_ps(c, rs));
+            c = nc;
+        }
+        __m128 x = _mm_mul_ps(va, c), y = _mm_mul_ps(vb, s);
+        __m128 xr = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(x, vCosA), _mm_mul_ps(y, vSinA)), vcx);
+        __m128 yr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, vSinA), _mm_mul_ps(y, vCosA)), vcy);
+        __m128 nx = _mm_add_ps(_mm_mul_ps(xr, sx), ox);
+        __m128 ny = _mm_add_ps(_mm_mul_ps(yr, sy), oy);
+        storeLanes(out + i, nx, ny, std::min(W, segments - i), color);
+    }
+}
+
+// exp(x) cho |x| < 88: x = n*ln2 + r, exp(r) bằng đa thức bậc 6, 2^n dựng trực tiếp từ số mũ
+inline __m128 expSSE2(__m128 x) {
+    const __m128 log2e = _mm_set1_ps(1.44269504088896341f);
+    const __m128 ln2Hi = _mm_set1_ps(0.693359375f), ln2Lo = _mm_set1_ps(-2.12194440e-4f);
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, log2e)); // Làm tròn tới số nguyên gần nhất
+    __m128 fn = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fn, ln2Hi)), _mm_mul_ps(fn, ln2Lo));
+    __m128 p = _mm_set1_ps(1.9875691500e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1f));
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), r), _mm_set1_ps(1.0f));
+    __m128i pow2n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(pow2n));
+}
+
+inline void hyperbolaSSE2(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                          bool isVertical, float sign, float tMax, int segs, VertexColor color) {
+    const int W = 4;
+    int count = segs + 1;
+    float dt = 2.0f * tMax / (float)segs;
+    __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.0f);
+    __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    // Hệ số của cosh và sinh trên từng trục
+    __m128 kx = _mm_set1_ps(isVertical ? a : sign * a), ky = _mm_set1_ps(isVertical ? sign * b : b);
+    __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+    __m128 sx = _mm_set1_ps(ndc.sx), ox = _mm_set1_ps(ndc.ox), sy = _mm_set1_ps(ndc.sy), oy = _mm_set1_ps(ndc.oy);
+    for (int i = 0; i < count; i += W) {
+        // t = -tMax + i * dt, giống hệt bản vô hướng
+        __m128 idx = _mm_add_ps(_mm_set1_ps((float)i), lane);
+        __m128 t = _mm_add_ps(_mm_set1_ps(-tMax), _mm_mul_ps(idx, _mm_set1_ps(dt)));
+        __m128 e = expSSE2(t), ie = _mm_div_ps(one, e);
+        __m128 ch = _mm_mul_ps(half, _mm_add_ps(e, ie));
+        __m128 sh = _mm_mul_ps(half, _mm_sub_ps(e, ie));
+        __m128 x = _mm_mul_ps(kx, isVertical ? sh : ch);
+        __m128 y = _mm_mul_ps(ky, isVertical ? ch : sh);
+        __m128 nx = _mm_add_ps(_mm_mul_ps(_mm_add_ps(vcx, x), sx), ox);
+        __m128 ny = _mm_add_ps(_mm_mul_ps(_mm_add_ps(vcy, y), sy), oy);
+        storeLanes(out + i, nx, ny, std::min(W, count - i), color);
+    }
+}
+
+#endif // CONIC_SIMD_SSE2
+
+// Ghi segments đỉnh của ellipse (tâm c, bán trục a/b, quay angleRad); tròn: a = b, angle = 0
+inline void tessellateEllipse(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                              float angleRad, int segments, VertexColor color) {
+#ifdef CONIC_SIMD_SSE2
+    ellipseSSE2(out, ndc, cx, cy, a, b, angleRad, segments, color);
+#else
+    ellipseScalar(out, ndc, cx, cy, a, b, angleRad, segments, color);
+#endif
+}
+
+// Ghi segs + 1 đỉnh của một nhánh hyperbola, t chạy đều trong [-tMax, tMax]
+inline void tessellateHyperbolaBranch(Vertex *out, const NdcTransform &ndc, float cx, float cy, float a, float b,
+                                      bool isVertical, float sign, float tMax, int segs, VertexColor color) {
+#ifdef CONIC_SIMD_SSE2
+    hyperbolaSSE2(out, ndc, cx, cy, a, b, isVertical, sign, tMax, segs, color);
+#else
+    hyperbolaScalar(out, ndc, cx, cy, a, b, isVertical, sign, tMax, segs, color);
+#endif
+}
+
+} // namespace conic
+
+#endif // CONIC_SIMD_H
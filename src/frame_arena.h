@@ -0,0 +1,85 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+
+// Bộ cấp phát tuyến tính cho dữ liệu tạm trong 1 frame (điểm tessellation, đỉnh chờ upload...).
+// alloc chỉ tăng con trỏ; reset() đầu mỗi frame thu hồi tất cả cùng lúc.
+// Nếu frame dùng vượt block hiện có thì cấp thêm block; lần reset sau gộp lại thành 1 block
+// đủ lớn, nên ở trạng thái ổn định một frame không cấp phát heap lần nào.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialBytes = 1 << 20) {
+        blocks.reserve(16);
+        addBlock(initialBytes);
+    }
+
+    ~FrameArena() {
+        for (Block &bl : blocks) std::free(bl.data);
+    }
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // Vùng nhớ chưa khởi tạo cho count phần tử T; chỉ dùng cho kiểu không cần hủy
+    template <typename T>
+    T *alloc(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena không gọi destructor");
+        return static_cast<T *>(allocBytes(count * sizeof(T), alignof(T)));
+    }
+
+    void reset() {
+        if (blocks.size() > 1) {
+            size_t total = 0;
+            for (Block &bl : blocks) {
+                total += bl.size;
+                std::free(bl.data);
+            }
+            blocks.clear();
+            addBlock(total);
+        }
+        used = 0;
+        frameBytes = 0;
+    }
+
+    size_t bytesUsed() const { return frameBytes; }
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block &bl : blocks) total += bl.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+    std::vector<Block> blocks; // blocks.back() là block đang cấp phát
+    size_t used = 0;           // Số byte đã dùng trong block cuối
+    size_t frameBytes = 0;     // Tổng byte đã cấp trong frame
+
+    void addBlock(size_t size) {
+        char *data = static_cast<char *>(std::malloc(size));
+        if (!data) std::abort();
+        blocks.push_back({data, size});
+        used = 0;
+    }
+
+    void *allocBytes(size_t bytes, size_t align) {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (offset + bytes > blocks.back().size) {
+            // Block mới ít nhất gấp đôi block trước
+            addBlock(std::max(bytes + align, blocks.back().size * 2));
+            offset = 0;
+        }
+        used = offset + bytes;
+        frameBytes += bytes;
+        return blocks.back().data + offset;
+    }
+};
+
+#endif // FRAME_ARENA_H
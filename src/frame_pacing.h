@@ -0,0 +1,120 @@
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+// Chiến lược nhịp frame
+enum PacingMode {
+    PACE_VSYNC = 0,  // Swap interval 1: đọc input ngay sau vblank, khung hình hiện ở vblank kế tiếp
+    PACE_LATE_LATCH, // Vsync, nhưng ngủ tới sát vblank kế tiếp (trừ thời gian vẽ ước lượng) rồi mới đọc input
+    PACE_UNCAPPED,   // Swap interval 0: vẽ liên tục, không chờ vblank (có thể xé hình)
+    PACE_COUNT
+};
+
+// Đo độ trễ input -> hình: mỗi sự kiện input được đóng dấu thời gian trong callback; frame đầu tiên
+// đọc input sau thời điểm đó được coi là frame phản ánh nó. Độ trễ = lúc frame đó swap xong
+// (kèm glFinish khi đo, nên đã gồm cả thời gian GPU) - lúc nhận sự kiện sớm nhất mà frame phản ánh.
+// Thời điểm ánh sáng thật sự ra khỏi màn hình còn thêm độ trễ quét/hiển thị của màn hình, không đo được bằng phần mềm.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    static const size_t SAMPLES = 512; // Số mẫu độ trễ gần nhất dùng tính phân vị
+
+    struct LatencyStats {
+        size_t samples = 0;
+        double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0; // ms
+        double framePeriod = 0.0;                          // ms, khoảng cách trung bình giữa các lần swap
+        double renderTime = 0.0;                           // ms, thời gian vẽ ước lượng (dùng cho late latch)
+    };
+
+    // Gọi trong callback input: chỉ giữ sự kiện SỚM NHẤT chưa được frame nào phản ánh
+    void onInput() {
+        if (!inputPending) {
+            inputPending = true;
+            pendingInput = Clock::now();
+        }
+    }
+
+    // Late latch: ngủ tới (lần swap trước + chu kỳ frame - thời gian vẽ - khoảng dự phòng)
+    void waitForLatch() {
+        if (framePeriodMs <= 0.0) return;
+        double budget = renderMs + MARGIN_MS;
+        Clock::time_point target = lastSwap + toDuration(framePeriodMs - budget);
+        if (target > Clock::now()) std::this_thread::sleep_until(target);
+    }
+
+    // Ngay sau khi đọc xong input của frame: input chờ từ trước đó thuộc về frame này
+    void latchInput() {
+        frameStart = Clock::now();
+        frameHasInput = inputPending;
+        frameInput = pendingInput;
+        inputPending = false;
+    }
+
+    // Trước khi swap: lượng thời gian vẽ CPU (trung bình trượt, ưu tiên giá trị lớn để late latch không trễ vblank)
+    void beforeSwap() {
+        double ms = msBetween(frameStart, Clock::now());
+        renderMs = (ms > renderMs) ? ms : renderMs * 0.95 + ms * 0.05;
+    }
+
+    // Sau khi swap (và glFinish nếu đang đo) xong
+    void afterSwap(bool measure) {
+        Clock::time_point now = Clock::now();
+        double period = msBetween(lastSwap, now);
+        // Bỏ các khoảng nghỉ dài (vẽ theo yêu cầu đang ngủ) khỏi ước lượng chu kỳ frame
+        if (period > 0.0 && period < 100.0)
+            framePeriodMs = (framePeriodMs <= 0.0) ? period : framePeriodMs * 0.9 + period * 0.1;
+        lastSwap = now;
+        if (!measure || !frameHasInput) return;
+        frameHasInput = false;
+        if (samples.size() < SAMPLES) samples.push_back(msBetween(frameInput, now));
+        else samples[next] = msBetween(frameInput, now);
+        next = (next + 1) % SAMPLES;
+    }
+
+    void reset() {
+        samples.clear();
+        next = 0;
+    }
+
+    LatencyStats stats() {
+        LatencyStats st;
+        st.samples = samples.size();
+        st.framePeriod = framePeriodMs;
+        st.renderTime = renderMs;
+        if (samples.empty()) return st;
+        sorted.assign(samples.begin(), samples.end());
+        std::sort(sorted.begin(), sorted.end());
+        auto pct = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+        st.p50 = pct(0.50);
+        st.p90 = pct(0.90);
+        st.p99 = pct(0.99);
+        st.max = sorted.back();
+        return st;
+    }
+
+private:
+    static constexpr double MARGIN_MS = 1.5; // Dự phòng cho sai số đồng hồ ngủ của hệ điều hành
+
+    bool inputPending = false;
+    bool frameHasInput = false;
+    Clock::time_point pendingInput, frameInput, frameStart, lastSwap;
+    double framePeriodMs = 0.0;
+    double renderMs = 0.0;
+    std::vector<double> samples;
+    std::vector<double> sorted; // Bộ đệm dùng lại khi tính phân vị (không cấp phát mỗi frame)
+    size_t next = 0;
+
+    static double msBetween(Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    }
+    static Clock::duration toDuration(double ms) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    }
+};
+
+#endif // FRAME_PACING_H
@@ -3,20 +3,41 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <map>
 #include <string>
+#include <cstddef>
 #include <glad/glad.h>
 #include "shader.h"
+#include "vertex.h"
+#include "conic_simd.h"
+#include "frame_arena.h"
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 #include "imgui_impl_glfw.h"
 
-struct Vec2 { float x, y; };
+// Tọa độ World dùng double để zoom rất sâu (~10^12 lần) không bị rung;
+// khi đưa lên GPU mọi tọa độ được trừ đi tâm camera (bằng double) rồi mới đổi sang float.
+struct Vec2 { double x, y; };
 struct Color { float r, g, b; };
 
+// Bộ đếm rẻ, luôn bật, được reset mỗi frame
+struct RenderStats {
+    size_t verticesGenerated = 0; // Số đỉnh sinh ra trong buildVertexBuffer
+    size_t bytesUploaded = 0;     // Số byte đẩy lên VBO
+    size_t drawCalls = 0;         // Số lần glDrawArrays
+    size_t arenaBytes = 0;        // Bộ nhớ tạm lấy từ FrameArena
+};
+
+// Đỉnh của quad vẽ conic bằng shader giải tích: vị trí NDC + tọa độ trong hệ riêng của conic (pixel)
+struct ConicVertex {
+    float x, y;
+    float u, v;
+};
+
 class GeometryRenderer {
 public:
-    GeometryRenderer(Shader &shader, float left = -1.0f, float right = 1.0f, float bottom = -1.0f, float top = 1.0f)
+    GeometryRenderer(Shader &shader, double left = -1.0, double right = 1.0, double bottom = -1.0, double top = 1.0)
         : shader(shader), left(left), right(right), bottom(bottom), top(top)
     {
         glGenVertexArrays(1, &VAO);
@@ -24,9 +45,21 @@ public:
 
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        // Vertex: 2 float vị trí + 4 byte màu (GL chuẩn hóa về [0,1])
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+        glEnableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        glGenVertexArrays(1, &conicVAO);
+        glGenBuffers(1, &conicVBO);
+        glBindVertexArray(conicVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, conicVBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ConicVertex), (void*)offsetof(ConicVertex, x));
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ConicVertex), (void*)offsetof(ConicVertex, u));
         glEnableVertexAttribArray(1);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
@@ -35,66 +68,112 @@ public:
     ~GeometryRenderer() {
         glDeleteBuffers(1, &VBO);
         glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &conicVBO);
+        glDeleteVertexArrays(1, &conicVAO);
     }
 
-    void setView(float l, float r, float b, float t) {
+    // Shader vẽ conic giải tích (shaders/conic_*.glsl); nullptr hoặc shader lỗi -> luôn chia đoạn như cũ
+    void setConicShader(Shader *s) {
+        GLint linked = 0;
+        if (s) glGetProgramiv(s->ID, GL_LINK_STATUS, &linked);
+        conicShader = linked ? s : nullptr;
+        if (!conicShader) return;
+        uQuad = glGetUniformLocation(s->ID, "u_quad");
+        uLinear = glGetUniformLocation(s->ID, "u_linear");
+        uConst = glGetUniformLocation(s->ID, "u_const");
+        uColor = glGetUniformLocation(s->ID, "u_color");
+        uHalfWidth = glGetUniformLocation(s->ID, "u_halfWidth");
+    }
+    bool analyticConicsAvailable() const { return conicShader != nullptr; }
+    // Bật: đường tròn/elip/parabola/hyperbola vẽ bằng 1 quad + fragment shader, không chia đoạn
+    void setAnalyticConics(bool on) { analyticConics = on; }
+
+    void setView(double l, double r, double b, double t) {
         left = l; right = r; bottom = b; top = t;
     }
-    void getView(float &l, float &r, float &b, float &t) const {
+    void getView(double &l, double &r, double &b, double &t) const {
         l = left; r = right; b = bottom; t = top;
     }
 
+    // Kích thước framebuffer (pixel), cập nhật mỗi frame
+    void setViewportSize(int w, int h) { viewportW = w; viewportH = h; }
+    // Kích thước 1 pixel theo đơn vị World
+    double pixelSize() const { return (right - left) / (double)std::max(1, viewportW); }
+
+    const RenderStats &getStats() const { return stats; }
+    void resetStats() { stats = RenderStats(); }
+
+    // Gọi đầu mỗi frame: thu hồi toàn bộ bộ nhớ tạm của frame trước
+    void beginFrame() { arena.reset(); }
+    const FrameArena &frameArena() const { return arena; }
+
     void drawPoint(const Vec2 &p, const Color &c, float size = 5.0f) {
         shader.use();
         glPointSize(size);
-        auto verts = buildVertexBuffer({p}, c);
-        uploadAndDraw(verts, GL_POINTS);
+        uploadAndDraw(buildVertexBuffer(&p, 1, c), 1, GL_POINTS);
         glPointSize(1.0f);
     }
 
     void drawLine(const Vec2 &a, const Vec2 &b, const Color &c) {
         shader.use();
-        auto verts = buildVertexBuffer({a, b}, c);
-        uploadAndDraw(verts, GL_LINES);
+        const Vec2 pts[2] = { a, b };
+        uploadAndDraw(buildVertexBuffer(pts, 2, c), 2, GL_LINES);
     }
 
     void drawPolyline(const std::vector<Vec2> &pts, const Color &c) {
-        shader.use();
-        auto verts = buildVertexBuffer(pts, c);
-        uploadAndDraw(verts, GL_LINE_STRIP);
+        drawPolyline(pts.data(), pts.size(), c);
     }
 
-    void drawCircle(const Vec2 &center, float radius, const Color &c, int segments = 500) {
+    // Vẽ một đoạn liên tiếp của polyline (dùng khi chỉ vẽ các khúc nằm trong khung nhìn)
+    void drawPolyline(const Vec2 *pts, size_t count, const Color &c) {
         shader.use();
-        std::vector<Vec2> pts;
-        pts.reserve(segments);
-        for (int i = 0; i < segments; ++i) {
-            float theta = 2.0f * 3.14159265358979323846f * float(i) / float(segments);
-            pts.push_back({ center.x + radius * cosf(theta), center.y + radius * sinf(theta) });
-        }
-        auto verts = buildVertexBuffer(pts, c);
-        uploadAndDraw(verts, GL_LINE_LOOP);
+        uploadAndDraw(buildVertexBuffer(pts, count, c), count, GL_LINE_STRIP);
     }
 
-    void drawEllipse(const Vec2 &center, float a, float b, float angleRad, const Color &c, int segments = 500) {
-        shader.use();
-        std::vector<Vec2> pts; pts.reserve(segments);
-        float cosA = cosf(angleRad), sinA = sinf(angleRad);
-        for (int i = 0; i < segments; ++i) {
-            float t = 2.0f * 3.14159265358979323846f * float(i) / float(segments);
-            float x = a * cosf(t), y = b * sinf(t);
-            float xr = x * cosA - y * sinA;
-            float yr = x * sinA + y * cosA;
-            pts.push_back({ center.x + xr, center.y + yr });
+    void drawCircle(const Vec2 &center, double radius, const Color &c, int segments = 500) {
+        drawEllipse(center, radius, radius, 0.0f, c, segments);
+    }
+
+    void drawEllipse(const Vec2 &center, double a, double b, double angleRad, const Color &c, int segments = 500) {
+        if (useAnalyticConics() && a > 0.0 && b > 0.0) {
+            double cs = std::cos(angleRad), sn = std::sin(angleRad);
+            // Hộp bao của elip xoay
+            double ex = std::sqrt(a * a * cs * cs + b * b * sn * sn), ey = std::sqrt(a * a * sn * sn + b * b * cs * cs);
+            double pad = CONIC_PAD_PX * pixelSize();
+            drawConicQuad(CONIC_ELLIPSE, center, {cs, sn}, {-sn, cs}, a, b, c,
+                          center.x - ex - pad, center.y - ey - pad, center.x + ex + pad, center.y + ey + pad);
+            return;
         }
-        auto verts = buildVertexBuffer(pts, c);
-        uploadAndDraw(verts, GL_LINE_LOOP);
+        if (segments < 1) return;
+        shader.use();
+        // Kernel SIMD ghi thẳng ra mảng đỉnh, không qua mảng Vec2 trung gian
+        Vertex *verts = allocTemp<Vertex>(segments);
+        // Chỉ tâm được rebase bằng double (1 lần/hình); kernel chạy hoàn toàn bằng float
+        conic::tessellateEllipse(verts, ndcTransform(), cameraX(center.x), cameraY(center.y), (float)a, (float)b, (float)angleRad, segments, packColor(c.r, c.g, c.b));
+        stats.verticesGenerated += segments;
+        uploadAndDraw(verts, segments, GL_LINE_LOOP);
     }
 
-    void drawParabola(Vec2 vertex, float a, bool isVertical, float range, int segs, Color c) {
-        if (std::abs(a) < 1e-6f) return;
+    void drawParabola(Vec2 vertex, double a, bool isVertical, float range, int segs, Color c) {
+        if (std::abs(a) < 1e-6) return;
+        if (useAnalyticConics()) {
+            // Quad chỉ phủ phần trục có thể thấy: |X| <= R với R^2 = 4a * (mép khung nhìn phía bề lõm - đỉnh)
+            double pad = CONIC_PAD_PX * pixelSize();
+            double vx = isVertical ? vertex.x : vertex.y, vy = isVertical ? vertex.y : vertex.x;
+            double far = (a > 0.0) ? (isVertical ? top : right) + pad : (isVertical ? bottom : left) - pad;
+            double R2 = 4.0 * a * (far - vy);
+            if (R2 <= 0.0) return;
+            double R = std::sqrt(R2) + pad;
+            double y0 = std::min(vy, far) - pad, y1 = std::max(vy, far) + pad;
+            // Ngang: hệ riêng đổi vai x, y (x^2 = 4a*y với x = World y)
+            if (isVertical)
+                drawConicQuad(CONIC_PARABOLA, vertex, {1.0, 0.0}, {0.0, 1.0}, a, 0.0, c, vx - R, y0, vx + R, y1);
+            else
+                drawConicQuad(CONIC_PARABOLA, vertex, {0.0, 1.0}, {1.0, 0.0}, a, 0.0, c, y0, vx - R, y1, vx + R);
+            return;
+        }
         shader.use();
-        std::vector<Vec2> pts;
+        Vec2 *pts = allocTemp<Vec2>(segs + 1);
 
         for (int i = 0; i <= segs; ++i) {
             // Biến chuẩn hóa từ -1 đến 1
@@ -104,103 +183,109 @@ public:
             // Giúp các điểm tập trung cực nhiều ở gần Đỉnh (0,0)
             float t = (norm < 0 ? -1.0f : 1.0f) * (norm * norm) * range;
 
-            float x, y;
+            double x, y;
             if (isVertical) {
                 x = t;
-                y = (t * t) / (4.0f * a);
+                y = ((double)t * t) / (4.0 * a);
             } else {
                 y = t;
-                x = (t * t) / (4.0f * a);
+                x = ((double)t * t) / (4.0 * a);
             }
-            pts.push_back({ vertex.x + x, vertex.y + y });
+            pts[i] = { vertex.x + x, vertex.y + y };
         }
-        uploadAndDraw(buildVertexBuffer(pts, c), GL_LINE_STRIP);
+        uploadAndDraw(buildVertexBuffer(pts, segs + 1, c), segs + 1, GL_LINE_STRIP);
     }
 
-    void drawHyperbola(Vec2 center, float a, float b, bool isVertical, float range, int segs, Color c) {
-        if (std::abs(a) < 1e-6f || std::abs(b) < 1e-6f) return;
+    void drawHyperbola(Vec2 center, double a, double b, bool isVertical, float range, int segs, Color c) {
+        if (std::abs(a) < 1e-6 || std::abs(b) < 1e-6) return;
+        // Quad phủ cả khung nhìn (2 nhánh); dọc: hệ riêng đổi vai x, y để cùng dạng (x/a)^2 - (y/b)^2 = 1
+        if (useAnalyticConics()) {
+            if (isVertical)
+                drawConicQuad(CONIC_HYPERBOLA, center, {0.0, 1.0}, {1.0, 0.0}, b, a, c, left, bottom, right, top);
+            else
+                drawConicQuad(CONIC_HYPERBOLA, center, {1.0, 0.0}, {0.0, 1.0}, a, b, c, left, bottom, right, top);
+            return;
+        }
         shader.use();
 
         // Tính toán t_max để Hyperbola bao phủ được tầm nhìn hiện tại
         // Vì x = a * cosh(t), ta cần t sao cho a * cosh(t) > range
         // Một giá trị an toàn cho t_max dựa trên logarit của range/a
-        float t_max = std::acosh(std::max(1.0f, (range * 2.0f) / a));
+        float t_max = (float)std::acosh(std::max(1.0, (range * 2.0) / a));
         if (t_max > 7.0f) t_max = 7.0f; // Giới hạn t để tránh tràn số (cosh(7) ~ 500)
 
+        // Dọc:  y^2/b^2 - x^2/a^2 = 1 => y = +/- b*cosh(t), x = a*sinh(t)
+        // Ngang: x^2/a^2 - y^2/b^2 = 1 => x = +/- a*cosh(t), y = b*sinh(t)
+        VertexColor color = packColor(c.r, c.g, c.b);
+        Vertex *verts = allocTemp<Vertex>(segs + 1);
         auto drawBranch = [&](float sign) {
-            std::vector<Vec2> pts;
-            for (int i = 0; i <= segs; ++i) {
-                float t = -t_max + (float)i * (2.0f * t_max / (float)segs);
-                float x, y;
-                if (isVertical) {
-                    // y^2/b^2 - x^2/a^2 = 1 => y = +/- b*cosh(t), x = a*sinh(t)
-                    x = a * sinhf(t);
-                    y = sign * b * coshf(t);
-                } else {
-                    // x^2/a^2 - y^2/b^2 = 1 => x = +/- a*cosh(t), y = b*sinh(t)
-                    x = sign * a * coshf(t);
-                    y = b * sinhf(t);
-                }
-                pts.push_back({ center.x + x, center.y + y });
-            }
-            uploadAndDraw(buildVertexBuffer(pts, c), GL_LINE_STRIP);
+            conic::tessellateHyperbolaBranch(verts, ndcTransform(), cameraX(center.x), cameraY(center.y), (float)a, (float)b, isVertical, sign, t_max, segs, color);
+            stats.verticesGenerated += segs + 1;
+            uploadAndDraw(verts, segs + 1, GL_LINE_STRIP);
         };
 
         drawBranch(1.0f);  // Nhánh dương
         drawBranch(-1.0f); // Nhánh âm
     }
 
-    void drawGrid(float spacing, const Color &colorGrid, const Color &colorAxis, bool showGridLines, bool showAxisLines) {
+    void drawGrid(double spacing, const Color &colorGrid, const Color &colorAxis, bool showGridLines, bool showAxisLines) {
         shader.use();
 
         // 1. Vẽ lưới (Grid Lines)
         if (showGridLines) {
             glLineWidth(1.0f);
-            std::vector<Vec2> lines;
-            
+
             // Vẽ các đường dọc
-            float startX = std::floor(left / spacing) * spacing;
-            float endX = std::ceil(right / spacing) * spacing;
-            for (float x = startX; x <= endX; x += spacing) {
-                lines.push_back({ x, bottom });
-                lines.push_back({ x, top });
+            // Tọa độ đường lưới = k * spacing (k nguyên) để không tích lũy sai số khi zoom sâu
+            double startX = std::floor(left / spacing);
+            double endX = std::ceil(right / spacing);
+            size_t cap = 2 * ((size_t)(endX - startX) + 1);
+            Vec2 *lines = allocTemp<Vec2>(cap);
+            size_t n = 0;
+            for (double k = startX; k <= endX && n + 2 <= cap; k += 1.0) {
+                lines[n++] = { k * spacing, bottom };
+                lines[n++] = { k * spacing, top };
             }
-            uploadAndDraw(buildVertexBuffer(lines, colorGrid), GL_LINES);
-            lines.clear();
+            uploadAndDraw(buildVertexBuffer(lines, n, colorGrid), n, GL_LINES);
 
             // Vẽ các đường ngang
-            float startY = std::floor(bottom / spacing) * spacing;
-            float endY = std::ceil(top / spacing) * spacing;
-            for (float y = startY; y <= endY; y += spacing) {
-                lines.push_back({ left, y });
-                lines.push_back({ right, y });
+            double startY = std::floor(bottom / spacing);
+            double endY = std::ceil(top / spacing);
+            cap = 2 * ((size_t)(endY - startY) + 1);
+            lines = allocTemp<Vec2>(cap);
+            n = 0;
+            for (double k = startY; k <= endY && n + 2 <= cap; k += 1.0) {
+                lines[n++] = { left, k * spacing };
+                lines[n++] = { right, k * spacing };
             }
-            uploadAndDraw(buildVertexBuffer(lines, colorGrid), GL_LINES);
-            lines.clear();
+            uploadAndDraw(buildVertexBuffer(lines, n, colorGrid), n, GL_LINES);
         }
 
         // 2. Vẽ trục (Axis Lines)
         if (showAxisLines) {
             glLineWidth(3.5f); // Nét đậm cho trục
-            std::vector<Vec2> axisLines;
-            
+            Vec2 axisLines[4];
+            size_t n = 0;
+
             // Trục Y (x = 0)
-            if (left <= 0.0f && right >= 0.0f) {
-                axisLines.push_back({ 0.0f, bottom });
-                axisLines.push_back({ 0.0f, top });
+            if (left <= 0.0 && right >= 0.0) {
+                axisLines[n++] = { 0.0, bottom };
+                axisLines[n++] = { 0.0, top };
             }
             // Trục X (y = 0)
-            if (bottom <= 0.0f && top >= 0.0f) {
-                axisLines.push_back({ left, 0.0f });
-                axisLines.push_back({ right, 0.0f });
+            if (bottom <= 0.0 && top >= 0.0) {
+                axisLines[n++] = { left, 0.0 };
+                axisLines[n++] = { right, 0.0 };
             }
-            if (!axisLines.empty()) uploadAndDraw(buildVertexBuffer(axisLines, colorAxis), GL_LINES);
+            if (n > 0) uploadAndDraw(buildVertexBuffer(axisLines, n, colorAxis), n, GL_LINES);
             glLineWidth(1.0f); // Reset lại độ dày nét
         }
     }
 
-    void drawText(const std::string& text, float x, float y, const Color& color) {
+    // dl = nullptr: vẽ lên màn hình (background draw list của ImGui); khác: draw list riêng (VD: tile ảnh xuất)
+    void drawText(const std::string& text, float x, float y, const Color& color, ImDrawList* dl = nullptr) {
         if (text.empty()) return;
+        if (!dl) dl = ImGui::GetBackgroundDrawList();
 
         // An toàn: Nếu chưa set font, dùng font mặc định của ImGui
         // Lưu ý: Không PushFont nếu pointer là nullptr hoặc rác
@@ -214,10 +299,10 @@ public:
         ImU32 col32 = IM_COL32((int)(color.r * 255), (int)(color.g * 255), (int)(color.b * 255), 255);
 
         // Vẽ viền đen cho chữ (Shadow) để dễ nhìn trên nền tối
-        ImGui::GetBackgroundDrawList()->AddText(ImVec2(x + 1, y + 1), IM_COL32(0,0,0,255), text.c_str());
+        dl->AddText(ImVec2(x + 1, y + 1), IM_COL32(0,0,0,255), text.c_str());
         
         // Vẽ chữ chính
-        ImGui::GetBackgroundDrawList()->AddText(ImVec2(x, y), col32, text.c_str());
+        dl->AddText(ImVec2(x, y), col32, text.c_str());
 
         if (needPop) {
             ImGui::PopFont();
@@ -225,40 +310,135 @@ public:
     }
 
 private:
+    enum ConicKind { CONIC_ELLIPSE, CONIC_PARABOLA, CONIC_HYPERBOLA };
+    static constexpr float CONIC_HALF_WIDTH = 0.5f; // Nét 1 pixel như GL_LINES, thêm ~1 pixel khử răng cưa
+    static constexpr double CONIC_PAD_PX = 2.0;     // Nới quad để phần khử răng cưa không bị cắt
+
     Shader &shader;
-    float left, right, bottom, top;
+    Shader *conicShader = nullptr;
+    GLint uQuad = -1, uLinear = -1, uConst = -1, uColor = -1, uHalfWidth = -1;
+    bool analyticConics = true;
+    double left, right, bottom, top;
+    int viewportW = 1, viewportH = 1;
     GLuint VAO, VBO;
+    GLuint conicVAO, conicVBO;
     ImFont* font = nullptr;
-
-    inline float worldToNDCx(float x) const {
-        return (2.0f * (x - left) / (right - left) - 1.0f);
+    mutable RenderStats stats;
+    mutable FrameArena arena; // Bộ nhớ tạm cho tessellation/đỉnh chờ upload, reset mỗi frame
+
+    template <typename T>
+    T *allocTemp(size_t count) const {
+        T *p = arena.alloc<T>(count);
+        stats.arenaBytes = arena.bytesUsed();
+        return p;
     }
-    inline float worldToNDCy(float y) const {
-        return (2.0f * (y - bottom) / (top - bottom) - 1.0f);
+
+    // Rebase theo camera: tọa độ World (double) trừ tâm khung nhìn, kết quả đủ chính xác trong float
+    inline float cameraX(double x) const { return (float)(x - 0.5 * (left + right)); }
+    inline float cameraY(double y) const { return (float)(y - 0.5 * (bottom + top)); }
+
+    // Tọa độ đã rebase -> NDC (hoàn toàn bằng float)
+    conic::NdcTransform ndcTransform() const {
+        return { (float)(2.0 / (right - left)), 0.0f, (float)(2.0 / (top - bottom)), 0.0f };
     }
 
-    std::vector<float> buildVertexBuffer(const std::vector<Vec2> &pts, const Color &c) const {
-        std::vector<float> verts;
-        verts.reserve(pts.size() * 6);
-        for (const auto &p : pts) {
-            float nx = worldToNDCx(p.x);
-            float ny = worldToNDCy(p.y);
-            verts.push_back(nx);
-            verts.push_back(ny);
-            verts.push_back(0.0f);
-            verts.push_back(c.r);
-            verts.push_back(c.g);
-            verts.push_back(c.b);
+    // Đỉnh nằm trong FrameArena, chỉ có hiệu lực tới hết frame
+    Vertex *buildVertexBuffer(const Vec2 *pts, size_t count, const Color &c) const {
+        Vertex *verts = allocTemp<Vertex>(count);
+        VertexColor color = packColor(c.r, c.g, c.b);
+        conic::NdcTransform ndc = ndcTransform();
+        for (size_t i = 0; i < count; ++i) {
+            verts[i].x = cameraX(pts[i].x) * ndc.sx;
+            verts[i].y = cameraY(pts[i].y) * ndc.sy;
+            verts[i].color = color;
         }
+        stats.verticesGenerated += count;
         return verts;
     }
 
-    void uploadAndDraw(const std::vector<float> &verts, GLenum mode) {
-        if (verts.empty()) return;
+    bool useAnalyticConics() const { return analyticConics && conicShader; }
+
+    // Vẽ conic bằng 1 quad phủ hộp [x0, x1] x [y0, y1] (World, được cắt theo khung nhìn). Hệ riêng của conic có gốc
+    // origin, trục x theo axisX, trục y theo axisY, dạng chính tắc:
+    //   elip (x/a)^2 + (y/b)^2 - 1, parabola x^2 - 4a*y, hyperbola (x/a)^2 - (y/b)^2 - 1.
+    // Phương trình được dời về tâm quad và khai triển bằng double thành p^T M p + g.p + h theo độ lệch pixel p,
+    // nên shader chỉ làm việc với số nhỏ: tâm conic cách xa hàng tỉ pixel (zoom rất sâu) vẫn không mất chính xác
+    void drawConicQuad(ConicKind kind, const Vec2 &origin, Vec2 axisX, Vec2 axisY, double pa, double pb, const Color &c,
+                       double x0, double y0, double x1, double y1) {
+        x0 = std::max(x0, left);
+        y0 = std::max(y0, bottom);
+        x1 = std::min(x1, right);
+        y1 = std::min(y1, top);
+        if (x0 >= x1 || y0 >= y1) return; // Không chạm khung nhìn
+        double px = pixelSize(), inv = 1.0 / px;
+        double mx = 0.5 * (x0 + x1), my = 0.5 * (y0 + y1);
+
+        // Tâm quad q0 trong hệ riêng (pixel) và dạng chính tắc f(q) = kx*qx^2 + ky*qy^2 + ly*qy + hằng số
+        double dx = mx - origin.x, dy = my - origin.y;
+        double qx = (dx * axisX.x + dy * axisX.y) * inv, qy = (dx * axisY.x + dy * axisY.y) * inv;
+        double kx, ky, ly, h;
+        if (kind == CONIC_PARABOLA) {
+            kx = 1.0, ky = 0.0, ly = -4.0 * pa * inv;
+            h = qx * qx + ly * qy;
+        } else {
+            double ia = px / pa, ib = px / pb; // 1/a, 1/b theo pixel
+            double sy = (kind == CONIC_ELLIPSE) ? 1.0 : -1.0;
+            kx = ia * ia, ky = sy * ib * ib, ly = 0.0;
+            double ux = qx * ia, uy = qy * ib;
+            h = ux * ux + sy * uy * uy - 1.0;
+        }
+        // Dời gốc: q = q0 + R p (R có các hàng axisX, axisY) => f = p^T (R^T K R) p + (R^T grad f(q0)).p + f(q0)
+        double gx = 2.0 * kx * qx, gy = 2.0 * ky * qy + ly; // Gradient tại tâm quad, trong hệ riêng
+        double lin[2] = { gx * axisX.x + gy * axisY.x, gx * axisX.y + gy * axisY.y };
+        double quad[3] = { kx * axisX.x * axisX.x + ky * axisY.x * axisY.x,
+                           kx * axisX.x * axisX.y + ky * axisY.x * axisY.y,
+                           kx * axisX.y * axisX.y + ky * axisY.y * axisY.y };
+
+        // Chuẩn hóa để các hệ số vừa tầm float (|f|/|grad f| không đổi khi nhân f với hằng số)
+        double halfDiag = 0.5 * std::hypot(x1 - x0, y1 - y0) * inv;
+        double norm = std::max({ std::abs(lin[0]), std::abs(lin[1]),
+                                 halfDiag * std::max({ std::abs(quad[0]), std::abs(quad[1]), std::abs(quad[2]) }) });
+        if (norm <= 0.0) norm = std::abs(h);
+        if (!(norm > 0.0) || !std::isfinite(norm)) return;
+        double s = 1.0 / norm;
+
+        ConicVertex *verts = allocTemp<ConicVertex>(4);
+        const double cx[4] = { x0, x1, x0, x1 }, cy[4] = { y0, y0, y1, y1 };
+        conic::NdcTransform ndc = ndcTransform();
+        for (int i = 0; i < 4; ++i)
+            verts[i] = { cameraX(cx[i]) * ndc.sx, cameraY(cy[i]) * ndc.sy,
+                         (float)((cx[i] - mx) * inv), (float)((cy[i] - my) * inv) };
+        stats.verticesGenerated += 4;
+
+        conicShader->use();
+        glUniform3f(uQuad, (float)(quad[0] * s), (float)(quad[1] * s), (float)(quad[2] * s));
+        glUniform2f(uLinear, (float)(lin[0] * s), (float)(lin[1] * s));
+        glUniform1f(uConst, (float)(h * s));
+        glUniform3f(uColor, c.r, c.g, c.b);
+        glUniform1f(uHalfWidth, CONIC_HALF_WIDTH);
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        if (!blend) glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glBindVertexArray(conicVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, conicVBO);
+        glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(ConicVertex), verts, GL_DYNAMIC_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        stats.bytesUploaded += 4 * sizeof(ConicVertex);
+        stats.drawCalls++;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        if (!blend) glDisable(GL_BLEND);
+        shader.use();
+    }
+
+    void uploadAndDraw(const Vertex *verts, size_t count, GLenum mode) {
+        if (count == 0) return;
         glBindVertexArray(VAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(mode, 0, (GLsizei)(verts.size() / 6));
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(Vertex), verts, GL_DYNAMIC_DRAW);
+        glDrawArrays(mode, 0, (GLsizei)count);
+        stats.bytesUploaded += count * sizeof(Vertex);
+        stats.drawCalls++;
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
     }
@@ -0,0 +1,523 @@
+#ifndef INTERSECTIONS_H
+#define INTERSECTIONS_H
+
+#include <vector>
+#include <set>
+#include <queue>
+#include <tuple>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "geometry.h"
+#include "predicates.h"
+
+// Tìm MỌI giao điểm giữa đoạn thẳng, đường thẳng, tia và đường tròn bằng đường quét Bentley–Ottmann,
+// O((n + k) log n) với n đường, k giao điểm.
+// - Đường tròn tách thành cung trên/dưới (đơn điệu theo x) để đi chung đường quét với đoạn thẳng.
+// - Đường thẳng/tia: giao điểm giữa chúng với nhau tính trực tiếp (thường rất ít), sau đó cắt theo
+//   hộp bao của toàn bộ hình hữu hạn và các giao điểm đó rồi đưa vào đường quét như đoạn thẳng.
+// - Mọi đường đi qua cùng một điểm sự kiện được gỡ khỏi trạng thái rồi chèn lại theo thứ tự ngay bên
+//   phải điểm đó (xử lý được nhiều đường đồng quy, chạm đầu mút, đoạn thẳng đứng).
+// - Đoạn chồng lên nhau (thẳng hàng) không có giao điểm rời rạc nên bị bỏ qua.
+
+struct IntersectionHit {
+    Vec2 p;
+    int shapeA, shapeB; // shapeA <= shapeB
+};
+
+namespace isect {
+
+enum CurveKind { CURVE_SEGMENT, CURVE_ARC };
+
+// Một đường đơn điệu theo x trong đường quét
+struct Curve {
+    CurveKind kind = CURVE_SEGMENT;
+    int shape = -1;        // Chỉ số hình gốc
+    int part = -1;         // Cạnh thứ mấy của polyline (-1 nếu không phải polyline)
+    bool infinite = false; // Đến từ đường thẳng/tia
+    // Đoạn: a + t*(b - a), t trong [t0, t1]
+    Vec2 a{0.0, 0.0}, b{0.0, 0.0};
+    double t0 = 0.0, t1 = 1.0;
+    // Cung: tâm c, bán kính r, nửa trên hoặc dưới
+    Vec2 c{0.0, 0.0};
+    double r = 0.0;
+    bool upper = true;
+    // Đầu mút trái/phải theo thứ tự (x, y)
+    Vec2 left{0.0, 0.0}, right{0.0, 0.0};
+};
+
+inline bool lexLess(Vec2 p, Vec2 q) {
+    return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+inline bool samePoint(Vec2 p, Vec2 q) {
+    return p.x == q.x && p.y == q.y;
+}
+
+// Đầu vào: các hình đã đổi sang đường cơ bản
+class Scene {
+public:
+    std::vector<Curve> curves;   // Đường hữu hạn
+    std::vector<Curve> infinite; // Đường thẳng/tia (chưa cắt)
+
+    void addSegment(Vec2 a, Vec2 b, int shape, int part = -1) {
+        Curve cv;
+        cv.shape = shape;
+        cv.part = part;
+        cv.a = a;
+        cv.b = b;
+        setEnds(cv);
+        curves.push_back(cv);
+    }
+
+    // Đường thẳng qua p1, p2
+    void addLine(Vec2 p1, Vec2 p2, int shape) {
+        if (samePoint(p1, p2)) return;
+        Curve cv;
+        cv.shape = shape;
+        cv.infinite = true;
+        cv.a = p1;
+        cv.b = p2;
+        cv.t0 = -INFINITY;
+        cv.t1 = INFINITY;
+        infinite.push_back(cv);
+    }
+
+    // Tia gốc origin đi qua through
+    void addRay(Vec2 origin, Vec2 through, int shape) {
+        if (samePoint(origin, through)) return;
+        Curve cv;
+        cv.shape = shape;
+        cv.infinite = true;
+        cv.a = origin;
+        cv.b = through;
+        cv.t0 = 0.0;
+        cv.t1 = INFINITY;
+        infinite.push_back(cv);
+    }
+
+    void addCircle(Vec2 center, double radius, int shape) {
+        if (!(radius > 0.0)) return;
+        for (int half = 0; half < 2; ++half) {
+            Curve cv;
+            cv.kind = CURVE_ARC;
+            cv.shape = shape;
+            cv.c = center;
+            cv.r = radius;
+            cv.upper = (half == 0);
+            cv.left = {center.x - radius, center.y};
+            cv.right = {center.x + radius, center.y};
+            curves.push_back(cv);
+        }
+    }
+
+    size_t size() const { return curves.size() + infinite.size(); }
+
+    static void setEnds(Curve &cv) {
+        Vec2 d = {cv.b.x - cv.a.x, cv.b.y - cv.a.y};
+        Vec2 p = {cv.a.x + cv.t0 * d.x, cv.a.y + cv.t0 * d.y};
+        Vec2 q = {cv.a.x + cv.t1 * d.x, cv.a.y + cv.t1 * d.y};
+        if (cv.t0 == 0.0) p = cv.a; // Giữ đúng từng bit đầu mút gốc
+        if (cv.t1 == 1.0) q = cv.b;
+        cv.left = lexLess(q, p) ? q : p;
+        cv.right = lexLess(q, p) ? p : q;
+    }
+};
+
+// ---- Giao của hai đường cơ bản ----
+
+inline bool onHalf(const Curve &arc, Vec2 p) {
+    return arc.upper ? p.y >= arc.c.y : p.y <= arc.c.y;
+}
+
+inline int segSeg(const Curve &A, const Curve &B, Vec2 out[2]) {
+    if (pred::crossSign(A.a, A.b, B.a, B.b) == 0) return 0; // Song song hoặc thẳng hàng
+    double d1x = A.b.x - A.a.x, d1y = A.b.y - A.a.y;
+    double d2x = B.b.x - B.a.x, d2y = B.b.y - B.a.y;
+    double ex = B.a.x - A.a.x, ey = B.a.y - A.a.y;
+    double denom = d1x * d2y - d1y * d2x;
+    double t = (ex * d2y - ey * d2x) / denom;
+    if (!A.infinite && !B.infinite) {
+        // Hai đoạn: quyết định có cắt hay không bằng vị từ chính xác, chỉ tọa độ giao điểm là làm tròn
+        if (!pred::segmentsIntersect(A.a, A.b, B.a, B.b)) return 0;
+        t = std::max(0.0, std::min(1.0, t));
+    } else {
+        double u = (ex * d1y - ey * d1x) / denom;
+        if (!(t >= A.t0 && t <= A.t1 && u >= B.t0 && u <= B.t1)) return 0;
+    }
+    out[0] = {A.a.x + t * d1x, A.a.y + t * d1y};
+    return 1;
+}
+
+inline int segArc(const Curve &S, const Curve &C, Vec2 out[2]) {
+    // |a + t*d - c|^2 = r^2, tính tương đối so với tâm
+    double dx = S.b.x - S.a.x, dy = S.b.y - S.a.y;
+    double fx = S.a.x - C.c.x, fy = S.a.y - C.c.y;
+    double A = dx * dx + dy * dy;
+    double B = 2.0 * (fx * dx + fy * dy);
+    double K = fx * fx + fy * fy - C.r * C.r;
+    double disc = B * B - 4.0 * A * K;
+    if (A == 0.0 || disc < 0.0) return 0;
+    // Công thức nghiệm ổn định (tránh khử số khi B lớn)
+    double q = -0.5 * (B + std::copysign(std::sqrt(disc), B));
+    double ts[2];
+    int nt = 0;
+    ts[nt++] = q / A;
+    if (disc > 0.0 && q != 0.0) ts[nt++] = K / q;
+    int n = 0;
+    for (int i = 0; i < nt; ++i) {
+        double t = ts[i];
+        if (!(t >= S.t0 && t <= S.t1)) continue;
+        Vec2 p = {S.a.x + t * dx, S.a.y + t * dy};
+        if (onHalf(C, p)) out[n++] = p;
+    }
+    return n;
+}
+
+inline int arcArc(const Curve &A, const Curve &B, Vec2 out[2]) {
+    double dx = B.c.x - A.c.x, dy = B.c.y - A.c.y;
+    double d2 = dx * dx + dy * dy;
+    double d = std::sqrt(d2);
+    if (d == 0.0 || d > A.r + B.r || d < std::abs(A.r - B.r)) return 0;
+    double a = (A.r * A.r - B.r * B.r + d2) / (2.0 * d);
+    double h = std::sqrt(std::max(0.0, A.r * A.r - a * a));
+    double mx = A.c.x + a * dx / d, my = A.c.y + a * dy / d;
+    Vec2 cand[2] = {{mx - h * dy / d, my + h * dx / d}, {mx + h * dy / d, my - h * dx / d}};
+    int n = 0;
+    for (int i = 0; i < (h > 0.0 ? 2 : 1); ++i)
+        if (onHalf(A, cand[i]) && onHalf(B, cand[i])) out[n++] = cand[i];
+    return n;
+}
+
+struct Box {
+    double minX, minY, maxX, maxY;
+};
+
+inline Box boundsOf(const Curve &cv) {
+    if (cv.kind == CURVE_ARC)
+        return {cv.c.x - cv.r, cv.upper ? cv.c.y : cv.c.y - cv.r, cv.c.x + cv.r, cv.upper ? cv.c.y + cv.r : cv.c.y};
+    return {cv.left.x, std::min(cv.left.y, cv.right.y), cv.right.x, std::max(cv.left.y, cv.right.y)};
+}
+
+// Giao điểm của hai đường, sắp theo thứ tự (x, y).
+// Điểm được kẹp vào hộp bao chung của hai đường: làm tròn không được đẩy giao điểm ra ngoài đầu mút
+// (VD lệch 1 ulp sang phải đoạn thẳng đứng), nếu không đường quét gặp nó sau sự kiện kết thúc.
+inline int intersect(const Curve &A, const Curve &B, Vec2 out[2]) {
+    int n;
+    if (A.kind == CURVE_SEGMENT && B.kind == CURVE_SEGMENT) n = segSeg(A, B, out);
+    else if (A.kind == CURVE_SEGMENT) n = segArc(A, B, out);
+    else if (B.kind == CURVE_SEGMENT) n = segArc(B, A, out);
+    else n = arcArc(A, B, out);
+    if (n > 0) {
+        Box a = boundsOf(A), b = boundsOf(B);
+        for (int i = 0; i < n; ++i) {
+            out[i].x = std::max(std::max(a.minX, b.minX), std::min(std::min(a.maxX, b.maxX), out[i].x));
+            out[i].y = std::max(std::max(a.minY, b.minY), std::min(std::min(a.maxY, b.maxY), out[i].y));
+        }
+    }
+    if (n == 2) {
+        if (lexLess(out[1], out[0])) std::swap(out[0], out[1]);
+        if (samePoint(out[0], out[1])) n = 1;
+    }
+    return n;
+}
+
+// Cặp không báo cáo: hai đường vô hạn (đã tính riêng), hai nửa cùng đường tròn, hai cạnh kề của polyline
+inline bool excluded(const Curve &A, const Curve &B) {
+    if (A.infinite && B.infinite) return true;
+    if (A.shape != B.shape) return false;
+    if (A.kind == CURVE_ARC && B.kind == CURVE_ARC) return true;
+    return A.part >= 0 && B.part >= 0 && std::abs(A.part - B.part) == 1;
+}
+
+inline IntersectionHit makeHit(const Curve &A, const Curve &B, Vec2 p) {
+    return {p, std::min(A.shape, B.shape), std::max(A.shape, B.shape)};
+}
+
+// Sắp xếp và bỏ trùng (cùng cặp hình, cùng tọa độ)
+inline void finalize(std::vector<IntersectionHit> &hits) {
+    auto key = [](const IntersectionHit &h) { return std::make_tuple(h.shapeA, h.shapeB, h.p.x, h.p.y); };
+    std::sort(hits.begin(), hits.end(), [&](const IntersectionHit &a, const IntersectionHit &b) { return key(a) < key(b); });
+    hits.erase(std::unique(hits.begin(), hits.end(), [&](const IntersectionHit &a, const IntersectionHit &b) { return key(a) == key(b); }),
+               hits.end());
+}
+
+// Tính giao điểm giữa các đường vô hạn, rồi cắt chúng theo hộp bao chứa mọi thứ cần tìm.
+// Trả về danh sách đường hữu hạn dùng cho cả đường quét lẫn brute force (để hai cách cho cùng kết quả).
+inline std::vector<Curve> prepare(const Scene &scene, std::vector<IntersectionHit> &hits) {
+    std::vector<Curve> out = scene.curves;
+    if (scene.infinite.empty()) return out;
+
+    double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    auto grow = [&](Vec2 p) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+    };
+    for (const Curve &cv : scene.curves) {
+        if (cv.kind == CURVE_ARC) {
+            grow({cv.c.x - cv.r, cv.c.y - cv.r});
+            grow({cv.c.x + cv.r, cv.c.y + cv.r});
+        } else {
+            grow(cv.left);
+            grow(cv.right);
+        }
+    }
+    for (size_t i = 0; i < scene.infinite.size(); ++i) {
+        const Curve &A = scene.infinite[i];
+        grow(A.a); // Gốc tia (và 1 điểm của đường thẳng) luôn nằm trong hộp
+        for (size_t j = i + 1; j < scene.infinite.size(); ++j) {
+            Vec2 pts[2];
+            if (segSeg(A, scene.infinite[j], pts)) {
+                hits.push_back(makeHit(A, scene.infinite[j], pts[0]));
+                grow(pts[0]);
+            }
+        }
+    }
+    double margin = 0.01 * std::max(maxX - minX, maxY - minY) + 1.0;
+    minX -= margin; maxX += margin;
+    minY -= margin; maxY += margin;
+
+    // Liang–Barsky: thu hẹp [t0, t1] theo 4 cạnh của hộp
+    for (Curve cv : scene.infinite) {
+        double dx = cv.b.x - cv.a.x, dy = cv.b.y - cv.a.y;
+        double p[4] = {-dx, dx, -dy, dy};
+        double q[4] = {cv.a.x - minX, maxX - cv.a.x, cv.a.y - minY, maxY - cv.a.y};
+        bool inside = true;
+        for (int k = 0; k < 4 && inside; ++k) {
+            if (p[k] == 0.0) {
+                inside = q[k] >= 0.0;
+                continue;
+            }
+            double t = q[k] / p[k];
+            if (p[k] < 0.0) cv.t0 = std::max(cv.t0, t);
+            else cv.t1 = std::min(cv.t1, t);
+        }
+        if (!inside || !(cv.t0 <= cv.t1)) continue;
+        Scene::setEnds(cv);
+        out.push_back(cv);
+    }
+    return out;
+}
+
+// ---- Đường quét ----
+class Sweep {
+public:
+    explicit Sweep(const std::vector<Curve> &cv)
+        : curves(cv), status(SlotLess{this}), where(cv.size()), active(cv.size(), 0), atPoint(cv.size(), 0), finished(cv.size(), 0) {
+        double scale = 0.0;
+        for (size_t i = 0; i < cv.size(); ++i) {
+            scale = std::max({scale, std::abs(cv[i].left.x), std::abs(cv[i].left.y), std::abs(cv[i].right.x),
+                              std::abs(cv[i].right.y), std::abs(cv[i].c.y) + cv[i].r});
+            queue.push({cv[i].left.x, cv[i].left.y, EV_START, (int)i, -1});
+            queue.push({cv[i].right.x, cv[i].right.y, EV_END, (int)i, -1});
+        }
+        tol = 64.0 * std::numeric_limits<double>::epsilon() * scale;
+    }
+
+    void run(std::vector<IntersectionHit> &out) {
+        hits = &out;
+        std::vector<int> starts, ends, through;
+        while (!queue.empty()) {
+            sx = queue.top().x;
+            sy = queue.top().y;
+            starts.clear();
+            ends.clear();
+            through.clear();
+            // Gom mọi sự kiện tại cùng một điểm
+            while (!queue.empty() && queue.top().x == sx && queue.top().y == sy) {
+                Event e = queue.top();
+                queue.pop();
+                if (e.type == EV_START) starts.push_back(e.a);
+                else if (e.type == EV_END) ends.push_back(e.a);
+                else { through.push_back(e.a); through.push_back(e.b); }
+            }
+            through.insert(through.end(), starts.begin(), starts.end());
+            through.insert(through.end(), ends.begin(), ends.end());
+            std::sort(through.begin(), through.end());
+            through.erase(std::unique(through.begin(), through.end()), through.end());
+
+            // Các đường qua điểm này được coi là có y đúng bằng sy khi so sánh
+            for (int c : through) atPoint[c] = 1;
+            // Thêm các đường đang quét đi qua điểm này (bên trong đoạn, không có sự kiện riêng).
+            // Nới vài chục ulp (theo độ lớn tọa độ của cả đầu vào): 3 đường đồng quy cho 3 giao điểm lệch
+            // nhau do làm tròn, không nới thì cặp ngoài cùng có thể không bao giờ kề nhau.
+            auto end = status.upper_bound(Probe{sy + tol});
+            for (auto it = status.lower_bound(Probe{sy - tol}); it != end; ++it) {
+                int c = *it;
+                if (!atPoint[c]) {
+                    atPoint[c] = 1;
+                    through.push_back(c);
+                }
+            }
+            for (size_t i = 0; i < through.size(); ++i)
+                for (size_t j = i + 1; j < through.size(); ++j)
+                    handlePair(through[i], through[j]);
+
+            // Gỡ ra rồi chèn lại theo thứ tự ngay bên phải điểm quét (đường cắt nhau tự đổi chỗ)
+            for (int c : through) {
+                if (active[c]) {
+                    status.erase(where[c]);
+                    active[c] = 0;
+                }
+            }
+            for (int c : ends) finished[c] = 1;
+            bool inserted = false;
+            for (int c : through) {
+                // Giao điểm làm tròn có thể rơi ngay sau đầu mút phải: đường đã kết thúc thì không chèn lại
+                if (finished[c]) continue;
+                where[c] = status.insert(c).first;
+                active[c] = 1;
+                inserted = true;
+            }
+            if (inserted) {
+                for (int c : through) {
+                    if (!active[c]) continue;
+                    auto it = where[c];
+                    if (it != status.begin()) handlePair(*std::prev(it), c);
+                    if (std::next(it) != status.end()) handlePair(c, *std::next(it));
+                }
+            } else {
+                // Chỉ có đường kết thúc: hai đường hai bên giờ kề nhau
+                auto hi = status.lower_bound(Probe{sy});
+                if (hi != status.begin() && hi != status.end())
+                    handlePair(*std::prev(hi), *hi);
+            }
+            for (int c : through) atPoint[c] = 0;
+        }
+    }
+
+private:
+    enum EventType { EV_CROSS = 0, EV_START = 1, EV_END = 2 };
+    struct Event {
+        double x, y;
+        int type, a, b;
+        bool operator>(const Event &o) const {
+            return std::tie(x, y, type, a, b) > std::tie(o.x, o.y, o.type, o.a, o.b);
+        }
+    };
+    struct Probe { double y; };
+
+    struct SlotLess {
+        const Sweep *s;
+        using is_transparent = void;
+        bool operator()(int a, int b) const { return s->below(a, b); }
+        bool operator()(int a, Probe p) const { return s->yAt(a) < p.y; }
+        bool operator()(Probe p, int a) const { return p.y < s->yAt(a); }
+    };
+
+    const std::vector<Curve> &curves;
+    double sx = 0.0, sy = 0.0; // Điểm quét hiện tại
+    double tol = 0.0;          // Sai số y coi như đi qua điểm quét
+    std::set<int, SlotLess> status;
+    std::vector<std::set<int, SlotLess>::iterator> where;
+    std::vector<char> active, atPoint, finished;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    std::set<std::tuple<int, int, double, double>> scheduled, recorded;
+    std::vector<IntersectionHit> *hits = nullptr;
+
+    // y của đường tại đường quét; đoạn thẳng đứng lấy y của điểm quét (như thể đường quét hơi nghiêng)
+    double yAt(int ci) const {
+        if (atPoint[ci]) return sy;
+        const Curve &cv = curves[ci];
+        if (cv.kind == CURVE_ARC) {
+            double dx = std::max(-cv.r, std::min(cv.r, sx - cv.c.x));
+            double h = std::sqrt(cv.r * cv.r - dx * dx);
+            return cv.upper ? cv.c.y + h : cv.c.y - h;
+        }
+        if (cv.left.x == cv.right.x) return std::max(cv.left.y, std::min(cv.right.y, sy));
+        if (sx <= cv.left.x) return cv.left.y;
+        if (sx >= cv.right.x) return cv.right.y;
+        return cv.left.y + (sx - cv.left.x) * (cv.right.y - cv.left.y) / (cv.right.x - cv.left.x);
+    }
+
+    // Hệ số góc ngay bên phải đường quét (thẳng đứng = +vô cùng)
+    double slopeAt(int ci) const {
+        const Curve &cv = curves[ci];
+        if (cv.kind == CURVE_ARC) {
+            double dx = std::max(-cv.r, std::min(cv.r, sx - cv.c.x));
+            double h = std::sqrt(cv.r * cv.r - dx * dx);
+            if (h == 0.0) return (cv.upper == (dx < 0.0)) ? INFINITY : -INFINITY;
+            return cv.upper ? -dx / h : dx / h;
+        }
+        if (cv.left.x == cv.right.x) return INFINITY;
+        return (cv.right.y - cv.left.y) / (cv.right.x - cv.left.x);
+    }
+
+    // Độ cong y'' (phân định hai đường tiếp xúc: cùng y, cùng hệ số góc)
+    double curvatureAt(int ci) const {
+        const Curve &cv = curves[ci];
+        if (cv.kind == CURVE_SEGMENT) return 0.0;
+        double dx = std::max(-cv.r, std::min(cv.r, sx - cv.c.x));
+        double h = std::sqrt(cv.r * cv.r - dx * dx);
+        // Tại đầu mút (tiếp tuyến thẳng đứng): cung trên bán kính lớn hơn nằm trên, cung dưới ngược lại
+        if (h == 0.0) return cv.upper ? -1.0 / cv.r : 1.0 / cv.r;
+        double k = cv.r * cv.r / (h * h * h);
+        return cv.upper ? -k : k;
+    }
+
+    bool below(int a, int b) const {
+        if (a == b) return false;
+        double ya = yAt(a), yb = yAt(b);
+        if (ya != yb) return ya < yb;
+        // Hệ số góc lệch vài ulp coi như bằng nhau (hai đường tiếp xúc), khi đó xét độ cong
+        double ka = slopeAt(a), kb = slopeAt(b);
+        bool nearlyEqual = std::isfinite(ka) && std::isfinite(kb) &&
+                           std::abs(ka - kb) <= 64.0 * std::numeric_limits<double>::epsilon() * std::max(std::abs(ka), std::abs(kb));
+        if (ka != kb && !nearlyEqual) return ka < kb;
+        double ca = curvatureAt(a), cb = curvatureAt(b);
+        if (ca != cb) return ca < cb;
+        return a < b;
+    }
+
+    // Ghi các giao điểm đã qua (hoặc đúng tại điểm quét), lên lịch giao điểm kế tiếp phía trước
+    void handlePair(int a, int b) {
+        // Luôn tính theo thứ tự chỉ số để tọa độ làm tròn giống hệt nhau mỗi lần (và giống bruteForce)
+        int lo = std::min(a, b), hi = std::max(a, b);
+        const Curve &A = curves[lo], &B = curves[hi];
+        // Cặp bị loại vẫn phải có sự kiện cắt để đổi thứ tự trên đường quét, chỉ không ghi kết quả
+        bool report = !excluded(A, B);
+        Vec2 pts[2];
+        int n = intersect(A, B, pts);
+        for (int i = 0; i < n; ++i) {
+            auto key = std::make_tuple(lo, hi, pts[i].x, pts[i].y);
+            if (lexLess({sx, sy}, pts[i])) {
+                if (scheduled.insert(key).second) queue.push({pts[i].x, pts[i].y, EV_CROSS, lo, hi});
+                return;
+            }
+            if (report && recorded.insert(key).second) hits->push_back(makeHit(A, B, pts[i]));
+        }
+    }
+};
+
+// Mọi giao điểm bằng đường quét
+inline std::vector<IntersectionHit> sweep(const Scene &scene) {
+    std::vector<IntersectionHit> hits;
+    std::vector<Curve> curves = prepare(scene, hits);
+    Sweep(curves).run(hits);
+    finalize(hits);
+    return hits;
+}
+
+// Mọi giao điểm bằng cách thử từng cặp O(n^2) (tham chiếu để kiểm tra và benchmark)
+inline std::vector<IntersectionHit> bruteForce(const Scene &scene) {
+    std::vector<IntersectionHit> hits;
+    std::vector<Curve> curves = prepare(scene, hits);
+    std::vector<Box> boxes(curves.size());
+    for (size_t i = 0; i < curves.size(); ++i) boxes[i] = boundsOf(curves[i]);
+    for (size_t i = 0; i < curves.size(); ++i) {
+        for (size_t j = i + 1; j < curves.size(); ++j) {
+            const Box &p = boxes[i], &q = boxes[j];
+            if (p.maxX < q.minX || q.maxX < p.minX || p.maxY < q.minY || q.maxY < p.minY) continue;
+            if (excluded(curves[i], curves[j])) continue;
+            Vec2 pts[2];
+            int n = intersect(curves[i], curves[j], pts);
+            for (int k = 0; k < n; ++k) hits.push_back(makeHit(curves[i], curves[j], pts[k]));
+        }
+    }
+    finalize(hits);
+    return hits;
+}
+
+} // namespace isect
+
+#endif // INTERSECTIONS_H
@@ -0,0 +1,202 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+
+// Nhật ký thao tác chỉ-ghi-thêm (append-only) cho autosave.
+// Luồng UI chỉ đẩy bản ghi vào hàng đợi; luồng nền ghi xuống đĩa và thực hiện
+// nén (compaction): ghi snapshot đầy đủ rồi xóa trắng nhật ký.
+// Khung bản ghi trên đĩa: [u32 độ dài][u32 checksum][payload]; bản ghi dở dang do crash bị bỏ qua khi đọc.
+// Payload bắt đầu bằng byte 0 là bản ghi "epoch" nội bộ: snapshot và nhật ký cùng mang số epoch,
+// nên nếu crash giữa lúc đổi tên snapshot và xóa nhật ký thì nhật ký cũ (epoch nhỏ hơn) bị bỏ qua.
+class Journal {
+public:
+    using SnapshotWriter = std::function<bool(std::ostream &)>;
+
+    ~Journal() { close(false); }
+
+    // Mở nhật ký; epoch = epoch của snapshot hiện có (0 nếu chưa có).
+    // appendExisting = true khi nhật ký trên đĩa hợp lệ với epoch đó (vừa được khôi phục) để ghi tiếp,
+    // ngược lại nhật ký được tạo mới.
+    bool open(const std::string &journalFile, const std::string &snapshotFile, uint64_t epoch, bool appendExisting) {
+        close(false);
+        journalPath = journalFile;
+        snapshotPath = snapshotFile;
+        currentEpoch = epoch;
+        out.open(journalPath, std::ios::binary | (appendExisting ? std::ios::app : std::ios::trunc));
+        if (!out) return false;
+        if (!appendExisting) writeEpoch();
+        stopFlag = false;
+        sinceSnapshot = 0;
+        worker = std::thread(&Journal::run, this);
+        return true;
+    }
+
+    bool isOpen() const { return worker.joinable(); }
+
+    // Đóng nhật ký; removeFiles = true khi thoát bình thường (không cần khôi phục nữa)
+    void close(bool removeFiles) {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopFlag = true;
+        }
+        cv.notify_all();
+        worker.join();
+        out.close();
+        if (removeFiles) {
+            std::error_code ec;
+            std::filesystem::remove(journalPath, ec);
+            std::filesystem::remove(snapshotPath, ec);
+        }
+    }
+
+    void append(std::string payload) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            items.push_back({std::move(payload), nullptr});
+            ++sinceSnapshot;
+        }
+        cv.notify_one();
+    }
+
+    // Yêu cầu nén: writer ghi snapshot đầy đủ, sau đó nhật ký được xóa trắng.
+    // Các bản ghi đẩy vào sau lời gọi này vẫn nằm trong nhật ký mới.
+    void snapshot(SnapshotWriter writer) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            items.push_back({std::string(), std::move(writer)});
+            sinceSnapshot = 0;
+        }
+        cv.notify_one();
+    }
+
+    size_t recordsSinceSnapshot() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sinceSnapshot;
+    }
+
+    // Đọc snapshot: dòng đầu "epoch N", phần còn lại do reader xử lý. false nếu không có/hỏng
+    static bool readSnapshot(const std::string &snapshotFile, uint64_t &epoch, const std::function<bool(std::istream &)> &reader) {
+        std::ifstream in(snapshotFile);
+        std::string tag;
+        if (!in || !(in >> tag >> epoch) || tag != "epoch") return false;
+        return reader(in);
+    }
+
+    // Đọc các bản ghi hợp lệ của nhật ký có cùng epoch với snapshot (dùng khi khôi phục sau crash);
+    // trả về số bản ghi đã đọc
+    static size_t readRecords(const std::string &journalFile, uint64_t epoch, const std::function<void(const std::string &)> &fn) {
+        std::ifstream in(journalFile, std::ios::binary);
+        // Kích thước file: độ dài trong header đọc từ đĩa (có thể là rác) không được vượt phần còn lại
+        in.seekg(0, std::ios::end);
+        std::streamoff fileSize = in ? (std::streamoff)in.tellg() : 0;
+        in.seekg(0);
+        size_t count = 0;
+        bool epochOk = false;
+        uint32_t header[2];
+        std::string payload;
+        while (in.read(reinterpret_cast<char *>(header), sizeof(header))) {
+            if ((std::streamoff)header[0] > fileSize - (std::streamoff)in.tellg())
+                break; // Đuôi rác: độ dài vượt quá dữ liệu còn lại
+            payload.resize(header[0]);
+            if (!in.read(&payload[0], header[0]) || checksum(payload) != header[1])
+                break; // Bản ghi cuối bị cắt ngang
+            if (!payload.empty() && payload[0] == 0) {
+                uint64_t e = 0;
+                if (payload.size() == 1 + sizeof(e)) std::memcpy(&e, payload.data() + 1, sizeof(e));
+                epochOk = (e == epoch);
+                if (!epochOk) break; // Nhật ký cũ hơn snapshot: đã nằm trong snapshot
+                continue;
+            }
+            if (!epochOk) break;
+            fn(payload);
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct Item {
+        std::string payload;
+        SnapshotWriter writer; // != nullptr: yêu cầu nén
+    };
+
+    std::string journalPath, snapshotPath;
+    std::ofstream out;
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Item> items;
+    bool stopFlag = false;
+    size_t sinceSnapshot = 0;
+    uint64_t currentEpoch = 0; // Chỉ luồng ghi dùng sau khi open
+
+    // FNV-1a 32 bit
+    static uint32_t checksum(const std::string &s) {
+        uint32_t h = 2166136261u;
+        for (unsigned char c : s) h = (h ^ c) * 16777619u;
+        return h;
+    }
+
+    void run() {
+        std::deque<Item> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return stopFlag || !items.empty(); });
+                if (items.empty() && stopFlag) return;
+                batch.swap(items);
+            }
+            for (Item &it : batch) {
+                if (it.writer) writeSnapshot(it.writer);
+                else writeRecord(it.payload);
+            }
+            batch.clear();
+            out.flush();
+        }
+    }
+
+    void writeRecord(const std::string &payload) {
+        uint32_t header[2] = {(uint32_t)payload.size(), checksum(payload)};
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        out.write(payload.data(), (std::streamsize)payload.size());
+    }
+
+    void writeEpoch() {
+        std::string payload(1 + sizeof(currentEpoch), '\0');
+        std::memcpy(&payload[1], &currentEpoch, sizeof(currentEpoch));
+        writeRecord(payload);
+    }
+
+    void writeSnapshot(const SnapshotWriter &writer) {
+        std::string tmp = snapshotPath + ".tmp";
+        {
+            std::ofstream snap(tmp);
+            if (!snap) return;
+            snap << "epoch " << (currentEpoch + 1) << "\n";
+            if (!writer(snap)) return; // Giữ nhật ký cũ nếu không ghi được snapshot
+        }
+        out.flush();
+        std::error_code ec;
+        std::filesystem::rename(tmp, snapshotPath, ec);
+        if (ec) return;
+        // Snapshot đã chứa mọi thao tác trước đó: bắt đầu nhật ký mới với epoch mới
+        ++currentEpoch;
+        out.close();
+        out.open(journalPath, std::ios::binary | std::ios::trunc);
+        writeEpoch();
+    }
+};
+
+#endif // JOURNAL_H
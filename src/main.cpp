@@ -7,27 +7,107 @@
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <limits>
 #include <algorithm>
 #include <fstream>
 #include <filesystem>
 
 #include "shader.h"
 #include "geometry.h"
+#include "profiler.h"
+#include "polyline_lod.h"
+#include "polyline_index.h"
+#include "polyline_import.h"
+#include "async_task.h"
+#include "journal.h"
+#include "autosave_dir.h"
+#include "segment_simd.h"
+#include "predicates.h"
+#include "intersections.h"
+#include "point_sets.h"
+#include "scene_index.h"
+#include "slot_map.h"
+#include "name_registry.h"
+#include "frame_pacing.h"
+#include "tile_export.h"
+#include "vector_export.h"
+#include "benchmarks.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 #include "imgui_stdlib.h"
-#include <set>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <new>
 
 namespace fs = std::filesystem;
 
+// ---- Đếm cấp phát heap ----
+// Thay operator new toàn cục để đếm số lần cấp phát trên từng luồng;
+// Stats panel dùng số của luồng UI để kiểm tra frame ổn định không cấp phát heap.
+static thread_local size_t t_heapAllocs = 0;
+
+// noinline: nếu GCC inline được malloc/free vào nơi gọi new/delete thì sẽ cảnh báo -Wmismatched-new-delete
+// (thấy free trên con trỏ từ new) dù cặp new/delete vẫn khớp
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    ++t_heapAllocs;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+static size_t heapAllocCount()
+{
+    return t_heapAllocs;
+}
+
 // Biến toàn cục quản lý chuột
 static bool dragging = false;     // Panning màn hình
-static int draggingPointIdx = -1; // Index điểm đang bị kéo (nếu có)
+static SlotHandle draggingPoint;  // Handle điểm đang bị kéo (nếu có)
 static double lastX = 0.0, lastY = 0.0;
 
+// ---- Vẽ theo yêu cầu ----
+// Số frame còn phải vẽ. Mọi sự kiện (input, đổi kích thước, sửa bản vẽ...) đặt lại vài frame vì ImGui
+// cần 1-2 frame sau input để cập nhật hover/layout; hết số frame thì vòng lặp ngủ trong glfwWaitEventsTimeout.
+static const int REDRAW_FRAMES = 3;
+static int g_redrawFrames = REDRAW_FRAMES;
+
+static void requestRedraw()
+{
+    g_redrawFrames = REDRAW_FRAMES;
+}
+
+// Nhịp frame & đo độ trễ input: callback input đóng dấu thời gian, vòng lặp chính gắn nó với frame phản ánh
+static FramePacer g_pacer;
+
+// Hạn chờ tối đa khi rảnh (giây): đủ thưa để gần như không tốn CPU, đủ dày cho autosave định kỳ
+static const double IDLE_WAKE_SECONDS = 0.5;
+
 // ---- Forward declarations ----
 void canvas_framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void canvas_processInput(GLFWwindow *window);
@@ -35,14 +115,20 @@ void canvas_scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
 void canvas_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+void canvas_char_callback(GLFWwindow *window, unsigned int codepoint);
+void canvas_refresh_callback(GLFWwindow *window);
+void canvas_focus_callback(GLFWwindow *window, int focused);
+void canvas_cursor_enter_callback(GLFWwindow *window, int entered);
+static void flushCursorMove(GLFWwindow *window);
 
 // ---- Math Helpers ----
-float distSq(Vec2 p1, Vec2 p2)
+// Tọa độ World là double: các phép tính trên tọa độ giữ double để zoom sâu không mất chính xác
+double distSq(Vec2 p1, Vec2 p2)
 {
     return (p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y);
 }
 
-float dist(Vec2 p1, Vec2 p2)
+double dist(Vec2 p1, Vec2 p2)
 {
     return std::sqrt(distSq(p1, p2));
 }
@@ -50,21 +136,28 @@ float dist(Vec2 p1, Vec2 p2)
 // Tính giao điểm của 2 đường thẳng vô hạn (trả về false nếu song song)
 bool getLineIntersection(Vec2 a1, Vec2 b1, Vec2 a2, Vec2 b2, Vec2 &outI)
 {
-    float x1 = a1.x, y1 = a1.y, x2 = b1.x, y2 = b1.y;
-    float x3 = a2.x, y3 = a2.y, x4 = b2.x, y4 = b2.y;
-    float denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
-    if (std::abs(denom) < 1e-6f)
+    // Song song (hoặc suy biến) chỉ khi tích có hướng của 2 vector chỉ phương ĐÚNG bằng 0
+    if (pred::crossSign(a1, b1, a2, b2) == 0)
         return false;
-    outI.x = ((x1 * y2 - y1 * x2) * (x3 - x4) - (x1 - x2) * (x3 * y4 - y3 * x4)) / denom;
-    outI.y = ((x1 * y2 - y1 * x2) * (y3 - y4) - (y1 - y2) * (x3 * y4 - y3 * x4)) / denom;
+    // Tính tương đối so với a1 để giữ độ chính xác ở tọa độ lớn
+    double d1x = b1.x - a1.x, d1y = b1.y - a1.y;
+    double d2x = b2.x - a2.x, d2y = b2.y - a2.y;
+    double ex = a2.x - a1.x, ey = a2.y - a1.y;
+    double denom = d1x * d2y - d1y * d2x;
+    double t = (ex * d2y - ey * d2x) / denom;
+    double ix = a1.x + t * d1x, iy = a1.y + t * d1y;
+    // Gần song song: giao điểm có thể tràn số
+    if (!std::isfinite(ix) || !std::isfinite(iy))
+        return false;
+    outI = {ix, iy};
     return true;
 }
 
 // Lấy vector đơn vị (Normalize)
 Vec2 normalizeVec(Vec2 v)
 {
-    float len = std::sqrt(v.x * v.x + v.y * v.y);
-    if (len < 1e-6f)
+    double len = std::sqrt(v.x * v.x + v.y * v.y);
+    if (len == 0.0)
         return {0, 0};
     return {v.x / len, v.y / len};
 }
@@ -74,75 +167,80 @@ float getAngleBetweenLines(Vec2 a1, Vec2 b1, Vec2 a2, Vec2 b2)
 {
     Vec2 v1 = {b1.x - a1.x, b1.y - a1.y};
     Vec2 v2 = {b2.x - a2.x, b2.y - a2.y};
-    float dot = v1.x * v2.x + v1.y * v2.y;
-    float mag1 = std::sqrt(v1.x * v1.x + v1.y * v1.y);
-    float mag2 = std::sqrt(v2.x * v2.x + v2.y * v2.y);
+    double dot = v1.x * v2.x + v1.y * v2.y;
+    double mag1 = std::sqrt(v1.x * v1.x + v1.y * v1.y);
+    double mag2 = std::sqrt(v2.x * v2.x + v2.y * v2.y);
 
-    if (mag1 < 1e-6f || mag2 < 1e-6f)
+    if (mag1 == 0.0 || mag2 == 0.0)
         return 0.0f;
 
     // cos(theta) = |v1.v2| / (|v1|.|v2|) -> Lấy trị tuyệt đối để luôn có góc nhọn/vuông (0-90)
     // Nhưng đề bài yêu cầu 0-180, thường trong hình học phẳng ta lấy góc không tù:
-    float cosTheta = std::abs(dot) / (mag1 * mag2);
-    if (cosTheta > 1.0f)
-        cosTheta = 1.0f;
-    return std::acos(cosTheta) * 180.0f / 3.14159265f;
+    double cosTheta = std::abs(dot) / (mag1 * mag2);
+    if (cosTheta > 1.0)
+        cosTheta = 1.0;
+    return (float)(std::acos(cosTheta) * 180.0 / 3.14159265358979323846);
 }
 
 // Quay điểm quanh tâm
 Vec2 rotatePoint(Vec2 p, Vec2 center, float angleDeg)
 {
-    float rad = angleDeg * 3.14159265f / 180.0f;
-    float s = std::sin(rad);
-    float c = std::cos(rad);
+    double rad = angleDeg * 3.14159265358979323846 / 180.0;
+    double s = std::sin(rad);
+    double c = std::cos(rad);
     // Tịnh tiến về tâm O(0,0)
-    float x = p.x - center.x;
-    float y = p.y - center.y;
+    double x = p.x - center.x;
+    double y = p.y - center.y;
     // Áp dụng ma trận quay và tịnh tiến ngược lại
     return {x * c - y * s + center.x, x * s + y * c + center.y};
 }
 
 // Khoảng cách từ điểm p đến đoạn thẳng ab
-float distToSegment(Vec2 p, Vec2 a, Vec2 b)
+double distToSegment(Vec2 p, Vec2 a, Vec2 b)
 {
     Vec2 ab = {b.x - a.x, b.y - a.y};
     Vec2 ap = {p.x - a.x, p.y - a.y};
-    float l2 = ab.x * ab.x + ab.y * ab.y;
-    if (l2 == 0.0f)
+    double l2 = ab.x * ab.x + ab.y * ab.y;
+    if (l2 == 0.0)
         return std::sqrt(distSq(p, a));
-    float t = (ap.x * ab.x + ap.y * ab.y) / l2;
-    t = std::max(0.0f, std::min(1.0f, t));
+    double t = (ap.x * ab.x + ap.y * ab.y) / l2;
+    t = std::max(0.0, std::min(1.0, t));
     Vec2 projection = {a.x + t * ab.x, a.y + t * ab.y};
     return std::sqrt(distSq(p, projection));
 }
 
 // Tính đường tròn ngoại tiếp qua 3 điểm
-bool calculateCircumcircle(Vec2 p1, Vec2 p2, Vec2 p3, Vec2 &center, float &radius)
+bool calculateCircumcircle(Vec2 p1, Vec2 p2, Vec2 p3, Vec2 &center, double &radius)
 {
-    float x1 = p1.x, y1 = p1.y;
-    float x2 = p2.x, y2 = p2.y;
-    float x3 = p3.x, y3 = p3.y;
-
-    float D = 2 * (x1 * (y2 - y3) + x2 * (y3 - y1) + x3 * (y1 - y2));
-    if (std::abs(D) < 1e-6f)
-        return false; // 3 điểm thẳng hàng
-
-    center.x = ((x1 * x1 + y1 * y1) * (y2 - y3) + (x2 * x2 + y2 * y2) * (y3 - y1) + (x3 * x3 + y3 * y3) * (y1 - y2)) / D;
-    center.y = ((x1 * x1 + y1 * y1) * (x3 - x2) + (x2 * x2 + y2 * y2) * (x1 - x3) + (x3 * x3 + y3 * y3) * (x2 - x1)) / D;
-    radius = std::sqrt((center.x - x1) * (center.x - x1) + (center.y - y1) * (center.y - y1));
+    if (pred::orient2d(p1, p2, p3) == 0)
+        return false; // 3 điểm thẳng hàng (kiểm tra chính xác)
+
+    // Tính trong hệ tọa độ gốc p1 (tránh khử số khi tọa độ lớn)
+    double bx = p2.x - p1.x, by = p2.y - p1.y;
+    double cx = p3.x - p1.x, cy = p3.y - p1.y;
+    double D = 2.0 * (bx * cy - by * cx);
+    double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+    double ux = (cy * b2 - by * c2) / D;
+    double uy = (bx * c2 - cx * b2) / D;
+    double r = std::sqrt(ux * ux + uy * uy);
+    // Gần thẳng hàng: tâm ở rất xa, bán kính vô nghĩa (hoặc tràn số)
+    if (!(r < 1e30))
+        return false;
+    center = {p1.x + ux, p1.y + uy};
+    radius = r;
     return true;
 }
 
 // Tính trung điểm
 Vec2 getMidpoint(Vec2 a, Vec2 b)
 {
-    return {(a.x + b.x) / 2.0f, (a.y + b.y) / 2.0f};
+    return {(a.x + b.x) / 2.0, (a.y + b.y) / 2.0};
 }
 
 // Đối xứng điểm qua điểm: P' = 2*I - P
 Vec2 reflectPointPoint(Vec2 p, Vec2 center)
 {
-    return {2.0f * center.x - p.x, 2.0f * center.y - p.y};
+    return {2.0 * center.x - p.x, 2.0 * center.y - p.y};
 }
 
 // Đối xứng điểm qua đường thẳng
@@ -150,20 +248,29 @@ Vec2 reflectPointLine(Vec2 p, Vec2 a, Vec2 b)
 {
     Vec2 ab = {b.x - a.x, b.y - a.y};
     Vec2 ap = {p.x - a.x, p.y - a.y};
-    float l2 = ab.x * ab.x + ab.y * ab.y;
-    if (l2 == 0.0f)
+    double l2 = ab.x * ab.x + ab.y * ab.y;
+    if (l2 == 0.0)
         return p;
-    float t = (ap.x * ab.x + ap.y * ab.y) / l2;
+    double t = (ap.x * ab.x + ap.y * ab.y) / l2;
     Vec2 projection = {a.x + t * ab.x, a.y + t * ab.y};
     // P' = P + 2*(Projection - P) = 2*Projection - P
-    return {2.0f * projection.x - p.x, 2.0f * projection.y - p.y};
+    return {2.0 * projection.x - p.x, 2.0 * projection.y - p.y};
 }
 
 // ---- Data Structures ----
 enum AppMode
 {
     MODE_NAV = 0,
-    MODE_POINT = 1
+    MODE_POINT = 1,
+    MODE_SELECT = 2 // Chọn nhiều hình: khung chọn / lasso, kéo để di chuyển cả nhóm
+};
+
+// Cách gộp kết quả chọn mới với vùng chọn hiện có
+enum SelectOp
+{
+    SEL_REPLACE = 0,
+    SEL_ADD,   // Shift
+    SEL_TOGGLE // Ctrl
 };
 
 enum PointMode
@@ -214,167 +321,350 @@ struct Shape
     Color color{0.0f, 0.4f, 1.0f};
     Vec2 p1{0.0f, 0.0f}, p2{0.0f, 0.0f};
     float pointSize = 6.0f;
-    float radius = 0.0f;
-    float a = 0.0f, b = 0.0f;
-    float angle = 0.0f;
-    float paramA = 0.0f;
+    // Tham số hình bằng double như Vec2: bán kính float (sai số ~6e-8) làm đường tròn qua 3 điểm lệch khỏi các điểm khi zoom sâu
+    double radius = 0.0;
+    double a = 0.0, b = 0.0;
+    double angle = 0.0;
+    double paramA = 0.0;
     bool isVertical = true;
-    float parab_xmin = -1.0f, parab_xmax = 1.0f;
-    float hyper_a = 1.0f, hyper_b = 0.5f;
+    double parab_xmin = -1.0, parab_xmax = 1.0;
+    double hyper_a = 1.0, hyper_b = 0.5;
     std::vector<Vec2> poly;
+    // Kim tự tháp LOD dựng lười cho polyline lớn; chia sẻ giữa các bản sao (Undo).
+    // Phải reset về nullptr mỗi khi sửa poly (nối thêm đỉnh thì dùng extendPolylineCaches).
+    mutable std::shared_ptr<PolylineLOD> lod;
+    // Chỉ mục khúc (BVH) cho hit-test/culling, cũng dựng lười và chia sẻ như lod
+    mutable std::shared_ptr<PolylineIndex> index;
     int segments = 64;
     std::string name = ""; // Tên hiển thị (VD: "A", "B")
     bool showName = true;  // Mặc định là hiện tên
 };
 
-std::string getNextPointName(const std::vector<Shape> &shapes)
+// Danh sách hình: duyệt theo chỉ số dày như vector, xóa O(1); các bước dựng hình nhiều lần click
+// giữ hình đã chọn bằng SlotHandle nên không bị lệch khi có hình khác bị xóa
+using ShapeStore = SlotMap<Shape>;
+
+// Lấy (hoặc dựng) LOD cho polyline; nullptr nếu polyline đủ nhỏ để xử lý trực tiếp
+static const PolylineLOD *getPolylineLOD(const Shape &s)
+{
+    if (s.kind != SH_POLYLINE || s.poly.size() < PolylineLOD::MIN_VERTICES)
+        return nullptr;
+    if (!s.lod || s.lod->sourceSize() != s.poly.size())
+        s.lod = std::make_shared<PolylineLOD>(s.poly);
+    return s.lod.get();
+}
+
+// Lấy (hoặc dựng) chỉ mục khúc cho polyline; nullptr nếu polyline đủ nhỏ
+static const PolylineIndex *getPolylineIndex(const Shape &s)
+{
+    if (s.kind != SH_POLYLINE || s.poly.size() < PolylineIndex::MIN_VERTICES)
+        return nullptr;
+    if (!s.index || s.index->sourceSize() != s.poly.size())
+        s.index = std::make_shared<PolylineIndex>(s.poly);
+    return s.index.get();
+}
+
+// Cập nhật tăng dần LOD/chỉ mục sau khi nối thêm đỉnh vào cuối poly (copy-on-write nếu đang chia sẻ)
+static void extendPolylineCaches(Shape &s)
+{
+    if (s.lod && s.lod->sourceSize() < s.poly.size())
+    {
+        if (s.lod.use_count() > 1)
+            s.lod = std::make_shared<PolylineLOD>(*s.lod);
+        s.lod->append(s.poly);
+    }
+    if (s.index && s.index->sourceSize() < s.poly.size())
+    {
+        if (s.index.use_count() > 1)
+            s.index = std::make_shared<PolylineIndex>(*s.index);
+        s.index->append(s.poly);
+    }
+}
+
+// ---- Biến đổi & hộp chọn cho thao tác hàng loạt ----
+
+// Phép đồng dạng: quay angleDeg và co giãn scale quanh pivot, sau đó tịnh tiến offset
+struct ShapeTransform
+{
+    Vec2 pivot{0.0, 0.0};
+    double angleDeg = 0.0;
+    double scale = 1.0;
+    Vec2 offset{0.0, 0.0};
+};
+
+static void transformShape(Shape &s, const ShapeTransform &tf)
 {
-    std::set<std::string> usedNames;
-    for (const auto &s : shapes)
+    if (tf.angleDeg == 0.0 && tf.scale == 1.0)
+    {
+        // Chỉ tịnh tiến: cộng thẳng (không qua pivot) và dịch luôn LOD/chỉ mục thay vì dựng lại
+        double dx = tf.offset.x, dy = tf.offset.y;
+        s.p1 = {s.p1.x + dx, s.p1.y + dy};
+        s.p2 = {s.p2.x + dx, s.p2.y + dy};
+        for (Vec2 &v : s.poly)
+            v = {v.x + dx, v.y + dy};
+        if (s.lod)
+        {
+            if (s.lod.use_count() > 1)
+                s.lod = std::make_shared<PolylineLOD>(*s.lod);
+            s.lod->translate(dx, dy);
+        }
+        if (s.index)
+        {
+            if (s.index.use_count() > 1)
+                s.index = std::make_shared<PolylineIndex>(*s.index);
+            s.index->translate(dx, dy);
+        }
+        return;
+    }
+
+    double rad = tf.angleDeg * 3.14159265358979323846 / 180.0;
+    double c = std::cos(rad) * tf.scale, sn = std::sin(rad) * tf.scale;
+    auto map = [&](Vec2 p) -> Vec2
+    {
+        double x = p.x - tf.pivot.x, y = p.y - tf.pivot.y;
+        return {tf.pivot.x + c * x - sn * y + tf.offset.x, tf.pivot.y + sn * x + c * y + tf.offset.y};
+    };
+    s.p1 = map(s.p1);
+    s.p2 = map(s.p2);
+    for (Vec2 &v : s.poly)
+        v = map(v);
+    s.lod = nullptr;
+    s.index = nullptr;
+
+    double k = tf.scale;
+    s.radius *= k;
+    s.a *= k;
+    s.b *= k;
+    s.paramA *= k;
+    s.hyper_a *= k;
+    s.hyper_b *= k;
+    if (s.kind == SH_ELLIPSE)
+        s.angle += rad;
+
+    // Parabola/Hyperbola chỉ có 2 hướng (đứng/nằm): quay đúng bội số 90 độ thì đổi hướng,
+    // góc khác chỉ di chuyển đỉnh/tâm
+    double q = std::round(tf.angleDeg / 90.0);
+    if ((s.kind == SH_PARABOLA || s.kind == SH_HYPERBOLA) && std::abs(tf.angleDeg - 90.0 * q) < 1e-9)
     {
-        if (s.kind == SH_POINT && !s.name.empty())
+        int turns = (((int)std::fmod(q, 4.0)) + 4) % 4;
+        for (int i = 0; i < turns; ++i)
         {
-            usedNames.insert(s.name);
+            // Quay 90 độ ngược chiều kim đồng hồ: x^2=4ay -> y^2=-4ax, y^2=4ax -> x^2=4ay
+            if (s.kind == SH_PARABOLA && s.isVertical)
+                s.paramA = -s.paramA;
+            s.isVertical = !s.isVertical;
         }
     }
+}
 
-    // Thử A -> Z
-    for (char c = 'A'; c <= 'Z'; ++c)
+// Hộp dùng cho khung chọn: hộp bao thật với hình hữu hạn; với hình vô hạn (đường thẳng, tia,
+// parabola, hyperbola) là hộp của các điểm xác định hình
+static SceneIndex::Box shapeSelectBox(const Shape &s)
+{
+    switch (s.kind)
+    {
+    case SH_LINE:
+    case SH_INFINITE_LINE:
+    case SH_RAY:
+        return {std::min(s.p1.x, s.p2.x), std::min(s.p1.y, s.p2.y), std::max(s.p1.x, s.p2.x), std::max(s.p1.y, s.p2.y)};
+    case SH_CIRCLE:
+        return {s.p1.x - s.radius, s.p1.y - s.radius, s.p1.x + s.radius, s.p1.y + s.radius};
+    case SH_ELLIPSE:
     {
-        std::string name(1, c);
-        if (usedNames.find(name) == usedNames.end())
-            return name;
+        double ca = std::cos(s.angle), sa = std::sin(s.angle);
+        double hx = std::sqrt(s.a * s.a * ca * ca + s.b * s.b * sa * sa);
+        double hy = std::sqrt(s.a * s.a * sa * sa + s.b * s.b * ca * ca);
+        return {s.p1.x - hx, s.p1.y - hy, s.p1.x + hx, s.p1.y + hy};
+    }
+    case SH_POLYLINE:
+    {
+        if (s.poly.empty())
+            return {s.p1.x, s.p1.y, s.p1.x, s.p1.y};
+        if (s.index && s.index->sourceSize() == s.poly.size())
+        {
+            PolylineIndex::Box bx = s.index->bounds();
+            return {bx.minX, bx.minY, bx.maxX, bx.maxY};
+        }
+        SceneIndex::Box bx{s.poly[0].x, s.poly[0].y, s.poly[0].x, s.poly[0].y};
+        for (const Vec2 &v : s.poly)
+        {
+            bx.minX = std::min(bx.minX, v.x);
+            bx.maxX = std::max(bx.maxX, v.x);
+            bx.minY = std::min(bx.minY, v.y);
+            bx.maxY = std::max(bx.maxY, v.y);
+        }
+        return bx;
+    }
+    default:
+        return {s.p1.x, s.p1.y, s.p1.x, s.p1.y};
     }
+}
 
-    // Thử A1 -> Z99 (Dự phòng)
-    for (int i = 1; i < 100; ++i)
+// Hình nằm trọn trong lasso: xét các điểm mẫu trên viền (đỉnh polyline, 16 điểm trên tròn/elip)
+// hoặc các điểm xác định hình vô hạn
+static bool shapeInLasso(const Shape &s, const std::vector<Vec2> &lasso)
+{
+    switch (s.kind)
     {
-        for (char c = 'A'; c <= 'Z'; ++c)
+    case SH_LINE:
+    case SH_INFINITE_LINE:
+    case SH_RAY:
+        return pointInPolygon(lasso, s.p1) && pointInPolygon(lasso, s.p2);
+    case SH_CIRCLE:
+    case SH_ELLIPSE:
+    {
+        double ra = (s.kind == SH_CIRCLE) ? s.radius : s.a;
+        double rb = (s.kind == SH_CIRCLE) ? s.radius : s.b;
+        double ang = (s.kind == SH_CIRCLE) ? 0.0 : s.angle;
+        for (int i = 0; i < 16; ++i)
         {
-            std::string name = std::string(1, c) + std::to_string(i);
-            if (usedNames.find(name) == usedNames.end())
-                return name;
+            double th = 2.0 * 3.14159265358979323846 * i / 16.0;
+            double x0 = ra * std::cos(th), y0 = rb * std::sin(th);
+            Vec2 p = {s.p1.x + x0 * std::cos(ang) - y0 * std::sin(ang), s.p1.y + x0 * std::sin(ang) + y0 * std::cos(ang)};
+            if (!pointInPolygon(lasso, p))
+                return false;
         }
+        return true;
+    }
+    case SH_POLYLINE:
+        for (const Vec2 &v : s.poly)
+            if (!pointInPolygon(lasso, v))
+                return false;
+        return !s.poly.empty();
+    default:
+        return pointInPolygon(lasso, s.p1);
     }
+}
+
+// ---- Bộ đếm truy vấn (Hover/Snap) ----
+// Reset mỗi frame, dùng để kiểm tra culling/index có thực sự giảm số phép thử
+struct QueryStats
+{
+    size_t shapesTested = 0;      // Số hình đưa vào getDistToShape
+    size_t segmentsEvaluated = 0; // Số đoạn thẳng tính khoảng cách
+    size_t snapPointsTested = 0;  // Số điểm xét trong getClosestSnapPoint
+    size_t cursorEvents = 0;      // Số sự kiện di chuột nhận từ GLFW
+    size_t cursorUpdates = 0;     // Số lần thực sự chạy hover/snap (tối đa ~1 mỗi frame)
+};
+
+static QueryStats g_queryStats;
+
+const QueryStats &getQueryStats()
+{
+    return g_queryStats;
+}
 
-    return "P?"; // Fallback cuối cùng
+void resetQueryStats()
+{
+    g_queryStats = QueryStats();
 }
 
 // Hàm tính khoảng cách từ chuột đến hình (cho chức năng Selection)
+// Các chuỗi mẫu lưu tọa độ tương đối so với p nên kết quả vẫn chính xác khi zoom sâu
 float getDistToShape(const Shape &s, Vec2 p)
 {
+    // Bộ đệm SoA dùng lại giữa các lần gọi cho polyline nhỏ và đường cong lấy mẫu
+    thread_local SegmentChain chain;
+    g_queryStats.shapesTested++;
     switch (s.kind)
     {
     case SH_POINT:
         return std::sqrt(distSq(s.p1, p));
     case SH_LINE:
+        g_queryStats.segmentsEvaluated++;
         return distToSegment(p, s.p1, s.p2);
     case SH_CIRCLE:
         // Khoảng cách tới đường viền tròn
         return std::abs(std::sqrt(distSq(s.p1, p)) - s.radius);
     case SH_POLYLINE:
     {
-        float minDist = 1e9;
         if (s.poly.size() < 2)
             return 1e9;
-        for (size_t i = 0; i < s.poly.size() - 1; ++i)
-        {
-            float d = distToSegment(p, s.poly[i], s.poly[i + 1]);
-            if (d < minDist)
-                minDist = d;
-        }
-        return minDist;
+        if (const PolylineIndex *index = getPolylineIndex(s))
+            return index->distance(s.poly, p, &g_queryStats.segmentsEvaluated);
+        g_queryStats.segmentsEvaluated += s.poly.size() - 1;
+        chain.assign(s.poly.data(), s.poly.size(), p);
+        return nearestSegment(chain, p).dist;
     }
     case SH_ELLIPSE:
     {
         // Lấy mẫu xấp xỉ để tính khoảng cách
         int checkSegments = 500;
-        float minDist = 1e9;
-        Vec2 prev;
+        g_queryStats.segmentsEvaluated += checkSegments;
+        chain.clear(p);
         for (int i = 0; i <= checkSegments; ++i)
         {
-            float theta = 2.0f * 3.14159f * i / float(checkSegments);
-            float x0 = s.a * cos(theta);
-            float y0 = s.b * sin(theta);
-            Vec2 curr = {
-                s.p1.x + x0 * cosf(s.angle) - y0 * sinf(s.angle),
-                s.p1.y + x0 * sinf(s.angle) + y0 * cosf(s.angle)};
-            if (i > 0)
-                minDist = std::min(minDist, distToSegment(p, prev, curr));
-            prev = curr;
+            double theta = 2.0 * 3.14159265358979323846 * i / (double)checkSegments;
+            double x0 = s.a * std::cos(theta);
+            double y0 = s.b * std::sin(theta);
+            chain.push({s.p1.x + x0 * std::cos(s.angle) - y0 * std::sin(s.angle),
+                        s.p1.y + x0 * std::sin(s.angle) + y0 * std::cos(s.angle)});
         }
-        return minDist;
+        return nearestSegment(chain, p).dist;
     }
     case SH_PARABOLA:
     {
-        float minDist = 1e9f;
-        float range = 10.0f;  // Phạm vi kiểm tra (nên khớp với range lúc vẽ)
+        double range = 10.0;  // Phạm vi kiểm tra (nên khớp với range lúc vẽ)
         int checkSegs = 2000; // Số lượng đoạn thẳng dùng để xấp xỉ khoảng cách
-        Vec2 prev;
+        g_queryStats.segmentsEvaluated += checkSegs;
+        chain.clear(p);
 
         for (int i = 0; i <= checkSegs; ++i)
         {
             // Biến chạy t từ -range đến range
-            float t = -range + (float)i * (2.0f * range / (float)checkSegs);
-            float dx, dy;
+            double t = -range + (double)i * (2.0 * range / (double)checkSegs);
+            double dx, dy;
 
             if (s.isVertical)
             {
                 // x^2 = 4ay => y = x^2 / 4a. Biến chạy là x (t)
                 dx = t;
-                dy = (t * t) / (4.0f * s.paramA);
+                dy = (t * t) / (4.0 * s.paramA);
             }
             else
             {
                 // y^2 = 4ax => x = y^2 / 4a. Biến chạy là y (t)
                 dy = t;
-                dx = (t * t) / (4.0f * s.paramA);
+                dx = (t * t) / (4.0 * s.paramA);
             }
 
             // Tọa độ điểm hiện tại trên đường cong (đã cộng offset Đỉnh p1)
-            Vec2 curr = {s.p1.x + dx, s.p1.y + dy};
-
-            if (i > 0)
-            {
-                // Tính khoảng cách từ chuột tới đoạn thẳng nối từ điểm trước tới điểm này
-                minDist = std::min(minDist, distToSegment(p, prev, curr));
-            }
-            prev = curr;
+            chain.push({s.p1.x + dx, s.p1.y + dy});
         }
-        return minDist;
+        // Khoảng cách từ chuột tới các đoạn thẳng nối các điểm mẫu liên tiếp
+        return nearestSegment(chain, p).dist;
     }
     break;
     case SH_HYPERBOLA:
     {
         float minDist = 1e9f;
-        auto checkBranch = [&](float sign)
+        auto checkBranch = [&](double sign)
         {
-            Vec2 prev;
-            float t_range = 5.0f; // cosh(5) ~ 74, đủ bao phủ màn hình
+            chain.clear(p);
+            double t_range = 5.0; // cosh(5) ~ 74, đủ bao phủ màn hình
             int steps = 50;
+            g_queryStats.segmentsEvaluated += steps;
             for (int i = 0; i <= steps; ++i)
             {
-                float t = -t_range + (float)i * (2.0f * t_range / (float)steps);
-                float dx, dy;
+                double t = -t_range + (double)i * (2.0 * t_range / (double)steps);
+                double dx, dy;
                 if (s.isVertical)
                 {
                     // Dùng hyper_a, hyper_b theo yêu cầu của bạn
-                    dx = s.hyper_a * sinhf(t);
-                    dy = sign * s.hyper_b * coshf(t);
+                    dx = s.hyper_a * std::sinh(t);
+                    dy = sign * s.hyper_b * std::cosh(t);
                 }
                 else
                 {
-                    dx = sign * s.hyper_a * coshf(t);
-                    dy = s.hyper_b * sinhf(t);
+                    dx = sign * s.hyper_a * std::cosh(t);
+                    dy = s.hyper_b * std::sinh(t);
                 }
-                Vec2 curr = {s.p1.x + dx, s.p1.y + dy};
-                if (i > 0)
-                    minDist = std::min(minDist, distToSegment(p, prev, curr));
-                prev = curr;
+                chain.push({s.p1.x + dx, s.p1.y + dy});
             }
+            minDist = std::min(minDist, nearestSegment(chain, p).dist);
         };
-        checkBranch(1.0f);  // Nhánh 1
-        checkBranch(-1.0f); // Nhánh 2
+        checkBranch(1.0);  // Nhánh 1
+        checkBranch(-1.0); // Nhánh 2
         return minDist;
     }
     break;
@@ -384,10 +674,10 @@ float getDistToShape(const Shape &s, Vec2 p)
         // Khoảng cách từ điểm p đến đường thẳng đi qua s.p1, s.p2 (không giới hạn đầu mút)
         Vec2 ab = {s.p2.x - s.p1.x, s.p2.y - s.p1.y};
         Vec2 ap = {p.x - s.p1.x, p.y - s.p1.y};
-        float l2 = ab.x * ab.x + ab.y * ab.y;
-        if (l2 == 0.0f)
+        double l2 = ab.x * ab.x + ab.y * ab.y;
+        if (l2 == 0.0)
             return std::sqrt(distSq(p, s.p1));
-        float t = (ap.x * ab.x + ap.y * ab.y) / l2;
+        double t = (ap.x * ab.x + ap.y * ab.y) / l2;
         // Không ép t vào khoảng [0, 1] vì là đường thẳng vô hạn
         Vec2 projection = {s.p1.x + t * ab.x, s.p1.y + t * ab.y};
         return std::sqrt(distSq(p, projection));
@@ -396,11 +686,11 @@ float getDistToShape(const Shape &s, Vec2 p)
     {
         Vec2 ab = {s.p2.x - s.p1.x, s.p2.y - s.p1.y};
         Vec2 ap = {p.x - s.p1.x, p.y - s.p1.y};
-        float l2 = ab.x * ab.x + ab.y * ab.y;
-        if (l2 == 0.0f)
+        double l2 = ab.x * ab.x + ab.y * ab.y;
+        if (l2 == 0.0)
             return std::sqrt(distSq(p, s.p1));
-        float t = (ap.x * ab.x + ap.y * ab.y) / l2;
-        t = std::max(0.0f, t); // t >= 0 để tạo thành Tia xuất phát từ p1
+        double t = (ap.x * ab.x + ap.y * ab.y) / l2;
+        t = std::max(0.0, t); // t >= 0 để tạo thành Tia xuất phát từ p1
         Vec2 projection = {s.p1.x + t * ab.x, s.p1.y + t * ab.y};
         return std::sqrt(distSq(p, projection));
     }
@@ -409,81 +699,122 @@ float getDistToShape(const Shape &s, Vec2 p)
     }
 }
 
-static void drawShape(const Shape &s, GeometryRenderer &geom)
+// Vẽ hình với màu/cỡ điểm cho trước (dùng cho highlight mà không phải copy Shape)
+static void drawShape(const Shape &s, GeometryRenderer &geom, const Color &color, float pointSize)
 {
     switch (s.kind)
     {
     case SH_POINT:
-        geom.drawPoint(s.p1, s.color, s.pointSize);
+        geom.drawPoint(s.p1, color, pointSize);
         break;
     case SH_LINE:
-        geom.drawLine(s.p1, s.p2, s.color);
+        geom.drawLine(s.p1, s.p2, color);
         break;
     case SH_CIRCLE:
-        geom.drawCircle(s.p1, s.radius, s.color, s.segments);
+        geom.drawCircle(s.p1, s.radius, color, s.segments);
         break;
     case SH_ELLIPSE:
-        geom.drawEllipse(s.p1, s.a, s.b, s.angle, s.color, s.segments);
+        geom.drawEllipse(s.p1, s.a, s.b, s.angle, color, s.segments);
         break;
     case SH_PARABOLA:
     {
-        float l, r, b, t;
+        double l, r, b, t;
         geom.getView(l, r, b, t);
 
         // Tính toán tầm nhìn hiện tại của người dùng
-        float viewWidth = (r - l);
-        float viewHeight = (t - b);
+        double viewWidth = (r - l);
+        double viewHeight = (t - b);
 
         // Range tự động bằng 2 lần tầm nhìn để đảm bảo luôn tràn màn hình
-        float dynamicRange = std::max(viewWidth, viewHeight) * 2.0f;
+        float dynamicRange = (float)(std::max(viewWidth, viewHeight) * 2.0);
 
         // Luôn dùng ít nhất 2000 điểm để cực mịn kể cả khi zoom xa
-        geom.drawParabola(s.p1, s.paramA, s.isVertical, dynamicRange, 2000, s.color);
+        geom.drawParabola(s.p1, s.paramA, s.isVertical, dynamicRange, 2000, color);
     }
     break;
     case SH_HYPERBOLA:
     {
-        float l, r, b, t;
+        double l, r, b, t;
         geom.getView(l, r, b, t);
-        float dynamicRange = std::max(r - l, t - b); // Lấy phạm vi nhìn thấy
+        float dynamicRange = (float)std::max(r - l, t - b); // Lấy phạm vi nhìn thấy
 
-        geom.drawHyperbola(s.p1, s.hyper_a, s.hyper_b, s.isVertical, dynamicRange, 2000, s.color);
+        geom.drawHyperbola(s.p1, s.hyper_a, s.hyper_b, s.isVertical, dynamicRange, 2000, color);
     }
     break;
     case SH_POLYLINE:
-        geom.drawPolyline(s.poly, s.color);
-        break;
+    {
+        // Polyline lớn: chọn level có sai số dưới nửa pixel
+        const PolylineLOD *lod = getPolylineLOD(s);
+        size_t level = lod ? lod->pickLevel(0.5 * geom.pixelSize()) : 0;
+        if (level > 0)
+        {
+            geom.drawPolyline(lod->level(level).pts, color);
+            break;
+        }
+        const PolylineIndex *index = getPolylineIndex(s);
+        if (!index)
+        {
+            geom.drawPolyline(s.poly, color);
+            break;
+        }
+        // Độ phân giải gốc: chỉ vẽ các khúc trong khung nhìn, gộp các khúc liền nhau thành 1 lần vẽ
+        double l, r, b, t;
+        geom.getView(l, r, b, t);
+        size_t runBegin = 0, runEnd = 0;
+        bool hasRun = false;
+        index->forEachChunkInView(l, b, r, t, [&](size_t c)
+                                  {
+            if (hasRun && index->chunkBegin(c) == runEnd)
+            {
+                runEnd = index->chunkEnd(c);
+                return;
+            }
+            if (hasRun)
+                geom.drawPolyline(&s.poly[runBegin], runEnd - runBegin + 1, color);
+            runBegin = index->chunkBegin(c);
+            runEnd = index->chunkEnd(c);
+            hasRun = true; });
+        if (hasRun)
+            geom.drawPolyline(&s.poly[runBegin], runEnd - runBegin + 1, color);
+    }
+    break;
     case SH_INFINITE_LINE:
     {
-        float l, r, b, t;
+        double l, r, b, t;
         geom.getView(l, r, b, t);
-        float dynamicRange = std::max(r - l, t - b) * 5.0f; // Kéo dài gấp 5 lần tầm nhìn
+        double dynamicRange = std::max(r - l, t - b) * 5.0; // Kéo dài gấp 5 lần tầm nhìn
         Vec2 dir = {s.p2.x - s.p1.x, s.p2.y - s.p1.y};
-        float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
-        if (len > 1e-6f)
+        double len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+        if (len > 0.0)
         {
             dir.x /= len;
             dir.y /= len;
-            Vec2 start = {s.p1.x - dir.x * dynamicRange, s.p1.y - dir.y * dynamicRange};
-            Vec2 end = {s.p1.x + dir.x * dynamicRange, s.p1.y + dir.y * dynamicRange};
-            geom.drawLine(start, end, s.color);
+            // Kéo dài quanh hình chiếu của tâm khung nhìn lên đường thẳng (p1 có thể ở rất xa khi zoom sâu)
+            double tc = (0.5 * (l + r) - s.p1.x) * dir.x + (0.5 * (b + t) - s.p1.y) * dir.y;
+            Vec2 start = {s.p1.x + dir.x * (tc - dynamicRange), s.p1.y + dir.y * (tc - dynamicRange)};
+            Vec2 end = {s.p1.x + dir.x * (tc + dynamicRange), s.p1.y + dir.y * (tc + dynamicRange)};
+            geom.drawLine(start, end, color);
         }
     }
     break;
 
     case SH_RAY:
     {
-        float l, r, b, t;
+        double l, r, b, t;
         geom.getView(l, r, b, t);
-        float dynamicRange = std::max(r - l, t - b) * 5.0f;
+        double dynamicRange = std::max(r - l, t - b) * 5.0;
         Vec2 dir = {s.p2.x - s.p1.x, s.p2.y - s.p1.y};
-        float len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
-        if (len > 1e-6f)
+        double len = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+        if (len > 0.0)
         {
             dir.x /= len;
             dir.y /= len;
-            Vec2 end = {s.p1.x + dir.x * dynamicRange, s.p1.y + dir.y * dynamicRange};
-            geom.drawLine(s.p1, end, s.color); // Gốc tại p1
+            // Như đường thẳng nhưng không vượt quá gốc p1
+            double tc = (0.5 * (l + r) - s.p1.x) * dir.x + (0.5 * (b + t) - s.p1.y) * dir.y;
+            double t0 = std::max(0.0, tc - dynamicRange), t1 = std::max(0.0, tc + dynamicRange);
+            Vec2 start = {s.p1.x + dir.x * t0, s.p1.y + dir.y * t0};
+            Vec2 end = {s.p1.x + dir.x * t1, s.p1.y + dir.y * t1};
+            geom.drawLine(start, end, color);
         }
     }
     break;
@@ -492,6 +823,29 @@ static void drawShape(const Shape &s, GeometryRenderer &geom)
     }
 }
 
+static void drawShape(const Shape &s, GeometryRenderer &geom)
+{
+    drawShape(s, geom, s.color, s.pointSize);
+}
+
+enum IoKind
+{
+    IO_NONE = 0,
+    IO_LOAD,
+    IO_SAVE,
+    IO_EXPORT, // Xuất SVG/PDF
+    IO_COMPUTE // Tính toán trên tập điểm (Delaunay/Voronoi...)
+};
+
+// Kết quả tính nền trên tập điểm, chờ thêm vào bản vẽ
+struct PointSetResult
+{
+    std::vector<Shape> shapes;
+    std::string status;
+};
+
+struct SceneData;
+
 enum Tool
 {
     TOOL_POINT = 0,
@@ -503,10 +857,55 @@ enum Tool
     TOOL_POLYLINE
 };
 
+// Một bản vẽ đang mở (1 tab, hoặc 1 cột khi chia màn hình), có hình, tên, vùng chọn, Undo/Redo và khung nhìn riêng.
+// Nội dung của bản vẽ ĐANG HOẠT ĐỘNG nằm thẳng trong AppState (mọi thao tác vẽ/chọn/Undo dùng app.shapes như cũ);
+// khi chuyển tab, nội dung được đổi chỗ (swap, O(1), không copy hình) giữa AppState và Document của nó.
+// Shader, VBO và bộ nhớ tạm của frame thuộc GeometryRenderer duy nhất nên mọi bản vẽ dùng chung;
+// cache LOD/chỉ mục nằm trong từng Shape (shared_ptr) nên bản vẽ nhân bản dùng chung cache cho tới khi hình bị sửa.
+struct Document
+{
+    int id = 0;                          // Định danh ổn định (ID của tab ImGui, tên file autosave doc<id>.*)
+    std::string title = "Untitled 1";
+    std::string filePath = "drawing.txt"; // Ô "File" của bản vẽ này
+    // Các trường dưới đây chỉ có nghĩa khi bản vẽ KHÔNG hoạt động (xem swapDocument)
+    ShapeStore shapes;
+    NameRegistry names;
+    std::vector<ShapeStore> undoStack;
+    std::vector<ShapeStore> redoStack;
+    std::vector<int> selection;
+    std::vector<uint8_t> selectedMask;
+    int selectedShapeIndex = -1;
+    double l = -2.0, r = 2.0, b = -1.5, t = 1.5; // Khung nhìn (World)
+    // Autosave riêng của bản vẽ (file doc<id>.* trong thư mục autosave của phiên), luôn đi theo tab dù nội dung bị swap
+    std::unique_ptr<Journal> journal;
+    bool autosaveNeedsSnapshot = false; // Scene bị thay toàn bộ (Undo/Redo/Load/nhân bản) -> nén ngay
+    std::chrono::steady_clock::time_point lastAutosaveSnapshot = std::chrono::steady_clock::now();
+};
+
+// Xuất ảnh lớn theo tile: bản sao bản vẽ + chỉ mục hộp bao để mỗi tile chỉ vẽ các hình chạm vào nó
+struct ImageExportJob
+{
+    TiledImageExport out;
+    std::vector<Shape> shapes;         // Bản sao lúc bắt đầu xuất (sửa bản vẽ trong lúc xuất không ảnh hưởng)
+    SceneIndex index;                  // Hộp bao (đã nới theo cỡ nét) của các hình hữu hạn
+    std::vector<int> bounded;          // bounded[id của index] = chỉ số hình
+    std::vector<int> unbounded;        // Đường thẳng, tia, parabola, hyperbola: vẽ ở mọi tile
+    std::vector<int> tileHits;         // Bộ đệm dùng lại cho từng tile
+    double l = 0, r = 0, b = 0, t = 0; // Vùng World của cả ảnh
+    double spacing = 1.0;              // Khoảng lưới tính theo cả ảnh (mọi tile như nhau)
+    // Tên điểm và nhãn trục vẽ vào từng tile qua draw list riêng (background draw list chỉ lên màn hình)
+    std::unique_ptr<ImDrawList> labels;
+    double labelMargin = 0;            // Tên điểm có thể tràn ra ngoài điểm tới mức này (pixel)
+    std::string path;
+};
+
 struct AppState
 {
     GeometryRenderer *geom = nullptr;
-    std::vector<Shape> shapes;
+    ShapeStore shapes;
+    NameRegistry names;     // Tên hình -> hình, sinh tên điểm tự động
+    std::string renameFrom; // Tên cũ của hình đang được sửa tên trong UI
+    std::string findName;   // Ô "Find" trong UI
     AppMode mode = MODE_NAV;
     Tool currentTool = TOOL_POINT;
 
@@ -525,51 +924,201 @@ struct AppState
     Vec2 hoverPos{0.0f, 0.0f};  // Tọa độ điểm bắt dính
 
     int hoveredShapeIndex = -1;  // Hình đang trỏ chuột vào (Hover)
-    int selectedShapeIndex = -1; // Hình đã click chọn (Selected)
+    int selectedShapeIndex = -1; // Hình đã click chọn (Selected); -1 khi chọn nhiều hình
+
+    // Chọn nhiều hình: chỉ số tăng dần, không trùng; selectedMask[i] != 0 nếu hình i đang được chọn
+    std::vector<int> selection;
+    std::vector<uint8_t> selectedMask;
+
+    // Khung chọn / lasso đang kéo (tọa độ World). Chỉ mục dựng 1 lần lúc bắt đầu kéo vì bản vẽ
+    // không đổi trong lúc kéo, sau đó mỗi lần chuột di chuyển chỉ là 1 truy vấn cây
+    bool bandActive = false;
+    bool bandLasso = false;
+    SelectOp bandOp = SEL_REPLACE;
+    Vec2 bandStart{0.0, 0.0}, bandEnd{0.0, 0.0};
+    std::vector<Vec2> lassoPts;
+    std::vector<int> bandHits; // Xem trước kết quả khung chọn
+    SceneIndex sceneIndex;
+
+    // Kéo di chuyển cả vùng chọn: Undo được lưu ở lần di chuyển đầu tiên
+    bool movingSelection = false;
+    bool moveUndoPushed = false;
+    Vec2 moveStart{0.0, 0.0}, moveLast{0.0, 0.0};
+
+    // Biến đổi vùng chọn nhập từ UI (quay/co giãn quanh tâm hộp bao vùng chọn)
+    double ui_moveDx = 0.0, ui_moveDy = 0.0;
+    float ui_selRotate = 0.0f;
+    float ui_selScale = 1.0f;
 
     // Params
     int circleSegments = 500;
     int ellipseSegments = 500;
-    float ellipse_a = 0.4f;
-    float ellipse_b = 0.4f;
+    double ellipse_a = 0.4;
+    double ellipse_b = 0.4;
     float ellipse_angle = 0.0f;
     bool ellipseCenterSet = false;
     int parab_segments = 500;
-    float ui_parabola_a = 1.0f;
+    double ui_parabola_a = 1.0;
     bool ui_parabola_vertical = true;
     bool parabolaVertexSet = false; // Đánh dấu đã chọn đỉnh
     float hyper_a = 0.4f, hyper_b = 0.25f;
     int hyper_segments = 500;
-    float ui_hyper_a = 1.0f;
-    float ui_hyper_b = 1.0f;
+    double ui_hyper_a = 1.0;
+    double ui_hyper_b = 1.0;
     bool ui_hyper_vertical = false;
     bool hyperbolaCenterSet = false;
 
-    std::vector<std::vector<Shape>> undoStack;
-    std::vector<std::vector<Shape>> redoStack;
+    std::vector<ShapeStore> undoStack;
+    std::vector<ShapeStore> redoStack;
     size_t maxUndo = 60;
 
     bool showGrid = true;
     bool showAxis = true;
+    bool showProfiler = false;
+    bool showStats = false;
+    bool renderOnDemand = true; // Tắt để vẽ liên tục mỗi vsync (đo profiler)
+    bool analyticConics = true; // Conic vẽ bằng fragment shader (tắt: chia đoạn như cũ, để so sánh)
+    PacingMode pacing = PACE_VSYNC;
+    bool measureLatency = false; // glFinish sau swap để đo độ trễ input -> hình
 
-    float inputX = 0.0f; // Biến lưu giá trị nhập X
-    float inputY = 0.0f; // Biến lưu giá trị nhập Y
+    double inputX = 0.0; // Biến lưu giá trị nhập X
+    double inputY = 0.0; // Biến lưu giá trị nhập Y
 
     PointMode pointMode = PT_CURSOR;
     int pointStep = 0;  // Bước thực hiện (chọn điểm 1, điểm 2...)
-    int savedIdx1 = -1; // Lưu index hình thứ nhất được chọn
-    int savedIdx2 = -1; // Lưu index hình thứ hai được chọn
+    SlotHandle savedShape1; // Hình thứ nhất được chọn (hết hạn nếu hình đó bị xóa)
+    SlotHandle savedShape2; // Hình thứ hai được chọn
 
     LineMode lineMode = LN_SEGMENT;
 
     CircleMode circleMode = CIR_CENTER_PT;
     int circlePointStep = 0;         // Đếm số điểm đã click
     Vec2 circlePoints[3];            // Lưu tạm 3 tọa độ click
-    float ui_circle_radius = 1.0f;   // Bán kính nhập từ UI
+    double ui_circle_radius = 1.0;   // Bán kính nhập từ UI
     float ui_rotation_angle = 90.0f; // Góc quay mặc định
     float calculatedAngle = -1.0f;   // Lưu kết quả tính góc
+
+    // Import polyline dạng stream: hình đang tải nằm ngoài shapes cho tới khi xong
+    PolylineStreamImporter importer;
+    bool importing = false;
+    Shape importShape;
+    std::string importError;
+
+    // Đọc/ghi bản vẽ ở luồng nền
+    AsyncTask ioTask;
+    IoKind ioKind = IO_NONE;
+    std::shared_ptr<SceneData> pendingScene;
+    std::shared_ptr<PointSetResult> pendingCompute; // Kết quả tính nền, thêm vào bản vẽ ở ranh giới frame
+    std::string ioStatus;
+
+    std::string computeStatus; // Kết quả lần tính giao điểm / tập điểm gần nhất
+
+    // Xuất ảnh PNG lớn (vùng đang nhìn, nới theo tỉ lệ ảnh)
+    ImageExportJob imageExport;
+    int ui_exportW = 8192, ui_exportH = 8192;
+    std::string exportStatus;
+
+    // Các bản vẽ đang mở; docs[activeDoc] chỉ giữ tiêu đề/đường dẫn, nội dung của nó là các trường ở trên
+    std::vector<Document> docs = std::vector<Document>(1);
+    int activeDoc = 0;
+    int nextDocId = 1;
+    bool splitView = false; // Hiện mọi bản vẽ cạnh nhau thay vì chỉ tab đang chọn
+
+    // Autosave: mỗi bản vẽ có nhật ký thao tác + snapshot định kỳ riêng (Document::journal)
+    AutosaveDir autosaveDir; // Thư mục autosave riêng của phiên (khóa suốt phiên)
 };
 
+// Nhật ký autosave của bản vẽ đang hoạt động (mọi thao tác sửa đều nhắm vào nó)
+static bool journaling(const AppState &app)
+{
+    const Document &doc = app.docs[app.activeDoc];
+    return doc.journal && doc.journal->isOpen();
+}
+
+static Journal &activeJournal(AppState &app)
+{
+    return *app.docs[app.activeDoc].journal;
+}
+
+// Bản vẽ đang hoạt động bị thay toàn bộ: snapshot lại thay vì ghi nhật ký
+static void requestAutosaveSnapshot(AppState &app)
+{
+    app.docs[app.activeDoc].autosaveNeedsSnapshot = true;
+}
+
+// ---- Vùng chọn ----
+static bool isSelected(const AppState &app, size_t i)
+{
+    return i < app.selectedMask.size() && app.selectedMask[i];
+}
+
+static void clearSelection(AppState &app)
+{
+    app.selection.clear();
+    app.selectedMask.clear();
+    app.selectedShapeIndex = -1;
+}
+
+// Dựng lại danh sách chọn từ mask trong 1 lượt
+static void selectionFromMask(AppState &app)
+{
+    app.selection.clear();
+    for (size_t i = 0; i < app.selectedMask.size(); ++i)
+        if (app.selectedMask[i])
+            app.selection.push_back((int)i);
+    app.selectedShapeIndex = (app.selection.size() == 1) ? app.selection[0] : -1;
+}
+
+// Gộp các hình hits (thứ tự bất kỳ, có thể trùng) vào vùng chọn theo op
+static void applySelectOp(AppState &app, const std::vector<int> &hits, SelectOp op)
+{
+    if (op == SEL_REPLACE)
+        app.selectedMask.assign(app.shapes.size(), 0);
+    else
+        app.selectedMask.resize(app.shapes.size(), 0);
+    for (int i : hits)
+    {
+        if (i < 0 || i >= (int)app.shapes.size())
+            continue;
+        if (op == SEL_TOGGLE)
+            app.selectedMask[i] ^= 1;
+        else
+            app.selectedMask[i] = 1;
+    }
+    selectionFromMask(app);
+}
+
+// Chọn đúng 1 hình (click ở chế độ Navigate/Draw); idx = -1 thì bỏ chọn
+static void selectSingle(AppState &app, int idx)
+{
+    clearSelection(app);
+    if (idx >= 0 && idx < (int)app.shapes.size())
+        applySelectOp(app, {idx}, SEL_REPLACE);
+}
+
+// Sau Undo/Redo số hình có thể giảm: bỏ các chỉ số không còn hợp lệ
+static void pruneSelection(AppState &app)
+{
+    if (app.selectedMask.size() <= app.shapes.size())
+        return;
+    app.selectedMask.resize(app.shapes.size());
+    selectionFromMask(app);
+}
+
+// Dựng lại bảng tên khi cả bản vẽ bị thay (Undo/Redo, mở file, khôi phục autosave)
+static void rebuildNames(AppState &app)
+{
+    app.names.clear();
+    for (size_t i = 0; i < app.shapes.size(); ++i)
+        app.names.add(app.shapes[i].name, app.shapes.handleAt(i));
+}
+
+// Tra hình theo tên O(1); -1 nếu không có
+int findShapeByName(const AppState &app, const std::string &name)
+{
+    return app.shapes.indexOf(app.names.find(name));
+}
+
 // Undo/Redo Helpers
 static void pushUndo(AppState &app)
 {
@@ -585,6 +1134,9 @@ static void doUndo(AppState &app)
     app.redoStack.push_back(app.shapes);
     app.shapes = std::move(app.undoStack.back());
     app.undoStack.pop_back();
+    pruneSelection(app);
+    rebuildNames(app);
+    requestAutosaveSnapshot(app);
 }
 static void doRedo(AppState &app)
 {
@@ -593,101 +1145,740 @@ static void doRedo(AppState &app)
     app.undoStack.push_back(app.shapes);
     app.shapes = std::move(app.redoStack.back());
     app.redoStack.pop_back();
+    pruneSelection(app);
+    rebuildNames(app);
+    requestAutosaveSnapshot(app);
 }
 
-// ---- Helper Functions ----
-void tryLoadFont(ImGuiIO &io, const char *path, float size)
+// ---- Nhiều bản vẽ (tab / chia màn hình) ----
+// Đổi chỗ nội dung bản vẽ đang hoạt động (AppState) với nội dung cất trong doc
+static void swapDocument(AppState &app, Document &doc)
 {
-    std::ifstream f(path);
-    if (!f.good())
-    {
-        std::cerr << "Warning: Font not found at " << path << ". Using default.\n";
-        return;
-    }
-    io.Fonts->AddFontFromFileTTF(path, size, NULL, io.Fonts->GetGlyphRangesVietnamese());
+    std::swap(app.shapes, doc.shapes);
+    std::swap(app.names, doc.names);
+    std::swap(app.undoStack, doc.undoStack);
+    std::swap(app.redoStack, doc.redoStack);
+    std::swap(app.selection, doc.selection);
+    std::swap(app.selectedMask, doc.selectedMask);
+    std::swap(app.selectedShapeIndex, doc.selectedShapeIndex);
+    double l, r, b, t;
+    app.geom->getView(l, r, b, t);
+    app.geom->setView(doc.l, doc.r, doc.b, doc.t);
+    doc.l = l, doc.r = r, doc.b = b, doc.t = t;
 }
 
-void drawLabel(const std::string &text, float wx, float wy, float l, float r, float b, float t, int winW, int winH, const Color &col)
+// Bỏ các thao tác đang dở (dựng hình nhiều bước, khung chọn, kéo) khi đổi bản vẽ
+static void resetInteraction(AppState &app)
 {
-    float ndcX = 2.0f * (wx - l) / (r - l) - 1.0f;
-    float ndcY = 2.0f * (wy - b) / (t - b) - 1.0f;
-    float screenX = (ndcX + 1.0f) * 0.5f * winW;
-    float screenY = (1.0f - ndcY) * 0.5f * winH;
-    ImU32 col32 = IM_COL32((int)(col.r * 255), (int)(col.g * 255), (int)(col.b * 255), 255);
-    ImGui::GetBackgroundDrawList()->AddText(ImVec2(screenX, screenY), col32, text.c_str());
+    app.awaitingSecond = false;
+    app.polylineActive = false;
+    app.tempPoly.clear();
+    app.isHoveringAny = false;
+    app.hoveredShapeIndex = -1;
+    app.bandActive = false;
+    app.bandHits.clear();
+    app.movingSelection = false;
+    app.pointStep = 0;
+    app.circlePointStep = 0;
+    app.ellipseCenterSet = false;
+    app.parabolaVertexSet = false;
+    app.hyperbolaCenterSet = false;
+    dragging = false;
+    draggingPoint = SlotHandle();
 }
 
-static std::string fmtTick(float v)
+// Đọc/ghi/import nền đang đổ vào bản vẽ hiện tại: chưa được đổi hay đóng bản vẽ
+static bool documentsLocked(const AppState &app)
 {
-    std::ostringstream ss;
-    if (std::fabs(v - std::round(v)) < 1e-4f)
-        ss << int(std::round(v));
-    else
+    return app.importing || app.ioKind != IO_NONE;
+}
+
+static bool switchDocument(AppState &app, int i)
+{
+    if (i == app.activeDoc || i < 0 || i >= (int)app.docs.size() || documentsLocked(app))
+        return false;
+    swapDocument(app, app.docs[app.activeDoc]);
+    swapDocument(app, app.docs[i]);
+    app.activeDoc = i;
+    resetInteraction(app);
+    requestRedraw();
+    return true;
+}
+
+// File autosave của bản vẽ id trong thư mục của phiên, ext = ".snapshot" / ".journal"
+static std::string autosaveFile(const AppState &app, int id, const char *ext)
+{
+    return app.autosaveDir.file("doc" + std::to_string(id) + ext);
+}
+
+// Mở nhật ký autosave cho bản vẽ thứ i (tab mới hoặc vừa khôi phục); không làm gì nếu autosave tắt
+static void openDocumentJournal(AppState &app, int i, uint64_t epoch, bool appendExisting)
+{
+    if (!app.autosaveDir.active())
+        return;
+    Document &doc = app.docs[i];
+    doc.journal = std::make_unique<Journal>();
+    std::string journalFile = autosaveFile(app, doc.id, ".journal");
+    if (!doc.journal->open(journalFile, autosaveFile(app, doc.id, ".snapshot"), epoch, appendExisting))
+        std::cerr << "Warning: cannot open autosave journal " << journalFile << "\n";
+}
+
+// Mở tab mới: trống, hoặc bản sao của bản vẽ hiện tại (hình dùng chung cache LOD/chỉ mục với bản gốc)
+static void newDocument(AppState &app, bool duplicate)
+{
+    if (documentsLocked(app))
+        return;
+    const Document &cur = app.docs[app.activeDoc];
+    Document doc;
+    doc.id = app.nextDocId++;
+    if (duplicate)
     {
-        ss << std::fixed << std::setprecision(2) << v;
-        std::string s = ss.str();
-        while (!s.empty() && s.back() == '0')
-            s.pop_back();
-        if (!s.empty() && s.back() == '.')
-            s.pop_back();
-        return s;
+        doc.title = cur.title + " (copy)";
+        doc.filePath = cur.filePath;
+        app.geom->getView(doc.l, doc.r, doc.b, doc.t);
+        // assign cấp handle mới: bản sao không dùng chung handle với bản gốc
+        doc.shapes.assign(app.shapes.items());
+        for (size_t i = 0; i < doc.shapes.size(); ++i)
+            doc.names.add(doc.shapes[i].name, doc.shapes.handleAt(i));
     }
-    return ss.str();
+    else
+        doc.title = "Untitled " + std::to_string(doc.id + 1);
+    app.docs.push_back(std::move(doc));
+    openDocumentJournal(app, (int)app.docs.size() - 1, 0, false);
+    // Bản sao chưa có gì trong nhật ký: snapshot ngay
+    app.docs.back().autosaveNeedsSnapshot = duplicate;
+    switchDocument(app, (int)app.docs.size() - 1);
 }
 
-static void screenToWorld(GLFWwindow *window, double sx, double sy, float &wx, float &wy)
+static void closeDocument(AppState &app, int i)
 {
-    AppState *app = static_cast<AppState *>(glfwGetWindowUserPointer(window));
-    if (!app || !app->geom)
-    {
-        wx = wy = 0.0f;
+    if (app.docs.size() <= 1 || i < 0 || i >= (int)app.docs.size())
         return;
+    if (i == app.activeDoc && !switchDocument(app, i > 0 ? i - 1 : 1))
+        return;
+    // Đóng tab là bỏ bản vẽ: file autosave của nó không cần khôi phục nữa
+    if (app.docs[i].journal)
+        app.docs[i].journal->close(true);
+    app.docs.erase(app.docs.begin() + i);
+    if (app.activeDoc > i)
+        app.activeDoc--;
+    requestRedraw();
+}
+
+// Bảng Controls bên phải (rộng cố định)
+static const float MENU_WIDTH = 320.0f;
+// Khe giữa các cột khi chia màn hình (pixel)
+static const int SPLIT_GAP = 2;
+
+// Vùng pixel của 1 canvas trong framebuffer, gốc trên-trái như tọa độ chuột (canvas luôn cao hết cửa sổ)
+struct CanvasRect
+{
+    int x = 0, w = 1, h = 1;
+    bool contains(double sx) const { return sx >= x && sx < x + w; }
+};
+
+// Canvas của bản vẽ doc; false nếu bản vẽ không hiện trên màn hình (không cần vẽ).
+// Chế độ tab: chỉ bản vẽ hoạt động, chiếm cả cửa sổ. Chia màn hình: mỗi bản vẽ 1 cột bên trái bảng Controls.
+static bool documentCanvas(const AppState &app, int doc, int fbW, int fbH, CanvasRect &c)
+{
+    c.h = std::max(1, fbH);
+    int n = (int)app.docs.size();
+    if (!app.splitView || n <= 1)
+    {
+        c.x = 0;
+        c.w = std::max(1, fbW);
+        return doc == app.activeDoc;
     }
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    float l, r, b, t;
-    app->geom->getView(l, r, b, t);
-    wx = l + (float)(sx / (double)width) * (r - l);
-    wy = b + (float)((height - sy) / (double)height) * (t - b);
+    int areaW = std::max(n, fbW - (int)MENU_WIDTH);
+    int colW = areaW / n;
+    c.x = doc * colW;
+    c.w = (doc == n - 1) ? areaW - c.x : std::max(1, colW - SPLIT_GAP);
+    return true;
 }
 
-// Logic tìm điểm Snap (Bắt dính)
-bool getClosestSnapPoint(AppState *app, GLFWwindow *window, double mx, double my, Vec2 &outPos)
+static CanvasRect activeCanvas(GLFWwindow *window, const AppState &app)
 {
-    if (!app || !app->geom)
-        return false;
     int w, h;
     glfwGetFramebufferSize(window, &w, &h);
-    float l, r, b, t;
-    app->geom->getView(l, r, b, t);
+    CanvasRect c;
+    documentCanvas(app, app.activeDoc, w, h, c);
+    return c;
+}
 
-    double pxToWorld = (r - l) / (double)w;
-    float threshold = 12.0f * (float)pxToWorld; // 12px threshold
-    float minDst2 = threshold * threshold;
+// Bản vẽ có canvas chứa hoành độ chuột sx, -1 nếu không có
+static int documentAt(GLFWwindow *window, const AppState &app, double sx)
+{
+    int w, h;
+    glfwGetFramebufferSize(window, &w, &h);
+    for (int i = 0; i < (int)app.docs.size(); ++i)
+    {
+        CanvasRect c;
+        if (documentCanvas(app, i, w, h, c) && c.contains(sx))
+            return i;
+    }
+    return -1;
+}
 
-    float wx = l + (float)(mx / w) * (r - l);
-    float wy = b + (float)((h - my) / h) * (t - b);
-    Vec2 mouseWorld = {wx, wy};
+// ---- Nhật ký thao tác (Autosave) ----
+// Mỗi thao tác sửa bản vẽ được ghi thành 1 bản ghi nhị phân gọn: [u8 op][dữ liệu]
+enum JournalOp : uint8_t
+{
+    JOP_ADD = 1, // Shape đầy đủ, thêm vào cuối
+    JOP_DELETE,  // u32 index
+    JOP_RECOLOR, // u32 index, Color
+    JOP_UPDATE,  // u32 index, Shape đầy đủ (đổi tên, ẩn/hiện tên...)
+    // Thao tác hàng loạt trên vùng chọn: 1 bản ghi cho cả nhóm, danh sách chỉ số = u32 count + count x u32 tăng dần
+    JOP_DELETE_MANY,  // danh sách chỉ số
+    JOP_RECOLOR_MANY, // Color, danh sách chỉ số
+    JOP_TRANSFORM,    // ShapeTransform, danh sách chỉ số
+    // Xóa kiểu slot map: xóa từ chỉ số lớn đến nhỏ, mỗi lần chuyển hình cuối vào chỗ trống.
+    // JOP_DELETE / JOP_DELETE_MANY (xóa giữ thứ tự) vẫn đọc được từ nhật ký cũ
+    JOP_SWAP_REMOVE   // danh sách chỉ số
+};
 
-    bool found = false;
-    Vec2 bestPos = {0, 0};
+struct ByteWriter
+{
+    std::string buf;
+    template <typename T>
+    void put(const T &v) { buf.append(reinterpret_cast<const char *>(&v), sizeof(T)); }
+};
 
-    auto checkPoint = [&](Vec2 p)
+struct ByteReader
+{
+    const std::string &buf;
+    size_t pos = 0;
+    bool ok = true;
+    template <typename T>
+    T get()
     {
-        float d2 = distSq(p, mouseWorld);
-        if (d2 < minDst2)
+        T v{};
+        if (pos + sizeof(T) > buf.size())
         {
-            minDst2 = d2;
-            bestPos = p;
-            found = true;
+            ok = false;
+            return v;
         }
-    };
+        std::memcpy(&v, buf.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+};
 
-    for (const Shape &s : app->shapes)
-    {
-        switch (s.kind)
-        {
-        case SH_POINT:
+static void encodeShape(ByteWriter &w, const Shape &s)
+{
+    w.put((uint8_t)s.kind);
+    w.put(s.color);
+    w.put(s.p1);
+    w.put(s.p2);
+    w.put(s.pointSize);
+    w.put(s.radius);
+    w.put(s.a);
+    w.put(s.b);
+    w.put(s.angle);
+    w.put(s.paramA);
+    w.put((uint8_t)s.isVertical);
+    w.put(s.hyper_a);
+    w.put(s.hyper_b);
+    w.put((int32_t)s.segments);
+    w.put((uint8_t)s.showName);
+    w.put((uint32_t)s.name.size());
+    w.buf.append(s.name);
+    w.put((uint32_t)s.poly.size());
+    w.buf.append(reinterpret_cast<const char *>(s.poly.data()), s.poly.size() * sizeof(Vec2));
+}
+
+static bool decodeShape(ByteReader &r, Shape &s)
+{
+    uint8_t kind = r.get<uint8_t>();
+    if (kind > SH_POLYLINE)
+        return false;
+    s.kind = (ShapeKind)kind;
+    s.color = r.get<Color>();
+    s.p1 = r.get<Vec2>();
+    s.p2 = r.get<Vec2>();
+    s.pointSize = r.get<float>();
+    s.radius = r.get<double>();
+    s.a = r.get<double>();
+    s.b = r.get<double>();
+    s.angle = r.get<double>();
+    s.paramA = r.get<double>();
+    s.isVertical = r.get<uint8_t>() != 0;
+    s.hyper_a = r.get<double>();
+    s.hyper_b = r.get<double>();
+    s.segments = r.get<int32_t>();
+    s.showName = r.get<uint8_t>() != 0;
+    uint32_t nameLen = r.get<uint32_t>();
+    if (!r.ok || r.pos + nameLen > r.buf.size())
+        return false;
+    s.name.assign(r.buf.data() + r.pos, nameLen);
+    r.pos += nameLen;
+    uint32_t n = r.get<uint32_t>();
+    if (!r.ok || r.pos + (size_t)n * sizeof(Vec2) > r.buf.size())
+        return false;
+    s.poly.resize(n);
+    std::memcpy(s.poly.data(), r.buf.data() + r.pos, (size_t)n * sizeof(Vec2));
+    r.pos += (size_t)n * sizeof(Vec2);
+    return r.ok;
+}
+
+static void encodeIndexList(ByteWriter &w, const std::vector<int> &idx)
+{
+    w.put((uint32_t)idx.size());
+    for (int i : idx)
+        w.put((uint32_t)i);
+}
+
+// Danh sách phải tăng dần và nằm trong [0, count)
+static bool decodeIndexList(ByteReader &r, size_t count, std::vector<int> &idx)
+{
+    uint32_t n = r.get<uint32_t>();
+    if (!r.ok || r.pos + (size_t)n * sizeof(uint32_t) > r.buf.size())
+        return false;
+    idx.resize(n);
+    for (uint32_t k = 0; k < n; ++k)
+    {
+        uint32_t i = r.get<uint32_t>();
+        if (i >= count || (k > 0 && (int)i <= idx[k - 1]))
+            return false;
+        idx[k] = (int)i;
+    }
+    return r.ok;
+}
+
+// Xóa các hình idx (tăng dần) trong 1 lượt dồn mảng, thay vì erase từng hình O(n) mỗi lần
+static void eraseShapes(std::vector<Shape> &shapes, const std::vector<int> &idx)
+{
+    if (idx.empty())
+        return;
+    size_t out = (size_t)idx[0], k = 0;
+    for (size_t i = out; i < shapes.size(); ++i)
+    {
+        if (k < idx.size() && (size_t)idx[k] == i)
+        {
+            ++k;
+            continue;
+        }
+        shapes[out++] = std::move(shapes[i]);
+    }
+    shapes.resize(out);
+}
+
+// Giống hệt ShapeStore::eraseMany nhưng trên vector (khôi phục nhật ký vào SceneData)
+static void swapRemoveShapes(std::vector<Shape> &shapes, const std::vector<int> &idx)
+{
+    for (size_t k = idx.size(); k-- > 0;)
+    {
+        size_t i = (size_t)idx[k];
+        if (i + 1 != shapes.size())
+            shapes[i] = std::move(shapes.back());
+        shapes.pop_back();
+    }
+}
+
+// Áp dụng 1 bản ghi lên danh sách hình (dùng khi khôi phục); bỏ qua bản ghi không hợp lệ
+static bool applyJournalRecord(std::vector<Shape> &shapes, const std::string &rec)
+{
+    ByteReader r{rec};
+    uint8_t op = r.get<uint8_t>();
+    switch (op)
+    {
+    case JOP_ADD:
+    {
+        Shape s;
+        if (!decodeShape(r, s))
+            return false;
+        shapes.push_back(std::move(s));
+        return true;
+    }
+    case JOP_DELETE:
+    {
+        uint32_t idx = r.get<uint32_t>();
+        if (!r.ok || idx >= shapes.size())
+            return false;
+        shapes.erase(shapes.begin() + idx);
+        return true;
+    }
+    case JOP_RECOLOR:
+    {
+        uint32_t idx = r.get<uint32_t>();
+        Color c = r.get<Color>();
+        if (!r.ok || idx >= shapes.size())
+            return false;
+        shapes[idx].color = c;
+        return true;
+    }
+    case JOP_UPDATE:
+    {
+        uint32_t idx = r.get<uint32_t>();
+        Shape s;
+        if (!r.ok || idx >= shapes.size() || !decodeShape(r, s))
+            return false;
+        shapes[idx] = std::move(s);
+        return true;
+    }
+    case JOP_DELETE_MANY:
+    {
+        std::vector<int> idx;
+        if (!decodeIndexList(r, shapes.size(), idx))
+            return false;
+        eraseShapes(shapes, idx);
+        return true;
+    }
+    case JOP_SWAP_REMOVE:
+    {
+        std::vector<int> idx;
+        if (!decodeIndexList(r, shapes.size(), idx))
+            return false;
+        swapRemoveShapes(shapes, idx);
+        return true;
+    }
+    case JOP_RECOLOR_MANY:
+    {
+        Color c = r.get<Color>();
+        std::vector<int> idx;
+        if (!r.ok || !decodeIndexList(r, shapes.size(), idx))
+            return false;
+        for (int i : idx)
+            shapes[i].color = c;
+        return true;
+    }
+    case JOP_TRANSFORM:
+    {
+        ShapeTransform tf = r.get<ShapeTransform>();
+        std::vector<int> idx;
+        if (!r.ok || !decodeIndexList(r, shapes.size(), idx))
+            return false;
+        for (int i : idx)
+            transformShape(shapes[i], tf);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// ---- Các thao tác sửa bản vẽ (đều được ghi nhật ký) ----
+static void addShape(AppState &app, Shape s)
+{
+    if (journaling(app))
+    {
+        ByteWriter w;
+        w.put((uint8_t)JOP_ADD);
+        encodeShape(w, s);
+        activeJournal(app).append(std::move(w.buf));
+    }
+    std::string name = s.name;
+    app.names.add(name, app.shapes.push_back(std::move(s)));
+}
+
+// Các thao tác trên vùng chọn: idx tăng dần, không trùng (như AppState::selection).
+// Cả nhóm được sửa trong 1 lượt và ghi 1 bản ghi nhật ký; người gọi tự pushUndo 1 lần.
+static void deleteShapes(AppState &app, std::vector<int> idx)
+{
+    if (idx.empty())
+        return;
+    for (int i : idx)
+        app.names.remove(app.shapes[i].name, app.shapes.handleAt(i));
+    app.shapes.eraseMany(idx);
+    if (journaling(app))
+    {
+        ByteWriter w;
+        w.put((uint8_t)JOP_SWAP_REMOVE);
+        encodeIndexList(w, idx);
+        activeJournal(app).append(std::move(w.buf));
+    }
+    // Reset các index vì vector đã thay đổi kích thước
+    // Xóa O(1) đổi chỗ hình cuối: các chỉ số dày không còn đúng, handle thì vẫn đúng
+    clearSelection(app);
+    app.hoveredShapeIndex = -1;
+}
+
+static void recolorShapes(AppState &app, const std::vector<int> &idx, Color c)
+{
+    if (idx.empty())
+        return;
+    for (int i : idx)
+        app.shapes[i].color = c;
+    if (journaling(app))
+    {
+        ByteWriter w;
+        w.put((uint8_t)JOP_RECOLOR_MANY);
+        w.put(c);
+        encodeIndexList(w, idx);
+        activeJournal(app).append(std::move(w.buf));
+    }
+}
+
+static void transformShapes(AppState &app, const std::vector<int> &idx, const ShapeTransform &tf)
+{
+    if (idx.empty())
+        return;
+    for (int i : idx)
+        transformShape(app.shapes[i], tf);
+    if (journaling(app))
+    {
+        ByteWriter w;
+        w.put((uint8_t)JOP_TRANSFORM);
+        w.put(tf);
+        encodeIndexList(w, idx);
+        activeJournal(app).append(std::move(w.buf));
+    }
+}
+
+// Hộp bao của cả vùng chọn (tâm của nó là tâm quay/co giãn)
+static SceneIndex::Box selectionBounds(const AppState &app)
+{
+    SceneIndex::Box all = shapeSelectBox(app.shapes[app.selection[0]]);
+    for (int i : app.selection)
+    {
+        SceneIndex::Box bx = shapeSelectBox(app.shapes[i]);
+        all.minX = std::min(all.minX, bx.minX);
+        all.minY = std::min(all.minY, bx.minY);
+        all.maxX = std::max(all.maxX, bx.maxX);
+        all.maxY = std::max(all.maxY, bx.maxY);
+    }
+    return all;
+}
+
+// ---- Khung chọn / lasso / kéo vùng chọn (chế độ Select) ----
+static void beginSelectGesture(AppState &app, Vec2 p, int mods)
+{
+    SelectOp op = (mods & GLFW_MOD_CONTROL) ? SEL_TOGGLE : (mods & GLFW_MOD_SHIFT) ? SEL_ADD : SEL_REPLACE;
+    int hit = app.hoveredShapeIndex;
+    if (hit != -1 && !(mods & GLFW_MOD_ALT))
+    {
+        // Click vào hình đã chọn (không phím bổ trợ) thì giữ nguyên vùng chọn để kéo cả nhóm
+        if (op != SEL_REPLACE || !isSelected(app, hit))
+            applySelectOp(app, {hit}, op);
+        if (isSelected(app, hit))
+        {
+            app.movingSelection = true;
+            app.moveUndoPushed = false;
+            app.moveStart = app.moveLast = p;
+        }
+        return;
+    }
+
+    app.bandActive = true;
+    app.bandLasso = (mods & GLFW_MOD_ALT) != 0;
+    app.bandOp = op;
+    app.bandStart = app.bandEnd = p;
+    app.lassoPts.assign(1, p);
+    app.bandHits.clear();
+    std::vector<SceneIndex::Box> boxes(app.shapes.size());
+    for (size_t i = 0; i < app.shapes.size(); ++i)
+        boxes[i] = shapeSelectBox(app.shapes[i]);
+    app.sceneIndex.build(boxes);
+}
+
+static SceneIndex::Box bandBox(const AppState &app)
+{
+    if (app.bandLasso)
+    {
+        SceneIndex::Box bx{app.lassoPts[0].x, app.lassoPts[0].y, app.lassoPts[0].x, app.lassoPts[0].y};
+        for (const Vec2 &v : app.lassoPts)
+        {
+            bx.minX = std::min(bx.minX, v.x);
+            bx.maxX = std::max(bx.maxX, v.x);
+            bx.minY = std::min(bx.minY, v.y);
+            bx.maxY = std::max(bx.maxY, v.y);
+        }
+        return bx;
+    }
+    return {std::min(app.bandStart.x, app.bandEnd.x), std::min(app.bandStart.y, app.bandEnd.y),
+            std::max(app.bandStart.x, app.bandEnd.x), std::max(app.bandStart.y, app.bandEnd.y)};
+}
+
+// Hình nằm trọn trong khung chọn (hộp) hoặc lasso (lọc bằng hộp bao của lasso trước)
+static void queryBand(AppState &app)
+{
+    app.bandHits.clear();
+    bool lasso = app.bandLasso;
+    if (lasso && app.lassoPts.size() < 3)
+        return;
+    app.sceneIndex.forEachInside(bandBox(app), [&](uint32_t id)
+                                 {
+        if (!lasso || shapeInLasso(app.shapes[id], app.lassoPts))
+            app.bandHits.push_back((int)id); });
+}
+
+// minStep: khoảng cách tối thiểu (World) giữa 2 đỉnh lasso liên tiếp, tránh lasso hàng nghìn đỉnh
+static void updateSelectGesture(AppState &app, Vec2 p, double minStep)
+{
+    if (app.bandActive)
+    {
+        app.bandEnd = p;
+        if (app.bandLasso)
+        {
+            if (dist(p, app.lassoPts.back()) >= minStep)
+                app.lassoPts.push_back(p);
+        }
+        else
+        {
+            // Lasso chỉ tính khi thả chuột; khung chữ nhật xem trước được ngay nhờ chỉ mục
+            queryBand(app);
+        }
+        return;
+    }
+    if (!app.movingSelection || (p.x == app.moveLast.x && p.y == app.moveLast.y))
+        return;
+    if (!app.moveUndoPushed)
+    {
+        pushUndo(app);
+        app.moveUndoPushed = true;
+    }
+    // Xem trước: dịch từng bước, không ghi nhật ký
+    ShapeTransform step;
+    step.offset = {p.x - app.moveLast.x, p.y - app.moveLast.y};
+    for (int i : app.selection)
+        transformShape(app.shapes[i], step);
+    app.moveLast = p;
+}
+
+static void endSelectGesture(AppState &app)
+{
+    if (app.bandActive)
+    {
+        queryBand(app);
+        applySelectOp(app, app.bandHits, app.bandOp);
+        app.bandActive = false;
+        app.bandHits.clear();
+        app.lassoPts.clear();
+        return;
+    }
+    if (!app.movingSelection)
+        return;
+    app.movingSelection = false;
+    if (!app.moveUndoPushed || app.undoStack.empty() || app.undoStack.back().size() != app.shapes.size())
+        return;
+    // Tính lại từ bản trước khi kéo bằng đúng 1 phép tịnh tiến tổng, để kết quả khớp bit với
+    // bản ghi nhật ký (cộng dồn từng bước có thể lệch làm tròn)
+    const ShapeStore &before = app.undoStack.back();
+    for (int i : app.selection)
+        app.shapes[i] = before[i];
+    ShapeTransform tf;
+    tf.offset = {app.moveLast.x - app.moveStart.x, app.moveLast.y - app.moveStart.y};
+    transformShapes(app, app.selection, tf);
+}
+
+// Ghi lại toàn bộ hình sau khi được sửa trực tiếp qua UI
+static void journalShapeUpdated(AppState &app, int idx)
+{
+    if (!journaling(app) || idx < 0 || idx >= (int)app.shapes.size())
+        return;
+    ByteWriter w;
+    w.put((uint8_t)JOP_UPDATE);
+    w.put((uint32_t)idx);
+    encodeShape(w, app.shapes[idx]);
+    activeJournal(app).append(std::move(w.buf));
+}
+
+// ---- Helper Functions ----
+void tryLoadFont(ImGuiIO &io, const char *path, float size)
+{
+    std::ifstream f(path);
+    if (!f.good())
+    {
+        std::cerr << "Warning: Font not found at " << path << ". Using default.\n";
+        return;
+    }
+    io.Fonts->AddFontFromFileTTF(path, size, NULL, io.Fonts->GetGlyphRangesVietnamese());
+}
+
+// Nơi vẽ chữ: canvas trên màn hình (background draw list) hoặc 1 tile của ảnh xuất (draw list riêng)
+struct LabelTarget
+{
+    ImDrawList *dl;
+    double l, r, b, t; // Vùng World phủ đúng canvas c
+    CanvasRect c;
+
+    // World -> pixel của draw list. Lưu ý: ImGui gốc tọa độ (0,0) là góc TRÊN-TRÁI,
+    // OpenGL gốc tọa độ (-1,-1) là góc DƯỚI-TRÁI
+    ImVec2 toScreen(double wx, double wy) const
+    {
+        float ndcX = (float)(2.0 * (wx - l) / (r - l) - 1.0);
+        float ndcY = (float)(2.0 * (wy - b) / (t - b) - 1.0);
+        return ImVec2(c.x + (ndcX + 1.0f) * 0.5f * c.w, (1.0f - ndcY) * 0.5f * c.h);
+    }
+};
+
+void drawLabel(const LabelTarget &to, const std::string &text, double wx, double wy, const Color &col)
+{
+    ImU32 col32 = IM_COL32((int)(col.r * 255), (int)(col.g * 255), (int)(col.b * 255), 255);
+    to.dl->AddText(to.toScreen(wx, wy), col32, text.c_str());
+}
+
+// Dùng snprintf thay cho ostringstream: chuỗi ngắn nằm gọn trong std::string (SSO), không cấp phát heap mỗi frame.
+// Số chữ số thập phân theo khoảng lưới để khi zoom sâu các nhãn kề nhau vẫn khác nhau
+static std::string fmtTick(double v, double spacing)
+{
+    char buf[48];
+    int decimals = std::min(17, std::max(2, 2 - (int)std::floor(std::log10(spacing))));
+    if (spacing >= 1.0 && std::fabs(v) < 1e15)
+        std::snprintf(buf, sizeof(buf), "%.0f", v);
+    else
+    {
+        std::snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        size_t n = std::strlen(buf);
+        while (n > 0 && buf[n - 1] == '0')
+            buf[--n] = '\0';
+        if (n > 0 && buf[n - 1] == '.')
+            buf[--n] = '\0';
+    }
+    return buf;
+}
+
+static void screenToWorld(GLFWwindow *window, double sx, double sy, double &wx, double &wy)
+{
+    AppState *app = static_cast<AppState *>(glfwGetWindowUserPointer(window));
+    if (!app || !app->geom)
+    {
+        wx = wy = 0.0;
+        return;
+    }
+    CanvasRect c = activeCanvas(window, *app);
+    double l, r, b, t;
+    app->geom->getView(l, r, b, t);
+    wx = l + ((sx - c.x) / (double)c.w) * (r - l);
+    wy = b + ((c.h - sy) / (double)c.h) * (t - b);
+}
+
+// Logic tìm điểm Snap (Bắt dính)
+bool getClosestSnapPoint(AppState *app, GLFWwindow *window, double mx, double my, Vec2 &outPos)
+{
+    if (!app || !app->geom)
+        return false;
+    CanvasRect c = activeCanvas(window, *app);
+    double l, r, b, t;
+    app->geom->getView(l, r, b, t);
+
+    double pxToWorld = (r - l) / (double)c.w;
+    double threshold = 12.0 * pxToWorld; // 12px threshold
+    double minDst2 = threshold * threshold;
+
+    double wx, wy;
+    screenToWorld(window, mx, my, wx, wy);
+    Vec2 mouseWorld = {wx, wy};
+
+    bool found = false;
+    Vec2 bestPos = {0, 0};
+
+    auto checkPoint = [&](Vec2 p)
+    {
+        g_queryStats.snapPointsTested++;
+        double d2 = distSq(p, mouseWorld);
+        if (d2 < minDst2)
+        {
+            minDst2 = d2;
+            bestPos = p;
+            found = true;
+        }
+    };
+
+    for (const Shape &s : app->shapes)
+    {
+        switch (s.kind)
+        {
+        case SH_POINT:
             checkPoint(s.p1);
             break;
         case SH_LINE:
@@ -699,8 +1890,17 @@ bool getClosestSnapPoint(AppState *app, GLFWwindow *window, double mx, double my
             checkPoint(s.p1);
             break;
         case SH_POLYLINE:
-            for (const auto &v : s.poly)
-                checkPoint(v);
+            if (const PolylineIndex *index = getPolylineIndex(s))
+            {
+                // Chỉ xét các đỉnh thuộc khúc nằm gần chuột
+                index->forEachVertexNear(mouseWorld, threshold, [&](size_t i)
+                                         { checkPoint(s.poly[i]); });
+            }
+            else
+            {
+                for (const auto &v : s.poly)
+                    checkPoint(v);
+            }
             break;
         case SH_PARABOLA:
             checkPoint(s.p1);
@@ -714,6 +1914,177 @@ bool getClosestSnapPoint(AppState *app, GLFWwindow *window, double mx, double my
     return found;
 }
 
+// Số lần cấp phát heap của luồng UI
+struct HeapStats
+{
+    size_t frameAllocs = 0;  // Cả frame trước
+    size_t renderAllocs = 0; // Chỉ phần vẽ canvas (grid, shapes, highlight, labels)
+};
+
+static void drawStatsPanel(const RenderStats &rs, const QueryStats &qs, const HeapStats &hs, const FramePacer::LatencyStats &ls, bool *open)
+{
+    ImGui::SetNextWindowSize(ImVec2(320, 200), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Stats", open))
+    {
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("Render (last frame)");
+    ImGui::BulletText("Vertices generated: %zu", rs.verticesGenerated);
+    ImGui::BulletText("Bytes uploaded: %zu", rs.bytesUploaded);
+    ImGui::BulletText("Draw calls: %zu", rs.drawCalls);
+    ImGui::BulletText("Arena bytes: %zu", rs.arenaBytes);
+    ImGui::Separator();
+    ImGui::Text("Heap allocations (last frame)");
+    ImGui::BulletText("Whole frame: %zu", hs.frameAllocs);
+    ImGui::BulletText("Canvas rendering: %zu", hs.renderAllocs);
+    ImGui::Separator();
+    ImGui::Text("Queries (last frame)");
+    ImGui::BulletText("Shapes tested: %zu", qs.shapesTested);
+    ImGui::BulletText("Segments evaluated: %zu", qs.segmentsEvaluated);
+    ImGui::BulletText("Snap points tested: %zu", qs.snapPointsTested);
+    ImGui::BulletText("Cursor events / processed: %zu / %zu", qs.cursorEvents, qs.cursorUpdates);
+    ImGui::Separator();
+    ImGui::Text("Frame pacing");
+    ImGui::BulletText("Frame period: %.2f ms, render: %.2f ms", ls.framePeriod, ls.renderTime);
+    if (ls.samples == 0)
+        ImGui::BulletText("Input latency: enable Measure Latency");
+    else
+        ImGui::BulletText("Input latency (%zu): p50 %.1f, p90 %.1f, p99 %.1f, max %.1f ms", ls.samples, ls.p50, ls.p90, ls.p99, ls.max);
+    ImGui::End();
+}
+
+// Màu lưới/trục/nhãn (canvas và ảnh xuất)
+static const Color GRID_COLOR{0.3f, 0.3f, 0.3f};
+static const Color AXIS_COLOR{0.6f, 0.6f, 0.6f};
+static const Color LABEL_COLOR{0.9f, 0.9f, 0.9f};
+
+// Khoảng lưới: lũy thừa 2 của 0.25 sao cho chiều rộng worldWidth có khoảng 2-10 ô
+static double gridSpacing(double worldWidth)
+{
+    double spacing = 0.25;
+    while (spacing * 10.0 < worldWidth)
+        spacing *= 2.0;
+    while (spacing * 2.0 > worldWidth && spacing > std::numeric_limits<double>::min())
+        spacing *= 0.5;
+    return spacing;
+}
+
+// Điểm có tên đang được hiện
+static bool hasVisibleName(const Shape &s)
+{
+    return s.kind == SH_POINT && !s.name.empty() && s.showName;
+}
+
+// Tên điểm, đặt lệch lên trên và sang phải một chút để không đè vào điểm
+static void drawPointName(GeometryRenderer &geom, const LabelTarget &to, const Shape &s)
+{
+    if (!hasVisibleName(s))
+        return;
+    ImVec2 p = to.toScreen(s.p1.x, s.p1.y);
+    geom.drawText(s.name, p.x + 10.0f, p.y - 20.0f, s.color, to.dl);
+}
+
+// Số trên các trục và tên trục x, y. Vị trí nhãn theo vùng (l, r, b, t) của cả canvas/ảnh (không phải của tile)
+// để các tile ảnh xuất ghép lại khớp nhau; tên trục x đặt ở mép phải axisRight
+static void drawAxisLabels(const LabelTarget &to, const AppState &app, double spacing,
+                           double l, double r, double b, double t, double axisRight)
+{
+    double labelOffset = (t - b) * 0.02;
+    // Nhãn đặt tại k * spacing (k nguyên) như drawGrid
+    double startX = std::floor(l / spacing);
+    double endX = std::ceil(r / spacing);
+
+    if (app.showGrid)
+    {
+        // Số trên trục X
+        for (double k = startX; k <= endX; k += 1.0)
+        {
+            double worldLabelY = (b <= 0.0 && t >= 0.0) ? (-labelOffset) : (b + labelOffset);
+            drawLabel(to, fmtTick(k * spacing, spacing), k * spacing, worldLabelY, LABEL_COLOR);
+        }
+
+        // Số trên trục Y
+        double startY = std::floor(b / spacing);
+        double endY = std::ceil(t / spacing);
+        for (double k = startY; k <= endY; k += 1.0)
+        {
+            if (k == 0.0)
+                continue;
+            double worldLabelX = (l <= 0.0 && r >= 0.0) ? (labelOffset) : (l + labelOffset);
+            drawLabel(to, fmtTick(k * spacing, spacing), worldLabelX, k * spacing, LABEL_COLOR);
+        }
+    }
+
+    // 3. Vẽ tên trục x, y (Chỉ khi showAxis = true)
+    if (app.showAxis)
+    {
+        drawLabel(to, "x", axisRight - 0.2 * spacing, 0.2 * spacing, LABEL_COLOR);
+        drawLabel(to, "y", -0.2 * spacing, t - 0.05 * spacing, LABEL_COLOR);
+    }
+}
+
+// Vẽ 1 bản vẽ vào canvas c: lưới, các hình (hình đang chọn vẽ nổi lên trên), tên điểm và nhãn tọa độ.
+// View của geom phải là view của bản vẽ này. Dùng chung cho bản vẽ hoạt động và các bản vẽ đang cất (chia màn hình).
+static void drawDocumentLayer(GeometryRenderer &geom, Shader &shader, FrameProfiler &profiler, const AppState &app,
+                              const ShapeStore &shapes, const std::vector<uint8_t> &selectedMask, const CanvasRect &c, int fbW)
+{
+    // Canvas luôn cao hết cửa sổ nên gốc Y của viewport (dưới-trái) là 0
+    glViewport(c.x, 0, c.w, c.h);
+    glScissor(c.x, 0, c.w, c.h);
+    geom.setViewportSize(c.w, c.h);
+    ImDrawList *bg = ImGui::GetBackgroundDrawList();
+    bg->PushClipRect(ImVec2((float)c.x, 0.0f), ImVec2((float)(c.x + c.w), (float)c.h), true);
+
+    double l, r, b, t;
+    geom.getView(l, r, b, t);
+
+    double spacing = gridSpacing(r - l);
+    LabelTarget labels{bg, l, r, b, t, c};
+
+    profiler.beginStage(STAGE_GRID);
+    geom.drawGrid(spacing, GRID_COLOR, AXIS_COLOR, app.showGrid, app.showAxis);
+    profiler.endStage(STAGE_GRID);
+
+    shader.use();
+    shader.setInt("u_useOverride", 0);
+
+    // Vẽ các hình chính
+    profiler.beginStage(STAGE_SHAPES);
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        // Nếu hình này đang được Select, bỏ qua để vẽ sau (cho nó nổi lên trên)
+        if (i < selectedMask.size() && selectedMask[i])
+            continue;
+        drawShape(shapes[i], geom);
+
+        drawPointName(geom, labels, shapes[i]);
+    }
+    profiler.endStage(STAGE_SHAPES);
+
+    // --- HIGHLIGHT SELECTED SHAPE (Click Selection) ---
+    profiler.beginStage(STAGE_HIGHLIGHT);
+    // Vẽ các hình đang chọn với màu Đậm (Đỏ Cam) và nét to hơn
+    for (size_t i = 0; i < selectedMask.size() && i < shapes.size(); ++i)
+    {
+        if (!selectedMask[i])
+            continue;
+        const Shape &s = shapes[i];
+        // Vẽ đè lên: màu cam đậm, Point to hơn
+        drawShape(s, geom, {1.0f, 0.4f, 0.0f}, s.kind == SH_POINT ? s.pointSize * 1.5f : s.pointSize);
+    }
+    profiler.endStage(STAGE_HIGHLIGHT);
+
+    // --- VẼ NHÃN & TRỤC ---
+    profiler.beginStage(STAGE_LABELS);
+    // Phần canvas không bị bảng Controls che
+    int visibleW = std::max(1, std::min(c.x + c.w, fbW - (int)MENU_WIDTH) - c.x);
+    double visibleRight = l + (r - l) * ((double)visibleW / c.w);
+    drawAxisLabels(labels, app, spacing, l, r, b, t, visibleRight);
+    profiler.endStage(STAGE_LABELS);
+    bg->PopClipRect();
+}
+
 // Logic Save/Load
 static fs::path resolveSavePath(const char *userPath)
 {
@@ -722,24 +2093,29 @@ static fs::path resolveSavePath(const char *userPath)
         return p;
     return fs::absolute(p);
 }
-bool saveDrawing(const AppState &app, const char *path)
+// Dữ liệu một bản vẽ độc lập với AppState (dùng cho đọc/ghi ở luồng nền)
+struct SceneData
 {
-    if (!app.geom)
-        return false;
-    std::ofstream ofs(resolveSavePath(path).string());
-    if (!ofs)
-        return false;
+    double l = -2.0, r = 2.0, b = -1.5, t = 1.5;
+    std::vector<Shape> shapes;
+};
+
+// Ghi bản vẽ ra stream; progress (nếu có) nhận tỉ lệ 0..1 sau mỗi hình
+template <typename Progress>
+bool writeScene(std::ostream &ofs, const SceneData &scene, Progress progress)
+{
+    // Đủ chữ số để đọc lại đúng từng bit tọa độ double (bản vẽ zoom sâu)
+    ofs << std::setprecision(std::numeric_limits<double>::max_digits10);
 
     // Lưu vùng nhìn (View)
-    float l, r, b, t;
-    app.geom->getView(l, r, b, t);
-    ofs << l << " " << r << " " << b << " " << t << "\n";
+    ofs << scene.l << " " << scene.r << " " << scene.b << " " << scene.t << "\n";
 
     // Số lượng hình
-    ofs << app.shapes.size() << "\n";
+    ofs << scene.shapes.size() << "\n";
 
-    for (const Shape &s : app.shapes)
+    for (size_t i = 0; i < scene.shapes.size(); ++i)
     {
+        const Shape &s = scene.shapes[i];
         // [Kind] [R G B]
         ofs << (int)s.kind << " " << s.color.r << " " << s.color.g << " " << s.color.b << " ";
 
@@ -781,79 +2157,1003 @@ bool saveDrawing(const AppState &app, const char *path)
             break;
         }
         ofs << "\n";
+        if (!ofs)
+            return false;
+        if (!progress((float)(i + 1) / (float)scene.shapes.size()))
+            return false;
+    }
+    return (bool)ofs;
+}
+
+// Số byte còn lại của stream (SIZE_MAX nếu không seek được), để chặn số lượng khai báo trong file hỏng
+static size_t remainingBytes(std::istream &is)
+{
+    std::streampos cur = is.tellg();
+    if (cur == std::streampos(-1))
+        return is ? SIZE_MAX : 0; // tellg hỏng vì đã hết dữ liệu -> còn 0 byte
+    is.seekg(0, std::ios::end);
+    std::streampos end = is.tellg();
+    is.seekg(cur);
+    if (!is || end == std::streampos(-1))
+    {
+        is.clear();
+        is.seekg(cur);
+        return SIZE_MAX;
+    }
+    return end > cur ? (size_t)(end - cur) : 0;
+}
+
+// Đọc bản vẽ từ stream vào scene; chỉ trả về true khi toàn bộ file hợp lệ
+template <typename Progress>
+bool parseScene(std::istream &ifs, SceneData &scene, Progress progress)
+{
+    if (!(ifs >> scene.l >> scene.r >> scene.b >> scene.t))
+        return false;
+
+    size_t count;
+    if (!(ifs >> count))
+        return false;
+
+    scene.shapes.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        int k;
+        float cr, cg, cb;
+        if (!(ifs >> k >> cr >> cg >> cb) || k < SH_POINT || k > SH_POLYLINE)
+            return false;
+        Shape s;
+        s.kind = (ShapeKind)k;
+        s.color = {cr, cg, cb};
+
+        switch (s.kind)
+        {
+        case SH_POINT:
+            ifs >> s.p1.x >> s.p1.y >> s.pointSize >> s.showName >> s.name;
+            if (s.name == "null")
+                s.name = "";
+            std::replace(s.name.begin(), s.name.end(), '_', ' ');
+            break;
+        case SH_LINE:
+            ifs >> s.p1.x >> s.p1.y >> s.p2.x >> s.p2.y;
+            break;
+        case SH_INFINITE_LINE:
+        case SH_RAY:
+            ifs >> s.p1.x >> s.p1.y >> s.p2.x >> s.p2.y;
+            break;
+        case SH_CIRCLE:
+            ifs >> s.p1.x >> s.p1.y >> s.radius >> s.segments;
+            break;
+        case SH_ELLIPSE:
+            ifs >> s.p1.x >> s.p1.y >> s.a >> s.b >> s.angle >> s.segments;
+            break;
+        case SH_PARABOLA:
+            ifs >> s.p1.x >> s.p1.y >> s.paramA >> s.isVertical;
+            break;
+        case SH_HYPERBOLA:
+            ifs >> s.p1.x >> s.p1.y >> s.hyper_a >> s.hyper_b >> s.isVertical;
+            break;
+        case SH_POLYLINE:
+            size_t n;
+            // Mỗi đỉnh chiếm ít nhất 4 byte (" x y"): n lớn hơn phần còn lại là file hỏng, không cấp phát
+            if (!(ifs >> n) || n > remainingBytes(ifs) / 4)
+                return false;
+            s.poly.resize(n);
+            for (size_t j = 0; j < n; ++j)
+                ifs >> s.poly[j].x >> s.poly[j].y;
+            break;
+        }
+        if (!ifs)
+            return false;
+        scene.shapes.push_back(std::move(s));
+        if (!progress((float)(i + 1) / (float)count))
+            return false;
     }
     return true;
 }
 
+static SceneData snapshotScene(const AppState &app)
+{
+    SceneData scene;
+    app.geom->getView(scene.l, scene.r, scene.b, scene.t);
+    scene.shapes = app.shapes.items();
+    return scene;
+}
+
+// Bản sao của bản vẽ thứ doc (đang hoạt động hoặc đang cất)
+static SceneData snapshotScene(const AppState &app, int doc)
+{
+    if (doc == app.activeDoc)
+        return snapshotScene(app);
+    const Document &d = app.docs[doc];
+    SceneData scene;
+    scene.l = d.l, scene.r = d.r, scene.b = d.b, scene.t = d.t;
+    scene.shapes = d.shapes.items();
+    return scene;
+}
+
+// Thay bản vẽ hiện tại bằng scene đã đọc xong (gọi ở ranh giới frame)
+static void applyScene(AppState &app, SceneData &&scene)
+{
+    pushUndo(app);
+    app.geom->setView(scene.l, scene.r, scene.b, scene.t);
+    app.shapes.assign(std::move(scene.shapes));
+    rebuildNames(app);
+    clearSelection(app);
+    app.hoveredShapeIndex = -1;
+    app.pointStep = 0;
+    requestAutosaveSnapshot(app);
+}
+
+bool saveDrawing(const AppState &app, const char *path)
+{
+    if (!app.geom)
+        return false;
+    std::ofstream ofs(resolveSavePath(path).string());
+    if (!ofs)
+        return false;
+    return writeScene(ofs, snapshotScene(app), [](float)
+                      { return true; });
+}
+
 bool loadDrawing(AppState &app, const char *path)
 {
     std::ifstream ifs(resolveSavePath(path).string());
-    if (!ifs)
+    if (!ifs || !app.geom)
+        return false;
+    SceneData scene;
+    if (!parseScene(ifs, scene, [](float)
+                    { return true; }))
+        return false;
+    applyScene(app, std::move(scene));
+    return true;
+}
+
+// Lưu ở luồng nền: chụp bản sao scene ngay (copy bộ nhớ), phần định dạng văn bản chạy nền
+static bool startSaveAsync(AppState &app, const char *path)
+{
+    if (!app.geom || app.ioTask.busy())
         return false;
+    auto scene = std::make_shared<SceneData>(snapshotScene(app));
+    std::string file = resolveSavePath(path).string();
+    app.ioKind = IO_SAVE;
+    app.ioStatus = "Saving " + file + "...";
+    return app.ioTask.start([scene, file](AsyncTask &task)
+                            {
+        // Ghi ra file tạm rồi đổi tên để file cũ không hỏng nếu ghi dở
+        std::string tmp = file + ".tmp";
+        {
+            std::ofstream ofs(tmp);
+            if (!ofs)
+            {
+                task.setError("Cannot open " + tmp);
+                return false;
+            }
+            bool ok = writeScene(ofs, *scene, [&](float p)
+                                 { task.setProgress(p); return !task.cancelled(); });
+            if (!ok)
+            {
+                task.setError(task.cancelled() ? "Save cancelled" : "Write error");
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmp, file, ec);
+        if (ec)
+        {
+            task.setError(ec.message());
+            return false;
+        }
+        return true; });
+}
 
-    float l, r, b, t;
-    if (!(ifs >> l >> r >> b >> t))
+// Đọc ở luồng nền vào scene riêng; scene chỉ được thay khi đọc xong và hợp lệ
+static bool startLoadAsync(AppState &app, const char *path)
+{
+    if (!app.geom || app.ioTask.busy())
         return false;
-    if (app.geom)
-        app.geom->setView(l, r, b, t);
+    app.pendingScene = std::make_shared<SceneData>();
+    auto scene = app.pendingScene;
+    std::string file = resolveSavePath(path).string();
+    app.ioKind = IO_LOAD;
+    app.ioStatus = "Loading " + file + "...";
+    return app.ioTask.start([scene, file](AsyncTask &task)
+                            {
+        std::ifstream ifs(file);
+        if (!ifs)
+        {
+            task.setError("Cannot open " + file);
+            return false;
+        }
+        if (!parseScene(ifs, *scene, [&](float p)
+                        { task.setProgress(p); return !task.cancelled(); }))
+        {
+            task.setError(task.cancelled() ? "Load cancelled" : "Invalid drawing file");
+            return false;
+        }
+        return true; });
+}
 
-    size_t count;
-    if (!(ifs >> count))
+// ---- Xuất vector (SVG/PDF) ----
+enum VectorFormat
+{
+    VEC_SVG = 0,
+    VEC_PDF
+};
+
+// Cắt đường thẳng p + u * d, u thuộc [u0, u1], theo hộp bx (Liang-Barsky); false nếu nằm ngoài
+static bool clipLine(Vec2 p, Vec2 d, double u0, double u1, const SceneIndex::Box &bx, Vec2 &a, Vec2 &b)
+{
+    auto clip = [&](double q, double dist)
+    {
+        // Điều kiện q * u <= dist
+        if (q == 0.0)
+            return dist >= 0.0;
+        double u = dist / q;
+        if (q < 0.0)
+            u0 = std::max(u0, u);
+        else
+            u1 = std::min(u1, u);
+        return u0 <= u1;
+    };
+    if (!clip(-d.x, p.x - bx.minX) || !clip(d.x, bx.maxX - p.x) || !clip(-d.y, p.y - bx.minY) || !clip(d.y, bx.maxY - p.y))
         return false;
+    a = {p.x + d.x * u0, p.y + d.y * u0};
+    b = {p.x + d.x * u1, p.y + d.y * u1};
+    return true;
+}
+
+// Ghi các hình chạm trang ra writer W (SvgWriter/PdfWriter) dưới dạng chính xác:
+// đường tròn/elip gốc, parabola = 1 Bézier bậc 2, mỗi nhánh hyperbola = các Bézier bậc 3 khớp tới 1/10 đơn vị trang;
+// hình vô hạn được cắt theo trang, polyline lớn dùng level LOD có sai số dưới 1/4 đơn vị trang
+template <typename W, typename Progress>
+static bool writeVectorScene(W &w, const std::vector<Shape> &shapes, const VectorPage &pg, Progress progress)
+{
+    const double unit = (pg.r - pg.l) / pg.width; // 1 đơn vị trang tính theo World
+    const SceneIndex::Box view{pg.l, pg.b, pg.r, pg.t};
+    std::vector<Vec2> curve;
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        if ((i & 4095) == 0 && !progress((float)i / (float)shapes.size()))
+            return false;
+        const Shape &s = shapes[i];
+        switch (s.kind)
+        {
+        case SH_INFINITE_LINE:
+        case SH_RAY:
+        {
+            Vec2 a, b, d = {s.p2.x - s.p1.x, s.p2.y - s.p1.y};
+            if ((d.x != 0.0 || d.y != 0.0) &&
+                clipLine(s.p1, d, s.kind == SH_RAY ? 0.0 : -HUGE_VAL, HUGE_VAL, view, a, b))
+                w.line(a, b, s.color);
+            continue;
+        }
+        case SH_PARABOLA:
+        {
+            // Dọc: y = X^2 / (4a) với X = x - đỉnh.x (ngang: đổi vai x, y). Chỉ phần X có y trong trang:
+            // X^2 <= 4a * (mép trang phía bề lõm - đỉnh)
+            double a = s.paramA;
+            if (std::abs(a) < 1e-6)
+                continue;
+            bool vert = s.isVertical;
+            double vx = vert ? s.p1.x : s.p1.y, vy = vert ? s.p1.y : s.p1.x;
+            double lo = vert ? pg.l : pg.b, hi = vert ? pg.r : pg.t;
+            double far = (a > 0.0) ? (vert ? pg.t : pg.r) : (vert ? pg.b : pg.l);
+            double R2 = 4.0 * a * (far - vy);
+            if (R2 <= 0.0)
+                continue;
+            double R = std::sqrt(R2);
+            double x0 = std::max(lo - vx, -R), x1 = std::min(hi - vx, R);
+            if (x0 >= x1)
+                continue;
+            // Cung parabola trên [x0, x1] đúng bằng Bézier bậc 2 có điểm điều khiển ((x0 + x1) / 2, x0 * x1 / (4a))
+            auto P = [&](double X, double Y)
+            { return vert ? Vec2{vx + X, vy + Y} : Vec2{vy + Y, vx + X}; };
+            w.quadratic(P(x0, x0 * x0 / (4.0 * a)), P(0.5 * (x0 + x1), x0 * x1 / (4.0 * a)), P(x1, x1 * x1 / (4.0 * a)), s.color);
+            continue;
+        }
+        case SH_HYPERBOLA:
+        {
+            // Ngang: x = cx +- a cosh u, y = cy + b sinh u (dọc: đổi vai x, y)
+            double ha = s.hyper_a, hb = s.hyper_b;
+            if (std::abs(ha) < 1e-6 || std::abs(hb) < 1e-6)
+                continue;
+            bool vert = s.isVertical;
+            double ra = vert ? hb : ha, rb = vert ? ha : hb; // Bán trục theo hướng mở / hướng còn lại
+            double cm = vert ? s.p1.y : s.p1.x, cs = vert ? s.p1.x : s.p1.y;
+            double mLo = vert ? pg.b : pg.l, mHi = vert ? pg.t : pg.r;
+            double sLo = vert ? pg.l : pg.b, sHi = vert ? pg.r : pg.t;
+            for (double sign : {1.0, -1.0})
+            {
+                double reach = (sign > 0.0) ? mHi - cm : cm - mLo; // Khoảng từ tâm tới mép trang phía nhánh
+                if (reach < ra)
+                    continue;
+                double U = std::acosh(reach / ra);
+                double u0 = std::max(-U, std::asinh((sLo - cs) / rb));
+                double u1 = std::min(U, std::asinh((sHi - cs) / rb));
+                if (u0 >= u1)
+                    continue;
+                auto point = [&](double u)
+                {
+                    double m = cm + sign * ra * std::cosh(u), o = cs + rb * std::sinh(u);
+                    return vert ? Vec2{o, m} : Vec2{m, o};
+                };
+                auto deriv = [&](double u)
+                {
+                    double m = sign * ra * std::sinh(u), o = rb * std::cosh(u);
+                    return vert ? Vec2{o, m} : Vec2{m, o};
+                };
+                curve.clear();
+                fitCubics(point, deriv, u0, u1, 0.1 * unit, curve);
+                w.cubics(point(u0), curve.data(), curve.size() / 3, s.color);
+            }
+            continue;
+        }
+        default:
+            break;
+        }
+
+        // Hình hữu hạn: bỏ qua nếu hộp bao (nới theo cỡ điểm) không chạm trang
+        SceneIndex::Box bx = shapeSelectBox(s);
+        double pad = s.pointSize * unit;
+        if (!view.intersects({bx.minX - pad, bx.minY - pad, bx.maxX + pad, bx.maxY + pad}))
+            continue;
+        switch (s.kind)
+        {
+        case SH_POINT:
+            w.dot(s.p1, s.pointSize, s.color);
+            if (!s.name.empty() && s.showName)
+                w.text(s.p1, s.name, 14.0, 6.0, 6.0, s.color);
+            break;
+        case SH_LINE:
+            w.line(s.p1, s.p2, s.color);
+            break;
+        case SH_CIRCLE:
+            w.circle(s.p1, s.radius, s.color);
+            break;
+        case SH_ELLIPSE:
+            w.ellipse(s.p1, s.a, s.b, s.angle, s.color);
+            break;
+        case SH_POLYLINE:
+        {
+            const PolylineLOD *lod = getPolylineLOD(s);
+            size_t level = lod ? lod->pickLevel(0.25 * unit) : 0;
+            if (level > 0)
+                w.polyline(lod->level(level).pts.data(), lod->level(level).pts.size(), s.color);
+            else
+                w.polyline(s.poly.data(), s.poly.size(), s.color);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return progress(1.0f);
+}
+
+// Xuất vùng đang nhìn ra SVG/PDF ở luồng nền (cùng cơ chế với lưu file). Trang rộng pageWidth đơn vị,
+// cao theo tỉ lệ vùng nhìn; đuôi file được đổi theo định dạng
+static bool startVectorExportAsync(AppState &app, const char *path, VectorFormat fmt, double pageWidth)
+{
+    if (!app.geom || app.ioTask.busy())
+        return false;
+    auto scene = std::make_shared<SceneData>(snapshotScene(app));
+    VectorPage pg;
+    pg.l = scene->l, pg.r = scene->r, pg.b = scene->b, pg.t = scene->t;
+    pg.width = std::max(1.0, pageWidth);
+    pg.height = pg.width * (pg.t - pg.b) / (pg.r - pg.l);
+    std::string file = resolveSavePath(path).replace_extension(fmt == VEC_SVG ? ".svg" : ".pdf").string();
+    app.ioKind = IO_EXPORT;
+    app.ioStatus = "Exporting " + file + "...";
+    return app.ioTask.start([scene, pg, file, fmt](AsyncTask &task)
+                            {
+        auto progress = [&](float p)
+        { task.setProgress(p); return !task.cancelled(); };
+        auto run = [&](auto &writer)
+        {
+            if (!writer.open(file, pg))
+            {
+                task.setError(writer.error());
+                return false;
+            }
+            bool ok = writeVectorScene(writer, scene->shapes, pg, progress);
+            ok = writer.close() && ok;
+            if (!ok)
+            {
+                task.setError(task.cancelled() ? "Export cancelled" : writer.error());
+                std::error_code ec;
+                fs::remove(file, ec);
+            }
+            return ok;
+        };
+        if (fmt == VEC_SVG)
+        {
+            SvgWriter svg;
+            return run(svg);
+        }
+        PdfWriter pdf;
+        return run(pdf); });
+}
+
+// ---- Autosave ----
+static const size_t AUTOSAVE_COMPACT_RECORDS = 2000;                   // Nén khi nhật ký dài quá
+static const std::chrono::seconds AUTOSAVE_COMPACT_INTERVAL{60};        // hoặc định kỳ
+
+// Id của các bản vẽ có file autosave (doc<id>.snapshot / doc<id>.journal) trong thư mục của phiên, tăng dần
+static std::vector<int> autosavedDocumentIds(const AppState &app)
+{
+    std::vector<int> ids;
+    std::error_code ec;
+    for (fs::directory_iterator it(app.autosaveDir.path(), ec), end; !ec && it != end; it.increment(ec))
+    {
+        std::string stem = it->path().stem().string(), ext = it->path().extension().string();
+        if ((ext != ".snapshot" && ext != ".journal") || stem.size() < 4 || stem.compare(0, 3, "doc") != 0 ||
+            stem.find_first_not_of("0123456789", 3) != std::string::npos || stem.size() > 12)
+            continue;
+        ids.push_back(std::atoi(stem.c_str() + 3));
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+// Khởi động: nếu nhận lại thư mục của một phiên đã crash thì dựng lại từng bản vẽ (mỗi tab một cặp
+// snapshot + nhật ký) và ghi tiếp; không thì bắt đầu nhật ký mới cho tab đầu tiên
+static void startAutosave(AppState &app)
+{
+    if (!app.autosaveDir.acquire(AutosaveDir::defaultBase()))
+    {
+        std::cerr << "Warning: autosave disabled, cannot create " << AutosaveDir::defaultBase().string() << "\n";
+        return;
+    }
+    size_t totalReplayed = 0;
+    for (int id : autosavedDocumentIds(app))
+    {
+        std::string snapshotFile = autosaveFile(app, id, ".snapshot");
+        std::string journalFile = autosaveFile(app, id, ".journal");
+        SceneData scene;
+        uint64_t epoch = 0;
+        bool haveSnapshot = Journal::readSnapshot(snapshotFile, epoch, [&](std::istream &in)
+                                                  { return parseScene(in, scene, [](float)
+                                                                      { return true; }); });
+        if (!haveSnapshot)
+        {
+            epoch = 0;
+            scene = SceneData();
+        }
+        size_t replayed = Journal::readRecords(journalFile, epoch, [&](const std::string &rec)
+                                               { applyJournalRecord(scene.shapes, rec); });
+        if (!haveSnapshot && replayed == 0)
+        {
+            // Không còn gì dùng được: bỏ file để id không bị dùng lại với dữ liệu cũ
+            std::error_code ec;
+            fs::remove(snapshotFile, ec);
+            fs::remove(journalFile, ec);
+            continue;
+        }
+        totalReplayed += replayed;
+        app.nextDocId = std::max(app.nextDocId, id + 1);
+        int slot;
+        if (app.docs[0].journal)
+        {
+            // Các bản vẽ sau được cất thành tab không hoạt động
+            Document doc;
+            doc.id = id;
+            doc.title = "Untitled " + std::to_string(id + 1);
+            if (haveSnapshot)
+                doc.l = scene.l, doc.r = scene.r, doc.b = scene.b, doc.t = scene.t;
+            doc.shapes.assign(std::move(scene.shapes));
+            for (size_t i = 0; i < doc.shapes.size(); ++i)
+                doc.names.add(doc.shapes[i].name, doc.shapes.handleAt(i));
+            app.docs.push_back(std::move(doc));
+            slot = (int)app.docs.size() - 1;
+        }
+        else
+        {
+            // Bản vẽ đầu tiên vào tab đang hoạt động
+            slot = 0;
+            app.docs[0].id = id;
+            app.docs[0].title = "Untitled " + std::to_string(id + 1);
+            if (haveSnapshot)
+                app.geom->setView(scene.l, scene.r, scene.b, scene.t);
+            app.shapes.assign(std::move(scene.shapes));
+            rebuildNames(app);
+        }
+        openDocumentJournal(app, slot, epoch, replayed > 0);
+        app.docs[slot].autosaveNeedsSnapshot = true;
+    }
+    if (app.docs[0].journal)
+        app.ioStatus = "Recovered " + std::to_string(app.docs.size()) + " drawing(s) from autosave (" +
+                       std::to_string(totalReplayed) + " journal ops)";
+    else
+        openDocumentJournal(app, 0, 0, false);
+}
+
+// Gọi mỗi frame: nén nhật ký của từng bản vẽ thành snapshot khi cần (ghi ở luồng nền của Journal)
+static void autosaveTick(AppState &app)
+{
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < app.docs.size(); ++i)
+    {
+        Document &doc = app.docs[i];
+        if (!doc.journal || !doc.journal->isOpen())
+            continue;
+        size_t pending = doc.journal->recordsSinceSnapshot();
+        if (doc.autosaveNeedsSnapshot || pending >= AUTOSAVE_COMPACT_RECORDS ||
+            (pending > 0 && now - doc.lastAutosaveSnapshot >= AUTOSAVE_COMPACT_INTERVAL))
+        {
+            auto scene = std::make_shared<SceneData>(snapshotScene(app, (int)i));
+            doc.journal->snapshot([scene](std::ostream &os)
+                                  { return writeScene(os, *scene, [](float)
+                                                      { return true; }); });
+            doc.autosaveNeedsSnapshot = false;
+            doc.lastAutosaveSnapshot = now;
+        }
+    }
+}
+
+// Gọi mỗi frame: hoàn tất việc đọc/ghi nền nếu vừa xong
+static void finishAsyncIO(AppState &app)
+{
+    if (!app.ioTask.poll())
+        return;
+    // Đọc/ghi nền khóa việc đổi bản vẽ nên kết quả luôn thuộc về bản vẽ đang hoạt động
+    Document &doc = app.docs[app.activeDoc];
+    if (!app.ioTask.succeeded())
+        app.ioStatus = app.ioTask.error();
+    else if (app.ioKind == IO_COMPUTE)
+    {
+        PointSetResult &res = *app.pendingCompute;
+        if (!res.shapes.empty())
+        {
+            pushUndo(app);
+            for (Shape &s : res.shapes)
+                addShape(app, std::move(s));
+        }
+        app.computeStatus = res.status;
+        app.ioStatus.clear();
+    }
+    else if (app.ioKind == IO_LOAD)
+    {
+        applyScene(app, std::move(*app.pendingScene));
+        app.ioStatus = "Loaded";
+        doc.title = fs::path(doc.filePath).filename().string();
+    }
+    else if (app.ioKind == IO_SAVE)
+    {
+        app.ioStatus = "Saved";
+        doc.title = fs::path(doc.filePath).filename().string();
+    }
+    else
+        app.ioStatus = "Exported";
+    app.pendingScene.reset();
+    app.pendingCompute.reset();
+    app.ioKind = IO_NONE;
+}
+
+// ---- Xuất ảnh lớn theo tile ----
+// Số đoạn để sai số dây cung của đường tròn bán kính radius dưới 1/4 pixel (px = cỡ pixel, World)
+static int segmentsForPixel(double radius, double px)
+{
+    double e = 0.25 * px;
+    if (radius <= e)
+        return 8;
+    return (int)std::min(65536.0, std::ceil(3.14159265358979323846 / std::acos(1.0 - e / radius)));
+}
+
+// Như drawShape nhưng đường tròn/elip được chia đủ mịn cho độ phân giải ảnh (số đoạn lưu trong
+// hình chọn cho màn hình, ở ảnh 32k pixel sẽ thấy gãy khúc)
+static void drawShapeForExport(const Shape &s, GeometryRenderer &geom, double px)
+{
+    if (s.kind == SH_CIRCLE)
+        geom.drawCircle(s.p1, s.radius, s.color, std::max(s.segments, segmentsForPixel(s.radius, px)));
+    else if (s.kind == SH_ELLIPSE)
+        geom.drawEllipse(s.p1, s.a, s.b, s.angle, s.color, std::max(s.segments, segmentsForPixel(std::max(s.a, s.b), px)));
+    else
+        drawShape(s, geom);
+}
+
+static bool startImageExport(AppState &app, const std::string &path, int width, int height)
+{
+    ImageExportJob &job = app.imageExport;
+    if (!app.geom || job.out.active())
+        return false;
+    // Vùng đang nhìn, nới theo tỉ lệ ảnh quanh tâm
+    double l, r, b, t;
+    app.geom->getView(l, r, b, t);
+    double cx = 0.5 * (l + r), cy = 0.5 * (b + t);
+    double hw = 0.5 * (r - l), hh = 0.5 * (t - b);
+    if (hw * height < hh * width)
+        hw = hh * width / height;
+    else
+        hh = hw * height / width;
+    job.l = cx - hw, job.r = cx + hw, job.b = cy - hh, job.t = cy + hh;
+    job.spacing = gridSpacing(2.0 * hw);
+    double px = 2.0 * hw / width;
+
+    job.shapes = app.shapes.items();
+    job.bounded.clear();
+    job.unbounded.clear();
+    std::vector<SceneIndex::Box> boxes;
+    for (size_t i = 0; i < job.shapes.size(); ++i)
+    {
+        const Shape &s = job.shapes[i];
+        if (s.kind == SH_INFINITE_LINE || s.kind == SH_RAY || s.kind == SH_PARABOLA || s.kind == SH_HYPERBOLA)
+        {
+            job.unbounded.push_back((int)i);
+            continue;
+        }
+        // Nới hộp theo cỡ điểm/nét (pixel) để tile kề bên vẫn vẽ phần nét tràn sang
+        SceneIndex::Box bx = shapeSelectBox(s);
+        double pad = (s.pointSize + 2.0) * px;
+        boxes.push_back({bx.minX - pad, bx.minY - pad, bx.maxX + pad, bx.maxY + pad});
+        job.bounded.push_back((int)i);
+    }
+    job.index.build(boxes);
+    // Tên điểm nằm lệch (10, -20) pixel so với điểm: tile cần cả các điểm ngoài nó trong phạm vi này
+    float nameW = 0.0f;
+    for (const Shape &s : job.shapes)
+        if (hasVisibleName(s))
+            nameW = std::max(nameW, ImGui::CalcTextSize(s.name.c_str()).x);
+    job.labelMargin = nameW + ImGui::GetFontSize() + 24.0;
+    if (!job.labels)
+        job.labels = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
+    job.path = path;
+    if (!job.out.start(path, width, height))
+    {
+        app.exportStatus = job.out.error();
+        job.shapes.clear();
+        return false;
+    }
+    app.exportStatus = "Exporting " + path + "...";
+    return true;
+}
+
+static void endImageExport(AppState &app, bool ok)
+{
+    ImageExportJob &job = app.imageExport;
+    app.exportStatus = ok ? "Exported " + job.path : job.out.error();
+    std::vector<Shape>().swap(job.shapes);
+    job.index.build({});
+    job.labels.reset();
+}
+
+// Gọi mỗi frame khi đang xuất: vẽ các dải kế tiếp trong khoảng ~20 ms rồi trả lại cho frame bình thường
+static void imageExportTick(AppState &app, GeometryRenderer &geom, Shader &shader)
+{
+    ImageExportJob &job = app.imageExport;
+    if (!job.out.active())
+        return;
+    double l, r, b, t;
+    geom.getView(l, r, b, t);
+    double px = (job.r - job.l) / job.out.width();
+    double py = (job.t - job.b) / job.out.height();
+    auto drawTile = [&](int x0, int y0, int tw, int th)
+    {
+        double tl = job.l + x0 * px, tr = job.l + (x0 + tw) * px;
+        double tt = job.t - y0 * py, tb = job.t - (y0 + th) * py;
+        geom.setView(tl, tr, tb, tt);
+        geom.setViewportSize(tw, th);
+        geom.beginFrame();
+        glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        geom.drawGrid(job.spacing, GRID_COLOR, AXIS_COLOR, app.showGrid, app.showAxis);
+        shader.use();
+        shader.setInt("u_useOverride", 0);
+        // Hình chạm tile (qua chỉ mục) + hình vô hạn, vẽ theo thứ tự gốc để hình sau vẫn đè hình trước
+        job.tileHits.assign(job.unbounded.begin(), job.unbounded.end());
+        job.index.forEachIntersecting({tl, tb, tr, tt}, [&](uint32_t id)
+                                      { job.tileHits.push_back(job.bounded[id]); });
+        std::sort(job.tileHits.begin(), job.tileHits.end());
+        for (int i : job.tileHits)
+            drawShapeForExport(job.shapes[i], geom, px);
+
+        // Chữ: dựng draw list cho riêng tile rồi vẽ bằng backend ImGui vào FBO đang bind
+        ImDrawList &dl = *job.labels;
+        dl._ResetForNewFrame();
+        dl.PushTexture(ImGui::GetIO().Fonts->TexRef);
+        dl.PushClipRect(ImVec2(0.0f, 0.0f), ImVec2((float)tw, (float)th));
+        CanvasRect tc;
+        tc.w = tw, tc.h = th;
+        LabelTarget to{&dl, tl, tr, tb, tt, tc};
+        double mx = job.labelMargin * px, my = job.labelMargin * py;
+        job.tileHits.clear();
+        job.index.forEachIntersecting({tl - mx, tb - my, tr + mx, tt + my}, [&](uint32_t id)
+                                      { job.tileHits.push_back(job.bounded[id]); });
+        std::sort(job.tileHits.begin(), job.tileHits.end());
+        for (int i : job.tileHits)
+            drawPointName(geom, to, job.shapes[i]);
+        drawAxisLabels(to, app, job.spacing, job.l, job.r, job.b, job.t, job.r);
+        ImDrawData dd;
+        dd.Valid = true;
+        dd.DisplaySize = ImVec2((float)tw, (float)th);
+        dd.FramebufferScale = ImVec2(1.0f, 1.0f);
+        dd.Textures = &ImGui::GetPlatformIO().Textures; // Glyph vừa được nạp vào atlas phải lên GPU trước khi vẽ
+        dd.AddDrawList(&dl);
+        if (dd.CmdListsCount > 0)
+            ImGui_ImplOpenGL3_RenderDrawData(&dd);
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+    bool more;
+    do
+        more = job.out.step(drawTile);
+    while (more && std::chrono::steady_clock::now() < deadline);
+    geom.setView(l, r, b, t);
+    if (!more)
+        endImageExport(app, job.out.error().empty() && job.out.finish());
+}
 
-    app.shapes.clear();
-    for (size_t i = 0; i < count; ++i)
-    {
-        int k;
-        float cr, cg, cb;
-        ifs >> k >> cr >> cg >> cb;
-        Shape s;
-        s.kind = (ShapeKind)k;
-        s.color = {cr, cg, cb};
+// ---- Tìm mọi giao điểm (đường quét isect) ----
 
+// Đổi các hình sang đầu vào của đường quét; ellipse/parabola/hyperbola chưa hỗ trợ (đếm vào skipped)
+static isect::Scene buildIntersectionScene(const std::vector<Shape> &shapes, size_t &skipped)
+{
+    isect::Scene scene;
+    skipped = 0;
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        const Shape &s = shapes[i];
+        int id = (int)i;
         switch (s.kind)
         {
-        case SH_POINT:
-            ifs >> s.p1.x >> s.p1.y >> s.pointSize >> s.showName >> s.name;
-            if (s.name == "null")
-                s.name = "";
-            std::replace(s.name.begin(), s.name.end(), '_', ' ');
-            break;
         case SH_LINE:
-            ifs >> s.p1.x >> s.p1.y >> s.p2.x >> s.p2.y;
+            scene.addSegment(s.p1, s.p2, id);
             break;
         case SH_INFINITE_LINE:
+            scene.addLine(s.p1, s.p2, id);
+            break;
         case SH_RAY:
-            ifs >> s.p1.x >> s.p1.y >> s.p2.x >> s.p2.y;
+            scene.addRay(s.p1, s.p2, id);
             break;
         case SH_CIRCLE:
-            ifs >> s.p1.x >> s.p1.y >> s.radius >> s.segments;
+            scene.addCircle(s.p1, s.radius, id);
             break;
-        case SH_ELLIPSE:
-            ifs >> s.p1.x >> s.p1.y >> s.a >> s.b >> s.angle >> s.segments;
+        case SH_POLYLINE:
+            for (size_t j = 0; j + 1 < s.poly.size(); ++j)
+                scene.addSegment(s.poly[j], s.poly[j + 1], id, (int)j);
             break;
+        case SH_ELLIPSE:
         case SH_PARABOLA:
-            ifs >> s.p1.x >> s.p1.y >> s.paramA >> s.isVertical;
-            break;
         case SH_HYPERBOLA:
-            ifs >> s.p1.x >> s.p1.y >> s.hyper_a >> s.hyper_b >> s.isVertical;
+            ++skipped;
             break;
-        case SH_POLYLINE:
-            size_t n;
-            ifs >> n;
-            s.poly.resize(n);
-            for (size_t j = 0; j < n; ++j)
-                ifs >> s.poly[j].x >> s.poly[j].y;
+        default:
             break;
         }
-        app.shapes.push_back(s);
     }
-    return true;
+    return scene;
+}
+
+// Thêm mỗi giao điểm (bỏ trùng tọa độ) thành một điểm mới, cả nhóm chỉ tốn 1 lần Undo.
+// Điểm không đặt tên: có thể có hàng nghìn giao điểm, hàng nghìn nhãn tên sẽ che kín bản vẽ.
+static void computeAllIntersections(AppState &app)
+{
+    size_t skipped;
+    isect::Scene scene = buildIntersectionScene(app.shapes.items(), skipped);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<IntersectionHit> hits = isect::sweep(scene);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::vector<Vec2> pts;
+    pts.reserve(hits.size());
+    for (const IntersectionHit &h : hits)
+        pts.push_back(h.p);
+    std::sort(pts.begin(), pts.end(), isect::lexLess);
+    pts.erase(std::unique(pts.begin(), pts.end(), isect::samePoint), pts.end());
+    if (!pts.empty())
+    {
+        pushUndo(app);
+        for (const Vec2 &p : pts)
+        {
+            Shape s;
+            s.kind = SH_POINT;
+            s.p1 = p;
+            s.pointSize = app.pointSize;
+            s.color = app.paintColor;
+            s.showName = false;
+            addShape(app, s);
+        }
+    }
+
+    std::ostringstream os;
+    os << pts.size() << " intersection points (" << hits.size() << " pairs) in "
+       << std::fixed << std::setprecision(1) << ms << " ms";
+    if (skipped > 0)
+        os << ", skipped " << skipped << " ellipse/parabola/hyperbola";
+    app.computeStatus = os.str();
+}
+
+// ---- Hình học trên tập điểm (pset) ----
+
+enum PointSetOp
+{
+    PS_HULL,
+    PS_CLOSEST_PAIR,
+    PS_DELAUNAY,
+    PS_VORONOI
+};
+
+// Đầu vào: các đỉnh của polyline đang chọn, nếu không thì mọi điểm (SH_POINT)
+static std::vector<Vec2> collectPointSet(const AppState &app)
+{
+    int sel = app.selectedShapeIndex;
+    if (sel >= 0 && sel < (int)app.shapes.size() && app.shapes[sel].kind == SH_POLYLINE)
+        return app.shapes[sel].poly;
+    std::vector<Vec2> pts;
+    for (const Shape &s : app.shapes)
+        if (s.kind == SH_POINT)
+            pts.push_back(s.p1);
+    return pts;
+}
+
+// Chạy ở luồng nền, không đụng tới AppState. Đồ thị (Delaunay/Voronoi) được tách thành các
+// đường đi dài, mỗi đường đi là một polyline, thay vì mỗi cạnh một hình.
+static void runPointSetOp(const std::vector<Vec2> &pts, PointSetOp op, Color color, PointSetResult &res)
+{
+    int threads = pset::defaultThreads();
+    std::vector<Shape> &out = res.shapes;
+    auto lineShape = [&](ShapeKind kind, Vec2 a, Vec2 b)
+    {
+        Shape s;
+        s.kind = kind;
+        s.p1 = a;
+        s.p2 = b;
+        s.color = color;
+        return s;
+    };
+    auto addPath = [&](std::vector<Vec2> poly)
+    {
+        if (poly.size() == 2)
+        {
+            out.push_back(lineShape(SH_LINE, poly[0], poly[1]));
+            return;
+        }
+        Shape s;
+        s.kind = SH_POLYLINE;
+        s.color = color;
+        s.poly = std::move(poly);
+        out.push_back(std::move(s));
+    };
+    auto addGraph = [&](const std::vector<Vec2> &verts, const std::vector<pset::IndexEdge> &edges)
+    {
+        for (const std::vector<int> &path : pset::chainPaths(verts.size(), edges))
+        {
+            std::vector<Vec2> poly;
+            poly.reserve(path.size());
+            for (int v : path)
+                poly.push_back(verts[v]);
+            addPath(std::move(poly));
+        }
+    };
+
+    std::ostringstream os;
+    auto t0 = std::chrono::steady_clock::now();
+    switch (op)
+    {
+    case PS_HULL:
+    {
+        std::vector<int> hull = pset::convexHull(pts, threads);
+        std::vector<Vec2> poly;
+        for (int i : hull)
+            poly.push_back(pts[i]);
+        if (poly.size() > 2)
+            poly.push_back(poly.front()); // Khép kín
+        if (poly.size() >= 2)
+            addPath(std::move(poly));
+        os << "Convex hull: " << hull.size() << " vertices";
+        break;
+    }
+    case PS_CLOSEST_PAIR:
+    {
+        pset::ClosestPair cp = pset::closestPair(pts, threads);
+        out.push_back(lineShape(SH_LINE, pts[cp.a], pts[cp.b]));
+        os << "Closest pair: distance " << std::setprecision(10) << cp.dist;
+        break;
+    }
+    case PS_DELAUNAY:
+    {
+        pset::DelaunayMesh mesh;
+        mesh.build(pts, threads);
+        std::vector<pset::IndexEdge> edges = mesh.edges();
+        addGraph(pts, edges);
+        os << "Delaunay: " << edges.size() << " edges";
+        break;
+    }
+    case PS_VORONOI:
+    {
+        pset::DelaunayMesh mesh;
+        mesh.build(pts, threads);
+        pset::VoronoiDiagram vor = mesh.voronoi();
+        addGraph(vor.vertices, vor.edges);
+        for (const auto &r : vor.rays)
+        {
+            Vec2 o = vor.vertices[r.first];
+            out.push_back(lineShape(SH_RAY, o, {o.x + r.second.x, o.y + r.second.y}));
+        }
+        for (const auto &l : vor.lines)
+            out.push_back(lineShape(SH_INFINITE_LINE, l.first, l.second));
+        os << "Voronoi: " << vor.vertices.size() << " vertices, " << vor.edges.size() + vor.rays.size() + vor.lines.size() << " edges";
+        break;
+    }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    os << " from " << pts.size() << " points in " << std::fixed << std::setprecision(1) << ms << " ms";
+    res.status = os.str();
+}
+
+// Tính trên luồng I/O nền (1M điểm Delaunay/Voronoi mất vài giây): đầu vào được chép ngay, kết quả
+// được thêm thành hình mới (cả nhóm 1 lần Undo) trong finishAsyncIO như khi đọc file
+static bool startPointSetAsync(AppState &app, PointSetOp op)
+{
+    if (!app.geom || app.ioTask.busy())
+        return false;
+    auto pts = std::make_shared<std::vector<Vec2>>(collectPointSet(app));
+    if (pts->size() < 2)
+    {
+        app.computeStatus = "Need at least 2 points (or a selected polyline)";
+        return false;
+    }
+    static const char *names[] = {"convex hull", "closest pair", "Delaunay", "Voronoi"};
+    app.pendingCompute = std::make_shared<PointSetResult>();
+    auto res = app.pendingCompute;
+    Color color = app.paintColor;
+    app.ioKind = IO_COMPUTE;
+    app.ioStatus = std::string("Computing ") + names[op] + "...";
+    return app.ioTask.start([pts, op, color, res](AsyncTask &task)
+                            {
+        runPointSetOp(*pts, op, color, *res);
+        // Thuật toán không chia bước nên chỉ kiểm tra hủy khi xong: kết quả bị bỏ
+        if (task.cancelled())
+        {
+            task.setError("Compute cancelled");
+            return false;
+        }
+        return true; });
+}
+
+
+// app --intersect <scene> [--brute]: in mọi giao điểm "x y shapeA shapeB" ra stdout rồi thoát
+static int runIntersectCli(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: app --intersect <scene.txt> [--brute]\n";
+        return 2;
+    }
+    bool brute = argc > 3 && std::string(argv[3]) == "--brute";
+    std::ifstream ifs(argv[2]);
+    SceneData data;
+    if (!ifs || !parseScene(ifs, data, [](float)
+                            { return true; }))
+    {
+        std::cerr << "Cannot read scene " << argv[2] << "\n";
+        return 1;
+    }
+    size_t skipped;
+    isect::Scene scene = buildIntersectionScene(data.shapes, skipped);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<IntersectionHit> hits = brute ? isect::bruteForce(scene) : isect::sweep(scene);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << std::setprecision(std::numeric_limits<double>::max_digits10);
+    for (const IntersectionHit &h : hits)
+        std::cout << h.p.x << " " << h.p.y << " " << h.shapeA << " " << h.shapeB << "\n";
+    std::cerr << hits.size() << " intersections among " << scene.size() << " curves in " << ms << " ms";
+    if (skipped > 0)
+        std::cerr << " (skipped " << skipped << " ellipse/parabola/hyperbola)";
+    std::cerr << "\n";
+    return 0;
 }
 
 // ================= MAIN =================
-int main()
+int main(int argc, char **argv)
 {
+    // app --bench: chạy benchmark rồi thoát, không mở cửa sổ
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+        return runBenchmarks();
+    // app --intersect <scene> [--brute]: tính mọi giao điểm của file bản vẽ rồi thoát
+    if (argc > 1 && std::string(argv[1]) == "--intersect")
+        return runIntersectCli(argc, argv);
+
     if (!glfwInit())
         return -1;
 
@@ -869,7 +3169,8 @@ int main()
     }
 
     glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+    int swapInterval = 1;
+    glfwSwapInterval(swapInterval);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
         return -1;
@@ -879,6 +3180,10 @@ int main()
     glfwSetMouseButtonCallback(window, canvas_mouse_button_callback);
     glfwSetCursorPosCallback(window, canvas_cursor_position_callback);
     glfwSetKeyCallback(window, canvas_key_callback);
+    glfwSetCharCallback(window, canvas_char_callback);
+    glfwSetWindowRefreshCallback(window, canvas_refresh_callback);
+    glfwSetWindowFocusCallback(window, canvas_focus_callback);
+    glfwSetCursorEnterCallback(window, canvas_cursor_enter_callback);
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -895,147 +3200,218 @@ int main()
     Shader shader("shaders/vertex.glsl", "shaders/fragment.glsl");
     GeometryRenderer geom(shader);
     geom.setView(-2.0f, 2.0f, -1.5f, 1.5f);
+    Shader conicShader("shaders/conic_vertex.glsl", "shaders/conic_fragment.glsl");
+    geom.setConicShader(&conicShader);
 
     AppState app;
     app.geom = &geom;
     glfwSetWindowUserPointer(window, &app);
 
-    Color gridCol{0.3f, 0.3f, 0.3f};
-    Color axisCol{0.6f, 0.6f, 0.6f};
-    Color labelCol{0.9f, 0.9f, 0.9f};
+    startAutosave(app);
+
+    FrameProfiler profiler;
+    profiler.init();
+
+    // Số liệu của frame trước (hiển thị trong Stats panel)
+    RenderStats lastRenderStats;
+    QueryStats lastQueryStats;
+    HeapStats lastHeapStats;
+    size_t frameAllocStart = heapAllocCount();
 
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        // Vẽ theo yêu cầu: khi không còn gì thay đổi thì ngủ tới sự kiện kế tiếp (hoặc hết hạn chờ
+        // để autosave vẫn chạy). Việc nền đang chạy (import, đọc/ghi file) cần vẽ thanh tiến độ mỗi frame.
+        bool busy = app.importing || app.ioKind != IO_NONE || app.imageExport.out.active();
+        bool drawing = !app.renderOnDemand || busy || g_redrawFrames > 0;
+        // Late latch: ngủ tới sát vblank rồi mới đọc input, để input mới nhất kịp lên frame này
+        if (drawing && app.pacing == PACE_LATE_LATCH)
+            g_pacer.waitForLatch();
+        if (drawing)
+            glfwPollEvents();
+        else
+            glfwWaitEventsTimeout(IDLE_WAKE_SECONDS);
+        flushCursorMove(window);
+
+        // Scene đọc xong ở luồng nền được thay vào đây, trước khi vẽ
+        finishAsyncIO(app);
+        if (busy && app.ioKind == IO_NONE)
+            requestRedraw();
+        autosaveTick(app);
+        if (app.renderOnDemand && !busy && g_redrawFrames <= 0)
+            continue;
+        g_redrawFrames--;
+        g_pacer.latchInput();
+        int wantedInterval = (app.pacing == PACE_UNCAPPED) ? 0 : 1;
+        if (wantedInterval != swapInterval)
+        {
+            glfwSwapInterval(wantedInterval);
+            swapInterval = wantedInterval;
+        }
+        // Ô nhập chữ đang mở cần vẽ tiếp để con trỏ nhấp nháy
+        if (ImGui::GetIO().WantTextInput)
+            requestRedraw();
+        profiler.beginFrame();
+
+        // Truy vấn hover/snap chạy ngay sau glfwPollEvents (đã gom các lần di chuột), nên chốt số liệu ngay sau đó
+        lastRenderStats = geom.getStats();
+        lastQueryStats = getQueryStats();
+        geom.resetStats();
+        resetQueryStats();
+        geom.beginFrame();
+        lastHeapStats.frameAllocs = heapAllocCount() - frameAllocStart;
+        frameAllocStart = heapAllocCount();
+
+        // Lấy dần các khúc đã parse (giới hạn mỗi frame để không giật)
+        if (app.importing)
+        {
+            if (app.importer.drain(app.importShape.poly, 4) > 0)
+                extendPolylineCaches(app.importShape);
+            if (!app.importer.active())
+            {
+                app.importError = app.importer.error();
+                app.importer.stop();
+                if (app.importShape.poly.size() >= 2)
+                {
+                    pushUndo(app);
+                    addShape(app, std::move(app.importShape));
+                }
+                app.importShape = Shape();
+                app.importing = false;
+                requestRedraw();
+            }
+        }
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // Xuất ảnh: vài dải mỗi frame (FBO riêng, trả lại framebuffer mặc định khi xong). Chạy trong frame ImGui
+        // vì chữ trên ảnh dùng font của ImGui
+        imageExportTick(app, geom, shader);
+
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        float l, r, b, t;
+        size_t renderAllocStart = heapAllocCount();
+        // Chỉ vẽ các canvas đang hiện: chế độ tab chỉ có bản vẽ hoạt động; chia màn hình thì các bản vẽ
+        // đang cất được vẽ trước, mỗi bản trong cột của nó (scissor cắt phần tràn), cùng 1 shader/VBO.
+        // Bản vẽ hoạt động vẽ sau cùng để geom giữ view/viewport của nó cho các callback chuột.
+        double l, r, b, t;
         geom.getView(l, r, b, t);
-
-        float worldWidth = r - l;
-        float spacing = 0.25f;
-        while (spacing * 10.0f < worldWidth)
-            spacing *= 2.0f;
-        while (spacing * 2.0f > worldWidth && spacing > 1e-6f)
-            spacing *= 0.5f;
-
-        geom.drawGrid(spacing, gridCol, axisCol, app.showGrid, app.showAxis);
-
-        shader.use();
-        shader.setInt("u_useOverride", 0);
-
-        // Vẽ các hình chính
-        for (size_t i = 0; i < app.shapes.size(); ++i)
+        glEnable(GL_SCISSOR_TEST);
+        for (int d = 0; d < (int)app.docs.size(); ++d)
         {
-            // Nếu hình này đang được Select, bỏ qua để vẽ sau (cho nó nổi lên trên)
-            if ((int)i == app.selectedShapeIndex)
+            CanvasRect c;
+            if (d == app.activeDoc || !documentCanvas(app, d, display_w, display_h, c))
                 continue;
-            drawShape(app.shapes[i], geom);
-
-            // --- SỬA ĐOẠN VẼ TÊN ĐIỂM ---
-            if (app.shapes[i].kind == SH_POINT && !app.shapes[i].name.empty() && app.shapes[i].showName)
-            {
-                Vec2 p = app.shapes[i].p1;
-
-                // Chuyển đổi World -> NDC (Normalized Device Coordinates)
-                // Công thức: (val - min) / (max - min) * 2 - 1
-                float ndcX = (2.0f * (p.x - l) / (r - l)) - 1.0f;
-                float ndcY = (2.0f * (p.y - b) / (t - b)) - 1.0f;
-
-                // Chuyển đổi NDC -> Screen Coordinates (Pixel)
-                // Lưu ý: ImGui gốc tọa độ (0,0) là góc TRÊN-TRÁI
-                // OpenGL gốc tọa độ (-1,-1) là góc DƯỚI-TRÁI
-                float screenX = (ndcX + 1.0f) * 0.5f * display_w;
-                float screenY = (1.0f - ndcY) * 0.5f * display_h;
-
-                // Offset text lên trên và sang phải một chút để không đè vào điểm
-                geom.drawText(app.shapes[i].name, screenX + 10.0f, screenY - 20.0f, app.shapes[i].color);
-            }
-            // -----------------------------
+            const Document &doc = app.docs[d];
+            geom.setView(doc.l, doc.r, doc.b, doc.t);
+            drawDocumentLayer(geom, shader, profiler, app, doc.shapes, doc.selectedMask, c, display_w);
         }
-
-        // --- 1. HIGHLIGHT SELECTED SHAPE (Click Selection) ---
-        // Vẽ hình đang chọn với màu Đậm (Đỏ Cam) và nét to hơn
-        if (app.selectedShapeIndex != -1 && app.selectedShapeIndex < (int)app.shapes.size())
+        geom.setView(l, r, b, t);
+        CanvasRect canvas;
+        documentCanvas(app, app.activeDoc, display_w, display_h, canvas);
+        drawDocumentLayer(geom, shader, profiler, app, app.shapes, app.selectedMask, canvas, display_w);
+        if (app.splitView && app.docs.size() > 1)
+            ImGui::GetBackgroundDrawList()->AddRect(ImVec2((float)canvas.x, 0.0f), ImVec2((float)(canvas.x + canvas.w), (float)canvas.h),
+                                                    IM_COL32(100, 200, 255, 255), 0.0f, 0, 2.0f);
+
+        // Polyline đang import: vẽ phần đã tải
+        profiler.beginStage(STAGE_SHAPES);
+        if (app.importing)
+            drawShape(app.importShape, geom);
+        profiler.endStage(STAGE_SHAPES);
+
+        profiler.beginStage(STAGE_HIGHLIGHT);
+        // --- HIGHLIGHT HOVERED SHAPE (Mouse Over) ---
+        // Chỉ highlight nếu hình đó CHƯA được chọn (tránh bị trùng màu)
+        if (app.hoveredShapeIndex != -1 && !isSelected(app, app.hoveredShapeIndex) && app.hoveredShapeIndex < (int)app.shapes.size())
         {
-            Shape s = app.shapes[app.selectedShapeIndex];
-            s.color = {1.0f, 0.4f, 0.0f}; // Màu cam đậm
-            if (s.kind == SH_POINT)
-                s.pointSize *= 1.5f; // Point to hơn
-
-            // Vẽ đè lên
-            drawShape(s, geom);
+            const Shape &s = app.shapes[app.hoveredShapeIndex];
+            drawShape(s, geom, {1.0f, 1.0f, 0.6f}, s.pointSize); // Màu vàng nhạt (Preview)
         }
 
-        // --- 2. HIGHLIGHT HOVERED SHAPE (Mouse Over) ---
-        // Chỉ highlight nếu hình đó CHƯA được chọn (tránh bị trùng màu)
-        if (app.hoveredShapeIndex != -1 && app.hoveredShapeIndex != app.selectedShapeIndex && app.hoveredShapeIndex < (int)app.shapes.size())
+        // Khung chọn / lasso đang kéo và các hình sẽ được chọn
+        if (app.bandActive)
         {
-            Shape s = app.shapes[app.hoveredShapeIndex];
-            s.color = {1.0f, 1.0f, 0.6f}; // Màu vàng nhạt (Preview)
-            drawShape(s, geom);
+            for (int i : app.bandHits)
+            {
+                const Shape &s = app.shapes[i];
+                drawShape(s, geom, {1.0f, 1.0f, 0.6f}, s.pointSize);
+            }
+            Color bandCol{0.4f, 0.8f, 1.0f};
+            if (app.bandLasso)
+            {
+                geom.drawPolyline(app.lassoPts, bandCol);
+                geom.drawLine(app.lassoPts.back(), app.lassoPts.front(), bandCol);
+            }
+            else
+            {
+                Vec2 rect[5] = {app.bandStart, {app.bandEnd.x, app.bandStart.y}, app.bandEnd, {app.bandStart.x, app.bandEnd.y}, app.bandStart};
+                geom.drawPolyline(rect, 5, bandCol);
+            }
         }
 
-        // --- 3. HIGHLIGHT SNAP POINT (Khi vẽ) ---
+        // --- HIGHLIGHT SNAP POINT (Khi vẽ) ---
         // Dấu chấm đỏ để biết chuột đang bắt dính vào đâu
         if (app.isHoveringAny)
         {
-            float pxSize = 10.0f;
-            float worldSize = pxSize * (r - l) / (float)display_w;
+            double pxSize = 10.0;
+            float worldSize = (float)(pxSize * (r - l) / (double)canvas.w);
             geom.drawCircle(app.hoverPos, worldSize, {1.0f, 0.2f, 0.2f}, 24);
             geom.drawPoint(app.hoverPos, {1.0f, 1.0f, 0.0f}, 5.0f);
         }
+        profiler.endStage(STAGE_HIGHLIGHT);
+        glDisable(GL_SCISSOR_TEST);
+        lastHeapStats.renderAllocs = heapAllocCount() - renderAllocStart;
 
-        // --- VẼ NHÃN & TRỤC ---
-        float labelOffset = (t - b) * 0.02f;
-        float startX = std::floor(l / spacing) * spacing;
-        float endX = std::ceil(r / spacing) * spacing;
+        // --- UI ---
+        profiler.beginStage(STAGE_IMGUI_BUILD);
+        ImGui::SetNextWindowPos(ImVec2((float)display_w - MENU_WIDTH, 0));
+        ImGui::SetNextWindowSize(ImVec2(MENU_WIDTH, (float)display_h));
 
-        if (app.showGrid)
-        {
-            // Số trên trục X
-            for (float x = startX; x <= endX + 1e-6f; x += spacing)
-            {
-                float worldLabelY = (b <= 0.0f && t >= 0.0f) ? (-labelOffset) : (b + labelOffset);
-                drawLabel(fmtTick(x), x, worldLabelY, l, r, b, t, display_w, display_h, labelCol);
-            }
+        ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
 
-            // Số trên trục Y
-            float startY = std::floor(b / spacing) * spacing;
-            float endY = std::ceil(t / spacing) * spacing;
-            for (float y = startY; y <= endY + 1e-6f; y += spacing)
+        // Các bản vẽ đang mở. Bản vẽ hoạt động có thể đổi ngoài tab bar (click vào cột khi chia màn hình):
+        // khi đó chọn lại tab của nó
+        static int tabDoc = -1;
+        int closeDoc = -1;
+        if (ImGui::BeginTabBar("Documents", ImGuiTabBarFlags_FittingPolicyScroll))
+        {
+            for (int d = 0; d < (int)app.docs.size(); ++d)
             {
-                if (std::abs(y) < 1e-5f)
-                    continue;
-                float worldLabelX = (l <= 0.0f && r >= 0.0f) ? (labelOffset) : (l + labelOffset);
-                drawLabel(fmtTick(y), worldLabelX, y, l, r, b, t, display_w, display_h, labelCol);
+                char label[160];
+                snprintf(label, sizeof(label), "%s###doc%d", app.docs[d].title.c_str(), app.docs[d].id);
+                bool open = true;
+                ImGuiTabItemFlags flags = (d == app.activeDoc && tabDoc != app.activeDoc) ? ImGuiTabItemFlags_SetSelected : 0;
+                if (ImGui::BeginTabItem(label, app.docs.size() > 1 ? &open : nullptr, flags))
+                {
+                    tabDoc = d;
+                    if (d != app.activeDoc)
+                        switchDocument(app, d); // Bị khóa khi đang đọc/ghi: frame sau tab cũ được chọn lại
+                    ImGui::EndTabItem();
+                }
+                if (!open)
+                    closeDoc = d;
             }
+            ImGui::EndTabBar();
         }
-
-        float menuWidth = 320.0f;
-        // 3. Vẽ tên trục x, y (Chỉ khi showAxis = true)
-        if (app.showAxis)
-        {
-
-            float visibleRight = l + (r - l) * ((float)(display_w - menuWidth) / display_w);
-            drawLabel("x", visibleRight - 0.2f * spacing, 0.2f * spacing, l, r, b, t, display_w, display_h, labelCol);
-            drawLabel("y", -0.2f * spacing, t - 0.05f * spacing, l, r, b, t, display_w, display_h, labelCol);
-        }
-
-        // --- UI ---
-        ImGui::SetNextWindowPos(ImVec2((float)display_w - menuWidth, 0));
-        ImGui::SetNextWindowSize(ImVec2(menuWidth, (float)display_h));
-
-        ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
+        if (closeDoc >= 0)
+            closeDocument(app, closeDoc);
+        ImGui::BeginDisabled(documentsLocked(app));
+        if (ImGui::Button("New Tab"))
+            newDocument(app, false);
+        ImGui::SameLine();
+        if (ImGui::Button("Duplicate"))
+            newDocument(app, true);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::Checkbox("Split View", &app.splitView);
+        ImGui::Separator();
 
         ImGui::Text("Mode:");
         if (ImGui::RadioButton("Navigate", app.mode == MODE_NAV))
@@ -1043,11 +3419,33 @@ int main()
         ImGui::SameLine();
         if (ImGui::RadioButton("Draw", app.mode == MODE_POINT))
             app.mode = MODE_POINT;
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Select", app.mode == MODE_SELECT))
+            app.mode = MODE_SELECT;
+        if (app.mode == MODE_SELECT)
+            ImGui::TextDisabled("Drag: box, Alt+drag: lasso\nShift: add, Ctrl: toggle, Ctrl+A: all\nDrag a selected shape to move");
 
         ImGui::Separator();
         ImGui::Text("View Options:");
         ImGui::Checkbox("Show Grid (Lines & Coords)", &app.showGrid);
         ImGui::Checkbox("Show Axis (Lines & Labels)", &app.showAxis);
+        ImGui::Checkbox("Show Profiler", &app.showProfiler);
+        ImGui::SameLine();
+        ImGui::Checkbox("Show Stats", &app.showStats);
+        ImGui::Checkbox("Render on Demand", &app.renderOnDemand);
+        ImGui::BeginDisabled(!geom.analyticConicsAvailable());
+        if (ImGui::Checkbox("Analytic Conics (GPU)", &app.analyticConics))
+            geom.setAnalyticConics(app.analyticConics);
+        ImGui::EndDisabled();
+        const char *pacingNames[] = {"VSync", "Late Latch", "Uncapped"};
+        int pacing = (int)app.pacing;
+        if (ImGui::Combo("Pacing", &pacing, pacingNames, IM_ARRAYSIZE(pacingNames)))
+        {
+            app.pacing = (PacingMode)pacing;
+            g_pacer.reset();
+        }
+        if (ImGui::Checkbox("Measure Latency", &app.measureLatency))
+            g_pacer.reset();
 
         ImGui::Separator();
         ImGui::ColorEdit3("Color", &app.drawColor.r);
@@ -1057,11 +3455,11 @@ int main()
             // 1. Cập nhật màu vẽ cho các hình vẽ sau này (như cũ)
             app.paintColor = app.drawColor;
 
-            // 2. [MỚI] Nếu đang chọn 1 hình, đổi màu hình đó ngay lập tức
-            if (app.selectedShapeIndex != -1 && app.selectedShapeIndex < (int)app.shapes.size())
+            // 2. [MỚI] Nếu đang chọn hình, đổi màu cả vùng chọn ngay lập tức
+            if (!app.selection.empty())
             {
                 pushUndo(app); // Quan trọng: Lưu Undo để có thể quay lại màu cũ
-                app.shapes[app.selectedShapeIndex].color = app.drawColor;
+                recolorShapes(app, app.selection, app.drawColor);
             }
         }
 
@@ -1081,17 +3479,17 @@ int main()
                 {
                 case SH_POINT:
                     ImGui::Text("Type: Point");
-                    ImGui::BulletText("Position: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("Position: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
                     break;
 
                 case SH_LINE:
                     ImGui::Text("Type: Line");
-                    ImGui::BulletText("P1: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
-                    ImGui::BulletText("P2: (%.2f, %.2f)", selShape.p2.x, selShape.p2.y);
+                    ImGui::BulletText("P1: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("P2: (%.15g, %.15g)", selShape.p2.x, selShape.p2.y);
                     {
-                        float dx = selShape.p2.x - selShape.p1.x;
-                        float dy = selShape.p2.y - selShape.p1.y;
-                        if (std::abs(dx) < 1e-6f)
+                        double dx = selShape.p2.x - selShape.p1.x;
+                        double dy = selShape.p2.y - selShape.p1.y;
+                        if (dx == 0.0)
                             ImGui::BulletText("Slope: Vertical (Infinite)");
                         else
                             ImGui::BulletText("Slope: %.4f", dy / dx);
@@ -1100,27 +3498,27 @@ int main()
 
                 case SH_CIRCLE:
                     ImGui::Text("Type: Circle");
-                    ImGui::BulletText("Center: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("Center: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
                     ImGui::BulletText("Radius: %.2f", selShape.radius);
                     break;
 
                 case SH_ELLIPSE:
                     ImGui::Text("Type: Ellipse");
-                    ImGui::BulletText("Center: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("Center: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
                     ImGui::BulletText("Semi-axis a: %.2f", selShape.a);
                     ImGui::BulletText("Semi-axis b: %.2f", selShape.b);
                     break;
 
                 case SH_PARABOLA:
                     ImGui::Text("Type: Parabola");
-                    ImGui::BulletText("Vertex: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("Vertex: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
                     ImGui::BulletText("Param a: %.2f", selShape.paramA);
                     ImGui::BulletText("Orientation: %s", selShape.isVertical ? "Vertical (x^2=4ay)" : "Horizontal (y^2=4ax)");
                     break;
 
                 case SH_HYPERBOLA:
                     ImGui::Text("Type: Hyperbola");
-                    ImGui::BulletText("Center: (%.2f, %.2f)", selShape.p1.x, selShape.p1.y);
+                    ImGui::BulletText("Center: (%.15g, %.15g)", selShape.p1.x, selShape.p1.y);
                     ImGui::BulletText("a: %.2f", selShape.hyper_a);
                     ImGui::BulletText("b: %.2f", selShape.hyper_b);
                     ImGui::BulletText("Orientation: %s", selShape.isVertical ? "Vertical" : "Horizontal");
@@ -1139,7 +3537,15 @@ int main()
                 if (selShape.kind == SH_POINT)
                 {
                     ImGui::InputText("Name", &selShape.name); // Cần include imgui_stdlib.h
-                    ImGui::Checkbox("Show Name", &selShape.showName);
+                    if (ImGui::IsItemActivated())
+                        app.renameFrom = selShape.name;
+                    if (ImGui::IsItemDeactivatedAfterEdit())
+                    {
+                        app.names.rename(app.renameFrom, selShape.name, app.shapes.handleAt(app.selectedShapeIndex));
+                        journalShapeUpdated(app, app.selectedShapeIndex);
+                    }
+                    if (ImGui::Checkbox("Show Name", &selShape.showName))
+                        journalShapeUpdated(app, app.selectedShapeIndex);
                 }
 
                 ImGui::Separator();
@@ -1152,25 +3558,63 @@ int main()
                 if (ImGui::Button("Delete Shape", ImVec2(-1.0f, 0.0f)))
                 {                  // -1.0f là full chiều rộng
                     pushUndo(app); // Lưu trạng thái trước khi xóa
-
-                    // Xóa phần tử khỏi vector
-                    app.shapes.erase(app.shapes.begin() + app.selectedShapeIndex);
-
-                    // Reset các index vì vector đã thay đổi kích thước
-                    app.selectedShapeIndex = -1;
-                    app.hoveredShapeIndex = -1;
-                    draggingPointIdx = -1; // Đề phòng đang kéo hình đó thì xóa
+                    deleteShapes(app, app.selection);
                 }
                 ImGui::PopStyleColor(3);
                 // ------------------------------------
             }
             if (ImGui::Button("Deselect"))
-                app.selectedShapeIndex = -1;
+                clearSelection(app);
+        }
+        else if (!app.selection.empty())
+        {
+            ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "%d shapes selected", (int)app.selection.size());
+            ImGui::PushStyleColor(ImGuiCol_Button, (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.6f));
+            ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(0.0f, 0.7f, 0.7f));
+            ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(0.0f, 0.8f, 0.8f));
+            if (ImGui::Button("Delete Selected", ImVec2(-1.0f, 0.0f)))
+            {
+                pushUndo(app);
+                deleteShapes(app, app.selection);
+            }
+            ImGui::PopStyleColor(3);
+            if (ImGui::Button("Deselect"))
+                clearSelection(app);
         }
         else
         {
             ImGui::TextDisabled("No shape selected");
         }
+        ImGui::InputText("##find", &app.findName);
+        ImGui::SameLine();
+        if (ImGui::Button("Find by Name"))
+        {
+            int found = findShapeByName(app, app.findName);
+            if (found >= 0)
+                selectSingle(app, found);
+        }
+
+        // Biến đổi cả vùng chọn (1 lần Undo, 1 bản ghi nhật ký)
+        if (!app.selection.empty())
+        {
+            ImGui::Separator();
+            ImGui::Text("Transform Selection:");
+            ImGui::InputDouble("Move X", &app.ui_moveDx);
+            ImGui::InputDouble("Move Y", &app.ui_moveDy);
+            ImGui::InputFloat("Rotate (deg)", &app.ui_selRotate);
+            ImGui::InputFloat("Scale", &app.ui_selScale);
+            if (ImGui::Button("Apply Transform") && app.ui_selScale > 0.0f)
+            {
+                SceneIndex::Box bx = selectionBounds(app);
+                ShapeTransform tf;
+                tf.pivot = {0.5 * (bx.minX + bx.maxX), 0.5 * (bx.minY + bx.maxY)};
+                tf.angleDeg = app.ui_selRotate;
+                tf.scale = app.ui_selScale;
+                tf.offset = {app.ui_moveDx, app.ui_moveDy};
+                pushUndo(app);
+                transformShapes(app, app.selection, tf);
+            }
+        }
         ImGui::Separator();
 
         if (app.mode == MODE_POINT)
@@ -1205,8 +3649,8 @@ int main()
                 }
                 else if (app.pointMode == PT_INPUT)
                 {
-                    ImGui::InputFloat("X", &app.inputX, 0.5f, 1.0f, "%.2f");
-                    ImGui::InputFloat("Y", &app.inputY, 0.5f, 1.0f, "%.2f");
+                    ImGui::InputDouble("X", &app.inputX, 0.5, 1.0, "%.15g");
+                    ImGui::InputDouble("Y", &app.inputY, 0.5, 1.0, "%.15g");
                     if (ImGui::Button("Add Point", ImVec2(-1, 0)))
                     {
                         pushUndo(app);
@@ -1215,8 +3659,8 @@ int main()
                         s.p1 = {app.inputX, app.inputY};
                         s.pointSize = app.pointSize;
                         s.color = app.paintColor;
-                        s.name = getNextPointName(app.shapes);
-                        app.shapes.push_back(s);
+                        s.name = app.names.nextFreeName();
+                        addShape(app, s);
                     }
                 }
                 else
@@ -1314,7 +3758,7 @@ int main()
 
                 if (app.circleMode == CIR_CENTER_RAD)
                 {
-                    ImGui::InputFloat("Radius", &app.ui_circle_radius, 0.1f, 1.0f, "%.2f");
+                    ImGui::InputDouble("Radius", &app.ui_circle_radius, 0.1, 1.0, "%.2f");
                     if (app.circlePointStep >= 1)
                     {
                         if (ImGui::Button("Draw Circle", ImVec2(-1, 0)))
@@ -1326,7 +3770,7 @@ int main()
                             s.radius = app.ui_circle_radius;
                             s.color = app.paintColor;
                             s.segments = 200;
-                            app.shapes.push_back(s);
+                            addShape(app, s);
                             app.circlePointStep = 0;
                         }
                     }
@@ -1353,8 +3797,8 @@ int main()
                 if (app.ellipseCenterSet)
                 {
                     // Nhập hệ số a và b
-                    ImGui::InputFloat("rx", &app.ellipse_a, 0.1f, 0.5f, "%.2f");
-                    ImGui::InputFloat("ry", &app.ellipse_b, 0.1f, 0.5f, "%.2f");
+                    ImGui::InputDouble("rx", &app.ellipse_a, 0.1, 0.5, "%.2f");
+                    ImGui::InputDouble("ry", &app.ellipse_b, 0.1, 0.5, "%.2f");
 
                     // Nút Vẽ
                     if (ImGui::Button("Draw Ellipse", ImVec2(-1.0f, 0.0f)))
@@ -1365,11 +3809,11 @@ int main()
                         s.p1 = app.tempP1; // Tâm đã chọn từ click
                         s.a = app.ellipse_a;
                         s.b = app.ellipse_b;
-                        s.angle = 0.0f; // Bạn có thể thêm input cho góc nếu muốn
+                        s.angle = 0.0; // Bạn có thể thêm input cho góc nếu muốn
                         s.color = app.paintColor;
                         s.segments = app.ellipseSegments;
 
-                        app.shapes.push_back(s);
+                        addShape(app, s);
                         app.ellipseCenterSet = false; // Reset sau khi vẽ xong
                     }
                 }
@@ -1382,7 +3826,7 @@ int main()
                 if (app.parabolaVertexSet)
                 {
                     // Nhập hệ số a
-                    ImGui::InputFloat("a", &app.ui_parabola_a, 0.1f, 0.5f, "%.2f");
+                    ImGui::InputDouble("a", &app.ui_parabola_a, 0.1, 0.5, "%.2f");
 
                     // Chọn hướng
                     ImGui::Checkbox("Vertical?", &app.ui_parabola_vertical);
@@ -1397,7 +3841,7 @@ int main()
                         s.isVertical = (bool)app.ui_parabola_vertical;
                         s.color = app.paintColor;
 
-                        app.shapes.push_back(s);
+                        addShape(app, s);
                         app.parabolaVertexSet = false; // Reset
                     }
                 }
@@ -1409,8 +3853,8 @@ int main()
 
                 if (app.hyperbolaCenterSet)
                 {
-                    ImGui::InputFloat("a", &app.ui_hyper_a, 0.1f, 0.5f, "%.2f");
-                    ImGui::InputFloat("b", &app.ui_hyper_b, 0.1f, 0.5f, "%.2f");
+                    ImGui::InputDouble("a", &app.ui_hyper_a, 0.1, 0.5, "%.2f");
+                    ImGui::InputDouble("b", &app.ui_hyper_b, 0.1, 0.5, "%.2f");
                     ImGui::Checkbox("Vertical?", &app.ui_hyper_vertical);
 
                     if (ImGui::Button("Draw Hyperbola", ImVec2(-1.0f, 0.0f)))
@@ -1424,7 +3868,7 @@ int main()
                         s.isVertical = app.ui_hyper_vertical;
                         s.color = app.paintColor;
 
-                        app.shapes.push_back(s);
+                        addShape(app, s);
                         app.hyperbolaCenterSet = false; // Reset
                     }
                 }
@@ -1440,7 +3884,7 @@ int main()
                         s.kind = SH_POLYLINE;
                         s.poly = app.tempPoly;
                         s.color = app.paintColor;
-                        app.shapes.push_back(s);
+                        addShape(app, s);
                     }
                     app.polylineActive = false;
                     app.tempPoly.clear();
@@ -1461,13 +3905,94 @@ int main()
         }
 
         ImGui::Separator();
-        static char filePathBuf[260] = "drawing.txt";
-        ImGui::InputText("File", filePathBuf, sizeof(filePathBuf));
+        Document &activeDoc = app.docs[app.activeDoc];
+        ImGui::InputText("File", &activeDoc.filePath);
+        ImGui::BeginDisabled(app.ioTask.busy());
         if (ImGui::Button("Save"))
-            saveDrawing(app, filePathBuf);
+            startSaveAsync(app, activeDoc.filePath.c_str());
         ImGui::SameLine();
         if (ImGui::Button("Load"))
-            loadDrawing(app, filePathBuf);
+            startLoadAsync(app, activeDoc.filePath.c_str());
+        // Xuất vùng đang nhìn: 1 đơn vị trang = 1 pixel của canvas
+        if (ImGui::Button("Export SVG"))
+            startVectorExportAsync(app, activeDoc.filePath.c_str(), VEC_SVG, canvas.w);
+        ImGui::SameLine();
+        if (ImGui::Button("Export PDF"))
+            startVectorExportAsync(app, activeDoc.filePath.c_str(), VEC_PDF, canvas.w);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(app.importing);
+        if (ImGui::Button("Import Polyline"))
+        {
+            // File chuỗi điểm "x y" (không phải file bản vẽ)
+            app.importShape = Shape();
+            app.importShape.kind = SH_POLYLINE;
+            app.importShape.color = app.paintColor;
+            app.importing = app.importer.start(resolveSavePath(activeDoc.filePath.c_str()).string());
+            app.importError = app.importing ? "" : app.importer.error();
+        }
+        ImGui::EndDisabled();
+        if (app.importing)
+        {
+            ImGui::ProgressBar(app.importer.progress(), ImVec2(-1.0f, 0.0f));
+            ImGui::Text("Points: %zu", app.importShape.poly.size());
+            if (ImGui::Button("Cancel Import"))
+                app.importer.stop(); // Phần đã tải vẫn được giữ lại ở frame sau
+        }
+        if (!app.importError.empty())
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", app.importError.c_str());
+        if (app.ioTask.busy())
+        {
+            ImGui::ProgressBar(app.ioTask.progress(), ImVec2(-1.0f, 0.0f));
+            if (ImGui::Button("Cancel I/O"))
+                app.ioTask.cancel();
+        }
+        if (!app.ioStatus.empty())
+            ImGui::TextWrapped("%s", app.ioStatus.c_str());
+
+        // Xuất ảnh PNG độ phân giải lớn (cùng tên file, đuôi .png)
+        ImGui::Separator();
+        ImGui::InputInt("Width (px)", &app.ui_exportW, 1024);
+        ImGui::InputInt("Height (px)", &app.ui_exportH, 1024);
+        app.ui_exportW = std::max(1, std::min(app.ui_exportW, TiledImageExport::MAX_SIZE));
+        app.ui_exportH = std::max(1, std::min(app.ui_exportH, TiledImageExport::MAX_SIZE));
+        if (app.imageExport.out.active())
+        {
+            ImGui::ProgressBar(app.imageExport.out.progress(), ImVec2(-1.0f, 0.0f));
+            if (ImGui::Button("Cancel Export"))
+            {
+                app.imageExport.out.cancel();
+                endImageExport(app, false);
+                app.exportStatus = "Export cancelled";
+            }
+        }
+        else if (ImGui::Button("Export PNG"))
+        {
+            fs::path png = resolveSavePath(activeDoc.filePath.c_str()).replace_extension(".png");
+            startImageExport(app, png.string(), app.ui_exportW, app.ui_exportH);
+        }
+        if (!app.exportStatus.empty())
+            ImGui::TextWrapped("%s", app.exportStatus.c_str());
+
+        ImGui::Separator();
+        if (ImGui::Button("Compute All Intersections", ImVec2(-1, 0)))
+            computeAllIntersections(app);
+        ImGui::TextDisabled("Point set: selected polyline, else all points");
+        ImGui::BeginDisabled(app.ioTask.busy());
+        if (ImGui::Button("Convex Hull"))
+            startPointSetAsync(app, PS_HULL);
+        ImGui::SameLine();
+        if (ImGui::Button("Closest Pair"))
+            startPointSetAsync(app, PS_CLOSEST_PAIR);
+        ImGui::SameLine();
+        if (ImGui::Button("Delaunay"))
+            startPointSetAsync(app, PS_DELAUNAY);
+        ImGui::SameLine();
+        if (ImGui::Button("Voronoi"))
+            startPointSetAsync(app, PS_VORONOI);
+        ImGui::EndDisabled();
+        if (!app.computeStatus.empty())
+            ImGui::TextWrapped("%s", app.computeStatus.c_str());
 
         ImGui::Separator();
         ImGui::BeginDisabled(app.undoStack.empty());
@@ -1482,12 +4007,40 @@ int main()
 
         ImGui::End();
 
+        if (app.showProfiler)
+            profiler.drawPanel(&app.showProfiler);
+        if (app.showStats)
+            drawStatsPanel(lastRenderStats, lastQueryStats, lastHeapStats, g_pacer.stats(), &app.showStats);
+
         ImGui::Render();
+        profiler.endStage(STAGE_IMGUI_BUILD);
+
+        profiler.beginStage(STAGE_IMGUI_RENDER);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler.endStage(STAGE_IMGUI_RENDER);
 
+        profiler.beginStage(STAGE_SWAP);
+        g_pacer.beforeSwap();
         glfwSwapBuffers(window);
+        // Đo độ trễ: chờ GPU xong frame này để mốc thời gian gần với lúc hình thật sự sẵn sàng hiển thị
+        if (app.measureLatency)
+            glFinish();
+        g_pacer.afterSwap(app.measureLatency);
+        profiler.endStage(STAGE_SWAP);
+
+        profiler.endFrame();
     }
 
+    // Thoát bình thường: không cần khôi phục ở lần chạy sau
+    for (Document &doc : app.docs)
+        if (doc.journal)
+            doc.journal->close(true);
+    app.autosaveDir.release();
+    // Ảnh đang xuất dở bị bỏ (cần context GL còn sống để xóa FBO; draw list chữ gắn với context ImGui)
+    app.imageExport.out.cancel();
+    app.imageExport.labels.reset();
+
+    profiler.shutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -1501,10 +4054,34 @@ int main()
 void canvas_framebuffer_size_callback(GLFWwindow * /*window*/, int width, int height)
 {
     glViewport(0, 0, width, height);
+    requestRedraw();
+}
+
+// Các sự kiện chỉ cần đánh thức vòng lặp để vẽ lại (ImGui xử lý nội dung qua callback nối tiếp của nó)
+void canvas_char_callback(GLFWwindow * /*window*/, unsigned int /*codepoint*/)
+{
+    requestRedraw();
+}
+
+void canvas_refresh_callback(GLFWwindow * /*window*/)
+{
+    requestRedraw();
+}
+
+void canvas_focus_callback(GLFWwindow * /*window*/, int /*focused*/)
+{
+    requestRedraw();
+}
+
+void canvas_cursor_enter_callback(GLFWwindow * /*window*/, int /*entered*/)
+{
+    requestRedraw();
 }
 
 void canvas_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
+    g_pacer.onInput();
+    requestRedraw();
     if (ImGui::GetIO().WantCaptureKeyboard)
         return;
     AppState *g = static_cast<AppState *>(glfwGetWindowUserPointer(window));
@@ -1517,25 +4094,31 @@ void canvas_key_callback(GLFWwindow *window, int key, int scancode, int action,
 
     if (key == GLFW_KEY_DELETE && action == GLFW_PRESS)
     {
-        if (g->selectedShapeIndex != -1 && g->selectedShapeIndex < (int)g->shapes.size())
+        if (!g->selection.empty())
         {
             pushUndo(*g);
-            g->shapes.erase(g->shapes.begin() + g->selectedShapeIndex);
-            g->selectedShapeIndex = -1;
-            g->hoveredShapeIndex = -1;
-            draggingPointIdx = -1;
+            deleteShapes(*g, g->selection);
         }
     }
 
+    // Ctrl+A: chọn tất cả (chế độ Select)
+    if (key == GLFW_KEY_A && action == GLFW_PRESS && (mods & GLFW_MOD_CONTROL) && g->mode == MODE_SELECT)
+    {
+        g->selectedMask.assign(g->shapes.size(), 1);
+        selectionFromMask(*g);
+    }
+
     // Phím ESC để bỏ chọn
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     {
-        g->selectedShapeIndex = -1;
+        clearSelection(*g);
     }
 }
 
 void canvas_scroll_callback(GLFWwindow *window, double /*xoffset*/, double yoffset)
 {
+    g_pacer.onInput();
+    requestRedraw();
     if (ImGui::GetIO().WantCaptureMouse)
         return;
     AppState *g = static_cast<AppState *>(glfwGetWindowUserPointer(window));
@@ -1544,32 +4127,92 @@ void canvas_scroll_callback(GLFWwindow *window, double /*xoffset*/, double yoffs
 
     double mx, my;
     glfwGetCursorPos(window, &mx, &my);
-    float wx, wy;
+    // Chia màn hình: chỉ zoom khi chuột nằm trên canvas của bản vẽ hoạt động
+    if (!activeCanvas(window, *g).contains(mx))
+        return;
+    double wx, wy;
     screenToWorld(window, mx, my, wx, wy);
 
-    float l, r, b, t;
+    double l, r, b, t;
     g->geom->getView(l, r, b, t);
-    const float zoomSpeed = 1.15f;
-    float factor = (yoffset > 0.0) ? (1.0f / zoomSpeed) : zoomSpeed;
-    float newL = wx - (wx - l) * factor;
-    float newR = wx + (r - wx) * factor;
-    float newB = wy - (wy - b) * factor;
-    float newT = wy + (t - wy) * factor;
+    const double zoomSpeed = 1.15;
+    double factor = (yoffset > 0.0) ? (1.0 / zoomSpeed) : zoomSpeed;
+    // Giới hạn zoom: khung nhìn phải rộng hơn ~1024 ulp của tọa độ, nếu không pixel sẽ bị lượng tử hóa
+    const double minRel = 1024.0 * std::numeric_limits<double>::epsilon();
+    if (factor < 1.0 && ((r - l) * factor < minRel * std::max(std::abs(l), std::abs(r)) ||
+                         (t - b) * factor < minRel * std::max(std::abs(b), std::abs(t))))
+        return;
+    double newL = wx - (wx - l) * factor;
+    double newR = wx + (r - wx) * factor;
+    double newB = wy - (wy - b) * factor;
+    double newT = wy + (t - wy) * factor;
     g->geom->setView(newL, newR, newB, newT);
 }
 
-void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypos)
+// ---- Gom sự kiện di chuột ----
+// Chuột polling cao gửi tới ~1000 sự kiện/giây, nhiều hơn hẳn số frame. Callback chỉ ghi lại vị trí
+// mới nhất; hover/snap/kéo chạy tối đa 1 lần mỗi frame (flushCursorMove sau glfwPollEvents),
+// hoặc ngay trước khi xử lý click để click luôn thấy hover của đúng vị trí chuột.
+struct PendingCursor
+{
+    bool pending = false;
+    double x = 0.0, y = 0.0;
+};
+
+static PendingCursor g_pendingCursor;
+
+static void processCursorMove(GLFWwindow *window, double xpos, double ypos);
+
+void canvas_cursor_position_callback(GLFWwindow * /*window*/, double xpos, double ypos)
+{
+    g_pendingCursor.pending = true;
+    g_pendingCursor.x = xpos;
+    g_pendingCursor.y = ypos;
+    g_queryStats.cursorEvents++;
+    g_pacer.onInput();
+    requestRedraw();
+}
+
+static void flushCursorMove(GLFWwindow *window)
+{
+    if (!g_pendingCursor.pending)
+        return;
+    g_pendingCursor.pending = false;
+    g_queryStats.cursorUpdates++;
+    processCursorMove(window, g_pendingCursor.x, g_pendingCursor.y);
+}
+
+static void processCursorMove(GLFWwindow *window, double xpos, double ypos)
 {
     AppState *g = static_cast<AppState *>(glfwGetWindowUserPointer(window));
     if (!g || !g->geom)
         return;
 
+    // --- KHUNG CHỌN / KÉO VÙNG CHỌN (chế độ Select) ---
+    if (g->bandActive || g->movingSelection)
+    {
+        CanvasRect c = activeCanvas(window, *g);
+        double l, r, b, t;
+        g->geom->getView(l, r, b, t);
+        double wx, wy;
+        screenToWorld(window, xpos, ypos, wx, wy);
+        updateSelectGesture(*g, {wx, wy}, 3.0 * (r - l) / c.w);
+        return;
+    }
+
+    // Chuột ở canvas của bản vẽ khác (chia màn hình): không hover/snap trên bản vẽ hoạt động
+    if (!dragging && g->shapes.indexOf(draggingPoint) < 0 && !activeCanvas(window, *g).contains(xpos))
+    {
+        g->isHoveringAny = false;
+        g->hoveredShapeIndex = -1;
+        return;
+    }
+
     // --- LOGIC HOVER & SNAP (Khi không kéo chuột) ---
     if (!dragging)
     {
-        int w, h;
-        glfwGetFramebufferSize(window, &w, &h);
-        float l, r, b, t;
+        CanvasRect c = activeCanvas(window, *g);
+        double l, r, b, t;
         g->geom->getView(l, r, b, t);
 
         // 1. Kiểm tra Snap Point (cho Drawing)
@@ -1586,12 +4229,12 @@ void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypo
 
         // 2. Kiểm tra Hover Shape (cho Selection)
         // Chuyển chuột sang World
-        float wx = l + (float)(xpos / w) * (r - l);
-        float wy = b + (float)((h - ypos) / h) * (t - b);
+        double wx, wy;
+        screenToWorld(window, xpos, ypos, wx, wy);
         Vec2 mouseWorld = {wx, wy};
 
         // Tăng ngưỡng chọn lên 12 pixel cho dễ chọn
-        float pixelScale = (r - l) / w;
+        float pixelScale = (float)((r - l) / c.w);
         float threshold = 12.0f * pixelScale;
 
         // Biến lưu ứng viên là HÌNH KHÁC (Line, Circle...)
@@ -1645,19 +4288,16 @@ void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypo
     }
 
     // --- LOGIC KÉO ĐIỂM (DYNAMIC POINT) ---
-    if (draggingPointIdx != -1)
+    if (Shape *dragged = g->shapes.get(draggingPoint))
     {
         // Lấy tọa độ chuột hiện tại (đã convert sang World)
         double mx, my;
         glfwGetCursorPos(window, &mx, &my);
-        float wx, wy;
+        double wx, wy;
         screenToWorld(window, mx, my, wx, wy);
 
         // Cập nhật vị trí điểm
-        if (draggingPointIdx < (int)g->shapes.size())
-        {
-            g->shapes[draggingPointIdx].p1 = {wx, wy};
-        }
+        dragged->p1 = {wx, wy};
         return; // Đã kéo điểm thì không làm gì khác
     }
 
@@ -1665,15 +4305,14 @@ void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypo
     if (!dragging)
         return;
 
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    float l, r, b, t;
+    CanvasRect c = activeCanvas(window, *g);
+    double l, r, b, t;
     g->geom->getView(l, r, b, t);
 
     double dx = xpos - lastX;
     double dy = ypos - lastY;
-    float worldDX = (float)(-dx / (double)width * (r - l));
-    float worldDY = (float)(dy / (double)height * (t - b));
+    double worldDX = -dx / (double)c.w * (r - l);
+    double worldDY = dy / (double)c.h * (t - b);
     g->geom->setView(l + worldDX, r + worldDX, b + worldDY, t + worldDY);
 
     lastX = xpos;
@@ -1682,16 +4321,31 @@ void canvas_cursor_position_callback(GLFWwindow *window, double xpos, double ypo
 
 void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
+    g_pacer.onInput();
+    requestRedraw();
     // 1. Bỏ qua nếu chuột đang tương tác với menu ImGui
     if (ImGui::GetIO().WantCaptureMouse) return;
 
     AppState *g = static_cast<AppState *>(glfwGetWindowUserPointer(window));
     if (!g || !g->geom) return;
 
+    // Di chuột còn chờ trong frame này: xử lý trước để hover/snap khớp với vị trí click
+    flushCursorMove(window);
+
     // 2. Lấy tọa độ chuột
     double mx, my;
     glfwGetCursorPos(window, &mx, &my);
-    float wx, wy;
+
+    // Chia màn hình: click vào canvas của bản vẽ khác chỉ chuyển sang bản vẽ đó
+    if (action == GLFW_PRESS && !activeCanvas(window, *g).contains(mx))
+    {
+        int doc = documentAt(window, *g, mx);
+        if (doc >= 0)
+            switchDocument(*g, doc);
+        return;
+    }
+
+    double wx, wy;
     screenToWorld(window, mx, my, wx, wy);
     Vec2 effectivePos = {wx, wy};
 
@@ -1703,12 +4357,23 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
     {
         if (button == GLFW_MOUSE_BUTTON_LEFT)
         {
+            // Chế độ Select: khung chọn / lasso / kéo vùng chọn
+            if (g->mode == MODE_SELECT)
+            {
+                beginSelectGesture(*g, {wx, wy}, mods);
+                return;
+            }
+
             // Luôn cập nhật selection khi click trái
-            g->selectedShapeIndex = g->hoveredShapeIndex;
+            selectSingle(*g, g->hoveredShapeIndex);
 
             // TRƯỜNG HỢP A: CHẾ ĐỘ VẼ (DRAW MODE)
             if (g->mode == MODE_POINT)
             {
+                // Hình chọn ở bước trước; nếu nó đã bị xóa thì làm lại từ bước đầu
+                int saved1 = g->shapes.indexOf(g->savedShape1);
+                if (saved1 < 0)
+                    g->pointStep = 0;
                 switch (g->currentTool)
                 {
                 case TOOL_POINT:
@@ -1717,43 +4382,43 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
                         pushUndo(*g);
                         Shape s; s.kind = SH_POINT; s.p1 = effectivePos;
                         s.pointSize = g->pointSize; s.color = g->paintColor;
-                        s.name = getNextPointName(g->shapes);
-                        g->shapes.push_back(s);
+                        s.name = g->names.nextFreeName();
+                        addShape(*g, s);
                     }
                     else if (g->pointMode == PT_MIDPOINT || g->pointMode == PT_REFLECT_PT || g->pointMode == PT_ROTATE) {
                         if (g->hoveredShapeIndex != -1 && g->shapes[g->hoveredShapeIndex].kind == SH_POINT) {
                             if (g->pointStep == 0) {
-                                g->savedIdx1 = g->hoveredShapeIndex; g->pointStep = 1;
+                                g->savedShape1 = g->shapes.handleAt(g->hoveredShapeIndex); g->pointStep = 1;
                             } else {
                                 pushUndo(*g);
                                 Shape s; s.kind = SH_POINT; s.color = g->paintColor;
                                 if (g->pointMode == PT_MIDPOINT) {
-                                    s.p1 = getMidpoint(g->shapes[g->savedIdx1].p1, g->shapes[g->hoveredShapeIndex].p1);
-                                    s.name = "M_" + g->shapes[g->savedIdx1].name + g->shapes[g->hoveredShapeIndex].name;
+                                    s.p1 = getMidpoint(g->shapes[saved1].p1, g->shapes[g->hoveredShapeIndex].p1);
+                                    s.name = "M_" + g->shapes[saved1].name + g->shapes[g->hoveredShapeIndex].name;
                                 } else if (g->pointMode == PT_REFLECT_PT) {
-                                    s.p1 = reflectPointPoint(g->shapes[g->savedIdx1].p1, g->shapes[g->hoveredShapeIndex].p1);
-                                    s.name = g->shapes[g->savedIdx1].name + "'";
+                                    s.p1 = reflectPointPoint(g->shapes[saved1].p1, g->shapes[g->hoveredShapeIndex].p1);
+                                    s.name = g->shapes[saved1].name + "'";
                                 } else {
-                                    s.p1 = rotatePoint(g->shapes[g->savedIdx1].p1, g->shapes[g->hoveredShapeIndex].p1, g->ui_rotation_angle);
-                                    s.name = g->shapes[g->savedIdx1].name + "r";
+                                    s.p1 = rotatePoint(g->shapes[saved1].p1, g->shapes[g->hoveredShapeIndex].p1, g->ui_rotation_angle);
+                                    s.name = g->shapes[saved1].name + "r";
                                 }
-                                g->shapes.push_back(s); g->pointStep = 0;
+                                addShape(*g, s); g->pointStep = 0;
                             }
                         }
                     }
                     else if (g->pointMode == PT_REFLECT_LINE) {
                         if (g->pointStep == 0) {
                             if (g->hoveredShapeIndex != -1 && g->shapes[g->hoveredShapeIndex].kind == SH_POINT) {
-                                g->savedIdx1 = g->hoveredShapeIndex; g->pointStep = 1;
+                                g->savedShape1 = g->shapes.handleAt(g->hoveredShapeIndex); g->pointStep = 1;
                             }
                         } else {
                             if (g->hoveredShapeIndex != -1 && (g->shapes[g->hoveredShapeIndex].kind == SH_LINE || g->shapes[g->hoveredShapeIndex].kind == SH_INFINITE_LINE)) {
                                 pushUndo(*g);
                                 Shape &line = g->shapes[g->hoveredShapeIndex];
                                 Shape s; s.kind = SH_POINT; s.color = g->paintColor;
-                                s.p1 = reflectPointLine(g->shapes[g->savedIdx1].p1, line.p1, line.p2);
-                                s.name = g->shapes[g->savedIdx1].name + "_l";
-                                g->shapes.push_back(s); g->pointStep = 0;
+                                s.p1 = reflectPointLine(g->shapes[saved1].p1, line.p1, line.p2);
+                                s.name = g->shapes[saved1].name + "_l";
+                                addShape(*g, s); g->pointStep = 0;
                             }
                         }
                     }
@@ -1768,41 +4433,41 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
                             Vec2 dir = {base.p2.x - base.p1.x, base.p2.y - base.p1.y};
                             Vec2 perp = {-dir.y, dir.x};
                             Shape s; s.kind = SH_INFINITE_LINE; s.p1 = mid; s.p2 = {mid.x + perp.x, mid.y + perp.y};
-                            s.color = g->paintColor; g->shapes.push_back(s);
+                            s.color = g->paintColor; addShape(*g, s);
                         }
                     }
                     else if (g->lineMode == LN_PERP || g->lineMode == LN_PARALLEL) {
                         if (g->pointStep == 0) {
                             if (g->hoveredShapeIndex != -1 && g->shapes[g->hoveredShapeIndex].kind == SH_POINT) {
-                                g->savedIdx1 = g->hoveredShapeIndex; g->pointStep = 1;
+                                g->savedShape1 = g->shapes.handleAt(g->hoveredShapeIndex); g->pointStep = 1;
                             }
                         } else {
                             if (g->hoveredShapeIndex != -1 && (g->shapes[g->hoveredShapeIndex].kind == SH_LINE || g->shapes[g->hoveredShapeIndex].kind == SH_INFINITE_LINE)) {
                                 pushUndo(*g);
                                 Vec2 dir = {g->shapes[g->hoveredShapeIndex].p2.x - g->shapes[g->hoveredShapeIndex].p1.x, g->shapes[g->hoveredShapeIndex].p2.y - g->shapes[g->hoveredShapeIndex].p1.y};
                                 Vec2 fDir = (g->lineMode == LN_PERP) ? Vec2{-dir.y, dir.x} : dir;
-                                Shape s; s.kind = SH_INFINITE_LINE; s.p1 = g->shapes[g->savedIdx1].p1;
+                                Shape s; s.kind = SH_INFINITE_LINE; s.p1 = g->shapes[saved1].p1;
                                 s.p2 = {s.p1.x + fDir.x, s.p1.y + fDir.y};
-                                s.color = g->paintColor; g->shapes.push_back(s); g->pointStep = 0;
+                                s.color = g->paintColor; addShape(*g, s); g->pointStep = 0;
                             }
                         }
                     }
                     else if (g->lineMode == LN_BISECTOR || g->lineMode == LN_ANGLE) {
                         if (g->hoveredShapeIndex != -1 && (g->shapes[g->hoveredShapeIndex].kind == SH_LINE || g->shapes[g->hoveredShapeIndex].kind == SH_INFINITE_LINE || g->shapes[g->hoveredShapeIndex].kind == SH_RAY)) {
                             if (g->pointStep == 0) {
-                                g->savedIdx1 = g->hoveredShapeIndex; g->pointStep = 1;
+                                g->savedShape1 = g->shapes.handleAt(g->hoveredShapeIndex); g->pointStep = 1;
                             } else {
                                 if (g->lineMode == LN_ANGLE) {
-                                    g->calculatedAngle = getAngleBetweenLines(g->shapes[g->savedIdx1].p1, g->shapes[g->savedIdx1].p2, g->shapes[g->hoveredShapeIndex].p1, g->shapes[g->hoveredShapeIndex].p2);
+                                    g->calculatedAngle = getAngleBetweenLines(g->shapes[saved1].p1, g->shapes[saved1].p2, g->shapes[g->hoveredShapeIndex].p1, g->shapes[g->hoveredShapeIndex].p2);
                                 } else {
                                     Vec2 inter;
-                                    if (getLineIntersection(g->shapes[g->savedIdx1].p1, g->shapes[g->savedIdx1].p2, g->shapes[g->hoveredShapeIndex].p1, g->shapes[g->hoveredShapeIndex].p2, inter)) {
+                                    if (getLineIntersection(g->shapes[saved1].p1, g->shapes[saved1].p2, g->shapes[g->hoveredShapeIndex].p1, g->shapes[g->hoveredShapeIndex].p2, inter)) {
                                         pushUndo(*g);
-                                        Vec2 v1 = normalizeVec({g->shapes[g->savedIdx1].p2.x - g->shapes[g->savedIdx1].p1.x, g->shapes[g->savedIdx1].p2.y - g->shapes[g->savedIdx1].p1.y});
+                                        Vec2 v1 = normalizeVec({g->shapes[saved1].p2.x - g->shapes[saved1].p1.x, g->shapes[saved1].p2.y - g->shapes[saved1].p1.y});
                                         Vec2 v2 = normalizeVec({g->shapes[g->hoveredShapeIndex].p2.x - g->shapes[g->hoveredShapeIndex].p1.x, g->shapes[g->hoveredShapeIndex].p2.y - g->shapes[g->hoveredShapeIndex].p1.y});
                                         Vec2 bDir = {v1.x + v2.x, v1.y + v2.y};
                                         Shape s; s.kind = SH_INFINITE_LINE; s.p1 = inter; s.p2 = {inter.x + bDir.x, inter.y + bDir.y};
-                                        s.color = g->paintColor; g->shapes.push_back(s);
+                                        s.color = g->paintColor; addShape(*g, s);
                                     }
                                 }
                                 g->pointStep = 0;
@@ -1816,7 +4481,7 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
                             if (g->lineMode == LN_SEGMENT) s.kind = SH_LINE;
                             else if (g->lineMode == LN_INFINITE) s.kind = SH_INFINITE_LINE;
                             else if (g->lineMode == LN_RAY) s.kind = SH_RAY;
-                            g->shapes.push_back(s); g->awaitingSecond = false;
+                            addShape(*g, s); g->awaitingSecond = false;
                         }
                     }
                     break;
@@ -1826,12 +4491,12 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
                     if (g->circleMode == CIR_CENTER_PT && g->circlePointStep == 2) {
                         pushUndo(*g); Shape s; s.kind = SH_CIRCLE; s.p1 = g->circlePoints[0];
                         s.radius = dist(g->circlePoints[0], g->circlePoints[1]);
-                        s.color = g->paintColor; g->shapes.push_back(s); g->circlePointStep = 0;
+                        s.color = g->paintColor; addShape(*g, s); g->circlePointStep = 0;
                     } else if (g->circleMode == CIR_3PTS && g->circlePointStep == 3) {
-                        Vec2 c; float r;
+                        Vec2 c; double r;
                         if (calculateCircumcircle(g->circlePoints[0], g->circlePoints[1], g->circlePoints[2], c, r)) {
                             pushUndo(*g); Shape s; s.kind = SH_CIRCLE; s.p1 = c; s.radius = r;
-                            s.color = g->paintColor; g->shapes.push_back(s);
+                            s.color = g->paintColor; addShape(*g, s);
                         }
                         g->circlePointStep = 0;
                     }
@@ -1861,7 +4526,8 @@ void canvas_mouse_button_callback(GLFWwindow *window, int button, int action, in
     else if (action == GLFW_RELEASE) {
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
             dragging = false;
-            draggingPointIdx = -1;
+            draggingPoint = SlotHandle();
+            endSelectGesture(*g);
         }
     }
 }
\ No newline at end of file
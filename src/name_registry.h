@@ -0,0 +1,87 @@
+#ifndef NAME_REGISTRY_H
+#define NAME_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstddef>
+#include "slot_map.h"
+
+// Bảng tên hình: mỗi tên khác nhau lưu đúng 1 lần (khóa của bảng băm) kèm các hình đang mang tên đó,
+// cho phép tra hình theo tên O(1) và sinh tên tự động không trùng mà không phải duyệt lại mọi hình.
+// Dãy tên tự động: A..Z, A1..Z1, A2..Z2, ... (tên thứ k = chữ cái k % 26 + số k / 26), không bao giờ hết.
+// Bảng được cập nhật tăng dần khi thêm/xóa/đổi tên; khi cả bản vẽ bị thay (Undo, mở file) thì dựng lại.
+class NameRegistry {
+public:
+    void clear() {
+        owners.clear();
+        cursor = 0;
+    }
+
+    void add(const std::string &name, SlotHandle h) {
+        if (name.empty()) return;
+        owners[name].push_back(h);
+    }
+
+    void remove(const std::string &name, SlotHandle h) {
+        if (name.empty()) return;
+        auto it = owners.find(name);
+        if (it == owners.end()) return;
+        std::vector<SlotHandle> &v = it->second;
+        v.erase(std::remove(v.begin(), v.end(), h), v.end());
+        if (!v.empty()) return;
+        owners.erase(it);
+        // Tên tự động vừa được trả lại: lần sinh tên sau dùng lại nó (giữ tên ngắn nhất có thể)
+        long long k = generatedIndex(name);
+        if (k >= 0 && (unsigned long long)k < cursor) cursor = (size_t)k;
+    }
+
+    void rename(const std::string &from, const std::string &to, SlotHandle h) {
+        if (from == to) return;
+        remove(from, h);
+        add(to, h);
+    }
+
+    bool contains(const std::string &name) const { return owners.count(name) != 0; }
+
+    // Hình mang tên name (hình được đặt tên sớm nhất nếu có nhiều hình trùng tên)
+    SlotHandle find(const std::string &name) const {
+        auto it = owners.find(name);
+        return it == owners.end() ? SlotHandle() : it->second.front();
+    }
+
+    // Tên tự động đầu tiên chưa dùng. Mọi tên đứng trước cursor đều đã có chủ nên
+    // tổng chi phí sinh n tên liên tiếp là O(n), không phải O(n) mỗi lần
+    std::string nextFreeName() {
+        std::string name = generatedName(cursor);
+        while (contains(name)) name = generatedName(++cursor);
+        return name;
+    }
+
+    static std::string generatedName(size_t k) {
+        std::string name(1, char('A' + k % 26));
+        if (k >= 26) name += std::to_string(k / 26);
+        return name;
+    }
+
+    // Vị trí của name trong dãy tên tự động, -1 nếu không thuộc dãy
+    static long long generatedIndex(const std::string &name) {
+        if (name.empty() || name[0] < 'A' || name[0] > 'Z') return -1;
+        long long letter = name[0] - 'A';
+        if (name.size() == 1) return letter;
+        if (name[1] == '0' || name.size() > 10) return -1;
+        long long num = 0;
+        for (size_t i = 1; i < name.size(); ++i) {
+            if (name[i] < '0' || name[i] > '9') return -1;
+            num = num * 10 + (name[i] - '0');
+        }
+        return num * 26 + letter;
+    }
+
+private:
+    std::unordered_map<std::string, std::vector<SlotHandle>> owners;
+    size_t cursor = 0; // Mọi tên tự động có vị trí < cursor đều đang được dùng
+};
+
+#endif // NAME_REGISTRY_H
@@ -0,0 +1,245 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+// Ghi ảnh PNG RGB 8 bit lần lượt từng hàng (từ trên xuống), bộ nhớ chỉ O(chiều rộng): dùng cho ảnh
+// rất lớn (VD: 32k x 32k) không thể giữ nguyên trong RAM.
+// Nén deflate tự viết (không cần zlib): mỗi hàng dùng bộ lọc Sub (vùng cùng màu -> toàn byte 0) rồi
+// mã hóa Huffman cố định, chuỗi byte lặp lại thành cặp (độ dài, khoảng cách 1). Kém zlib với ảnh chụp
+// nhưng rất gọn với bản vẽ hình học (phần lớn là nền trơn).
+class PngStreamWriter {
+public:
+    ~PngStreamWriter() { abort(); }
+
+    bool open(const std::string &path, uint32_t width, uint32_t height) {
+        abort();
+        err.clear();
+        if (width == 0 || height == 0 || width > 0x7FFFFFFFu / 3 || height > 0x7FFFFFFFu) {
+            err = "Invalid image size";
+            return false;
+        }
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            err = "Cannot open " + path;
+            return false;
+        }
+        filePath = path;
+        w = width;
+        h = height;
+        rows = 0;
+        bitBuf = 0;
+        bitCount = 0;
+        adlerA = 1;
+        adlerB = 0;
+        filtered.assign(1 + (size_t)w * 3, 0);
+        idat.clear();
+
+        static const uint8_t SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+        out.write((const char *)SIGNATURE, 8);
+        std::vector<uint8_t> ihdr;
+        putU32(ihdr, w);
+        putU32(ihdr, h);
+        ihdr.push_back(8); // 8 bit mỗi kênh
+        ihdr.push_back(2); // RGB
+        ihdr.push_back(0); // deflate
+        ihdr.push_back(0); // bộ lọc chuẩn
+        ihdr.push_back(0); // không interlace
+        writeChunk("IHDR", ihdr);
+        // Header zlib: deflate, cửa sổ 32K, không từ điển ((0x78 * 256 + 0x01) % 31 == 0)
+        idat.push_back(0x78);
+        idat.push_back(0x01);
+        return checkStream();
+    }
+
+    bool isOpen() const { return out.is_open(); }
+    uint32_t rowsWritten() const { return rows; }
+    const std::string &error() const { return err; }
+
+    // rgb: 3 * width byte của hàng kế tiếp
+    bool writeRow(const uint8_t *rgb) {
+        if (!out.is_open() || rows >= h) return false;
+        size_t n = (size_t)w * 3;
+        filtered[0] = 1; // Bộ lọc Sub: byte trừ byte cùng kênh của pixel bên trái
+        for (size_t i = 0; i < n; ++i)
+            filtered[1 + i] = (uint8_t)(rgb[i] - (i >= 3 ? rgb[i - 3] : 0));
+        updateAdler(filtered.data(), filtered.size());
+
+        // Mỗi hàng 1 block Huffman cố định (BFINAL = 0, BTYPE = 01)
+        putBits(0, 1);
+        putBits(1, 2);
+        size_t total = filtered.size(), i = 0;
+        while (i < total) {
+            uint8_t v = filtered[i];
+            putLiteral(v);
+            size_t j = i + 1;
+            while (j < total && filtered[j] == v) ++j;
+            size_t k = j - i - 1; // Số byte lặp lại ngay sau literal
+            while (k >= 3) {
+                size_t m = std::min<size_t>(k, 258);
+                putMatch((int)m);
+                k -= m;
+            }
+            i = j - k; // 1-2 byte lặp còn lại ghi thành literal
+        }
+        putLiteral(256);
+        ++rows;
+        if (idat.size() >= CHUNK_BYTES) flushIdat();
+        return checkStream();
+    }
+
+    // Ghi phần kết; false nếu lỗi ghi hoặc chưa đủ số hàng (file dở bị xóa)
+    bool close() {
+        if (!out.is_open()) return false;
+        if (rows != h) {
+            err = "Image incomplete";
+            abort();
+            return false;
+        }
+        // Block cuối rỗng (BFINAL = 1), rồi căn byte và checksum Adler-32 của dữ liệu gốc
+        putBits(1, 1);
+        putBits(1, 2);
+        putLiteral(256);
+        if (bitCount > 0) idat.push_back((uint8_t)bitBuf);
+        bitBuf = 0;
+        bitCount = 0;
+        putU32(idat, (adlerB << 16) | adlerA);
+        flushIdat();
+        writeChunk("IEND", {});
+        bool ok = checkStream();
+        out.close();
+        if (!ok) std::filesystem::remove(filePath);
+        return ok;
+    }
+
+    // Bỏ dở: đóng và xóa file
+    void abort() {
+        if (!out.is_open()) return;
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(filePath, ec);
+    }
+
+private:
+    static const size_t CHUNK_BYTES = 1 << 16;
+
+    std::ofstream out;
+    std::string filePath;
+    std::string err;
+    uint32_t w = 0, h = 0, rows = 0;
+    std::vector<uint8_t> filtered; // [bộ lọc][3 * w byte] của hàng đang ghi
+    std::vector<uint8_t> idat;     // Dữ liệu nén chờ ghi thành chunk IDAT
+    uint32_t bitBuf = 0;
+    int bitCount = 0;
+    uint32_t adlerA = 1, adlerB = 0;
+
+    bool checkStream() {
+        if (out) return true;
+        if (err.empty()) err = "Write error";
+        return false;
+    }
+
+    static void putU32(std::vector<uint8_t> &v, uint32_t x) {
+        v.push_back((uint8_t)(x >> 24));
+        v.push_back((uint8_t)(x >> 16));
+        v.push_back((uint8_t)(x >> 8));
+        v.push_back((uint8_t)x);
+    }
+
+    static uint32_t crc32(uint32_t crc, const uint8_t *p, size_t n) {
+        static uint32_t table[256];
+        static bool init = false;
+        if (!init) {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            init = true;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void writeChunk(const char type[4], const std::vector<uint8_t> &data) {
+        std::vector<uint8_t> len;
+        putU32(len, (uint32_t)data.size());
+        out.write((const char *)len.data(), 4);
+        out.write(type, 4);
+        if (!data.empty()) out.write((const char *)data.data(), data.size());
+        uint32_t crc = crc32(0, (const uint8_t *)type, 4);
+        crc = crc32(crc, data.data(), data.size());
+        std::vector<uint8_t> c;
+        putU32(c, crc);
+        out.write((const char *)c.data(), 4);
+    }
+
+    void flushIdat() {
+        if (idat.empty()) return;
+        writeChunk("IDAT", idat);
+        idat.clear();
+    }
+
+    // Modulo trì hoãn: 5552 là số byte tối đa cộng dồn mà adlerB chưa tràn 32 bit
+    void updateAdler(const uint8_t *p, size_t n) {
+        while (n > 0) {
+            size_t m = std::min<size_t>(n, 5552);
+            for (size_t i = 0; i < m; ++i) {
+                adlerA += p[i];
+                adlerB += adlerA;
+            }
+            adlerA %= 65521;
+            adlerB %= 65521;
+            p += m;
+            n -= m;
+        }
+    }
+
+    // Bit deflate xếp từ bit thấp của mỗi byte
+    void putBits(uint32_t v, int n) {
+        bitBuf |= v << bitCount;
+        bitCount += n;
+        while (bitCount >= 8) {
+            idat.push_back((uint8_t)bitBuf);
+            bitBuf >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    // Mã Huffman ghi từ bit cao xuống
+    void putCode(uint32_t code, int len) {
+        uint32_t rev = 0;
+        for (int i = 0; i < len; ++i) rev |= ((code >> i) & 1) << (len - 1 - i);
+        putBits(rev, len);
+    }
+
+    // Bảng mã literal/độ dài Huffman cố định (RFC 1951, 3.2.6)
+    void putLiteral(int v) {
+        if (v < 144) putCode(0x30 + v, 8);
+        else if (v < 256) putCode(0x190 + (v - 144), 9);
+        else if (v < 280) putCode(v - 256, 7);
+        else putCode(0xC0 + (v - 280), 8);
+    }
+
+    // Lặp lại len (3..258) byte với khoảng cách 1
+    void putMatch(int len) {
+        static const int BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27,
+                                     31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        int c = 28;
+        while (BASE[c] > len) --c;
+        putLiteral(257 + c);
+        if (EXTRA[c]) putBits((uint32_t)(len - BASE[c]), EXTRA[c]);
+        putCode(0, 5); // Mã khoảng cách 0 = khoảng cách 1
+    }
+};
+
+#endif // PNG_WRITER_H
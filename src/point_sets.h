@@ -0,0 +1,469 @@
+#ifndef POINT_SETS_H
+#define POINT_SETS_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "geometry.h"
+#include "predicates.h"
+
+// Hình học tính toán trên tập điểm: bao lồi, cặp điểm gần nhất, tam giác hóa Delaunay, sơ đồ Voronoi.
+// Thiết kế cho ~1M điểm: chia để trị, vài tầng trên cùng chạy song song (threads = 1 là tuần tự).
+// Mọi phép so sánh hình học dùng vị từ bền vững (pred::orient2d, pred::incircle).
+namespace pset {
+
+struct IndexEdge {
+    int a, b;
+};
+
+inline int defaultThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 1;
+}
+
+// Số tầng đệ quy chạy song song để có khoảng threads nhánh
+inline int parallelDepth(int threads) {
+    int depth = 0;
+    while ((1 << depth) < threads) ++depth;
+    return depth;
+}
+
+inline bool lexLess(Vec2 p, Vec2 q) {
+    return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+// ---- Bao lồi (Andrew monotone chain) ----
+
+// sorted: chỉ số điểm đã sắp theo (x, y). Trả về đỉnh bao lồi ngược chiều kim đồng hồ, bỏ điểm thẳng hàng
+inline std::vector<int> monotoneChain(const std::vector<Vec2> &pts, const std::vector<int> &sorted) {
+    size_t n = sorted.size();
+    if (n <= 1) return sorted;
+    std::vector<int> h(2 * n);
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        while (k >= 2 && pred::orient2d(pts[h[k - 2]], pts[h[k - 1]], pts[sorted[i]]) <= 0) --k;
+        h[k++] = sorted[i];
+    }
+    for (size_t i = n - 1, t = k + 1; i > 0; --i) {
+        while (k >= t && pred::orient2d(pts[h[k - 2]], pts[h[k - 1]], pts[sorted[i - 1]]) <= 0) --k;
+        h[k++] = sorted[i - 1];
+    }
+    h.resize(k - 1);
+    return h;
+}
+
+// Mỗi luồng sắp xếp và dựng bao lồi cho một phần điểm; bao lồi cuối dựng từ các đỉnh bao lồi con
+inline std::vector<int> convexHull(const std::vector<Vec2> &pts, int threads = 1) {
+    auto byCoord = [&](int a, int b) { return lexLess(pts[a], pts[b]); };
+    size_t n = pts.size();
+    int parts = (int)std::max<size_t>(1, std::min<size_t>((size_t)std::max(threads, 1), n / 4096));
+    std::vector<std::vector<int>> partial(parts);
+    auto work = [&](int part) {
+        size_t lo = n * part / parts, hi = n * (part + 1) / parts;
+        std::vector<int> idx(hi - lo);
+        for (size_t i = lo; i < hi; ++i) idx[i - lo] = (int)i;
+        std::sort(idx.begin(), idx.end(), byCoord);
+        partial[part] = monotoneChain(pts, idx);
+    };
+    if (parts == 1) {
+        work(0);
+        return partial[0];
+    }
+    std::vector<std::future<void>> jobs;
+    for (int p = 1; p < parts; ++p) jobs.push_back(std::async(std::launch::async, work, p));
+    work(0);
+    for (auto &j : jobs) j.get();
+    std::vector<int> merged;
+    for (const auto &h : partial) merged.insert(merged.end(), h.begin(), h.end());
+    std::sort(merged.begin(), merged.end(), byCoord);
+    return monotoneChain(pts, merged);
+}
+
+// ---- Cặp điểm gần nhất (chia để trị, O(n log n)) ----
+
+struct ClosestPair {
+    int a = -1, b = -1;
+    double dist = INFINITY;
+};
+
+namespace detail {
+
+struct PointId {
+    double x, y;
+    int id;
+};
+
+struct PairD2 {
+    double d2;
+    int a, b;
+};
+
+// a sắp theo x khi vào, theo y khi ra (trộn như merge sort); buf là vùng nhớ tạm cùng cỡ
+inline PairD2 closestRec(PointId *a, size_t n, PointId *buf, int depth) {
+    PairD2 best = {INFINITY, -1, -1};
+    auto consider = [&](const PointId &p, const PointId &q) {
+        double dx = p.x - q.x, dy = p.y - q.y;
+        double d2 = dx * dx + dy * dy;
+        if (d2 < best.d2) best = {d2, p.id, q.id};
+    };
+    auto byY = [](const PointId &p, const PointId &q) { return p.y < q.y; };
+    if (n <= 3) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j) consider(a[i], a[j]);
+        std::sort(a, a + n, byY);
+        return best;
+    }
+    size_t mid = n / 2;
+    double midX = a[mid].x;
+    PairD2 left, right;
+    if (depth > 0) {
+        auto job = std::async(std::launch::async, closestRec, a, mid, buf, depth - 1);
+        right = closestRec(a + mid, n - mid, buf + mid, depth - 1);
+        left = job.get();
+    } else {
+        left = closestRec(a, mid, buf, 0);
+        right = closestRec(a + mid, n - mid, buf + mid, 0);
+    }
+    best = left.d2 <= right.d2 ? left : right;
+
+    std::merge(a, a + mid, a + mid, a + n, buf, byY);
+    std::copy(buf, buf + n, a);
+    // Dải quanh đường chia: mỗi điểm chỉ cần so với vài điểm kế tiếp theo y
+    double d = std::sqrt(best.d2);
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (std::abs(a[i].x - midX) < d) buf[m++] = a[i];
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = i + 1; j < m && buf[j].y - buf[i].y < d; ++j) {
+            consider(buf[i], buf[j]);
+            d = std::sqrt(best.d2);
+        }
+    }
+    return best;
+}
+
+} // namespace detail
+
+inline ClosestPair closestPair(const std::vector<Vec2> &pts, int threads = 1) {
+    ClosestPair res;
+    if (pts.size() < 2) return res;
+    std::vector<detail::PointId> a(pts.size()), buf(pts.size());
+    for (size_t i = 0; i < pts.size(); ++i) a[i] = {pts[i].x, pts[i].y, (int)i};
+    std::sort(a.begin(), a.end(), [](const detail::PointId &p, const detail::PointId &q) {
+        return p.x < q.x || (p.x == q.x && p.y < q.y);
+    });
+    detail::PairD2 best = detail::closestRec(a.data(), a.size(), buf.data(), parallelDepth(threads));
+    res.a = std::min(best.a, best.b);
+    res.b = std::max(best.a, best.b);
+    res.dist = std::sqrt(best.d2);
+    return res;
+}
+
+// ---- Delaunay (Guibas–Stolfi, quad-edge) và Voronoi ----
+
+struct VoronoiDiagram {
+    std::vector<Vec2> vertices;                // Tâm đường tròn ngoại tiếp các tam giác Delaunay
+    std::vector<IndexEdge> edges;              // Cạnh hữu hạn giữa hai đỉnh
+    std::vector<std::pair<int, Vec2>> rays;    // Cạnh vô hạn: (đỉnh gốc, vectơ hướng)
+    std::vector<std::pair<Vec2, Vec2>> lines;  // Mọi điểm thẳng hàng: trung trực qua 2 điểm
+};
+
+class DelaunayMesh {
+public:
+    DelaunayMesh() = default;
+    DelaunayMesh(const DelaunayMesh &) = delete;
+    DelaunayMesh &operator=(const DelaunayMesh &) = delete;
+
+    // Điểm trùng tọa độ chỉ giữ lại một (chỉ số nhỏ nhất)
+    void build(const std::vector<Vec2> &pts, int threads = 1) {
+        blocks.clear();
+        ids.resize(pts.size());
+        for (size_t i = 0; i < pts.size(); ++i) ids[i] = (int)i;
+        std::sort(ids.begin(), ids.end(), [&](int a, int b) {
+            return lexLess(pts[a], pts[b]) || (!lexLess(pts[b], pts[a]) && a < b);
+        });
+        ids.erase(std::unique(ids.begin(), ids.end(), [&](int a, int b) { return pts[a].x == pts[b].x && pts[a].y == pts[b].y; }),
+                  ids.end());
+        sorted.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) sorted[i] = pts[ids[i]];
+        if (sorted.size() < 2) return;
+        Allocator al{this};
+        recurse(0, (int)sorted.size(), al, parallelDepth(threads));
+    }
+
+    size_t pointCount() const { return sorted.size(); }
+
+    // Cạnh Delaunay theo chỉ số điểm đầu vào
+    std::vector<IndexEdge> edges() const {
+        std::vector<IndexEdge> out;
+        for (const auto &bl : blocks)
+            for (size_t i = 0; i < BLOCK; ++i)
+                if (bl[i].alive) out.push_back({ids[bl[i].e[0].org], ids[bl[i].e[2].org]});
+        return out;
+    }
+
+    // Sơ đồ Voronoi là đối ngẫu: mỗi tam giác -> một đỉnh, mỗi cạnh Delaunay -> một cạnh Voronoi
+    VoronoiDiagram voronoi() {
+        VoronoiDiagram v;
+        // Dùng org của cạnh đối ngẫu để lưu id mặt: UNSET chưa tính, OUTER là mặt ngoài bao lồi
+        for (auto &bl : blocks)
+            for (size_t i = 0; i < BLOCK; ++i) bl[i].e[1].org = bl[i].e[3].org = UNSET;
+        auto faceLeftOf = [&](QEdge *e) {
+            QEdge *d = invRot(e);
+            if (d->org != UNSET) return d->org;
+            QEdge *e2 = lnext(e), *e3 = lnext(e2);
+            if (lnext(e3) == e && pred::orient2d(sorted[e->org], sorted[e2->org], sorted[e3->org]) > 0) {
+                int id = (int)v.vertices.size();
+                v.vertices.push_back(circumcenter(e->org, e2->org, e3->org));
+                d->org = invRot(e2)->org = invRot(e3)->org = id;
+            } else {
+                d->org = OUTER;
+            }
+            return d->org;
+        };
+        for (auto &bl : blocks) {
+            for (size_t i = 0; i < BLOCK; ++i) {
+                if (!bl[i].alive) continue;
+                QEdge *e = &bl[i].e[0];
+                int left = faceLeftOf(e), right = faceLeftOf(sym(e));
+                Vec2 p = sorted[e->org], q = sorted[sym(e)->org];
+                Vec2 n = {-(q.y - p.y), q.x - p.x}; // Pháp tuyến bên trái của e
+                if (left >= 0 && right >= 0) {
+                    if (left != right) v.edges.push_back({left, right});
+                } else if (left >= 0) {
+                    v.rays.push_back({left, {-n.x, -n.y}}); // Mặt ngoài ở bên phải
+                } else if (right >= 0) {
+                    v.rays.push_back({right, n});
+                } else {
+                    Vec2 m = {0.5 * (p.x + q.x), 0.5 * (p.y + q.y)};
+                    v.lines.push_back({m, {m.x + n.x, m.y + n.y}});
+                }
+            }
+        }
+        return v;
+    }
+
+private:
+    struct QEdge {
+        QEdge *next; // Onext
+        int org;     // Cạnh gốc: chỉ số điểm (trong sorted); cạnh đối ngẫu: id mặt
+        int r;       // Vị trí trong bộ 4
+    };
+    struct Quad {
+        QEdge e[4];
+        bool alive;
+    };
+    static const size_t BLOCK = 1 << 16;
+    static const int UNSET = -1, OUTER = -2;
+
+    std::vector<Vec2> sorted; // Điểm đã sắp (x, y), không trùng
+    std::vector<int> ids;     // sorted[i] là điểm đầu vào ids[i]
+    std::vector<std::unique_ptr<Quad[]>> blocks;
+    std::mutex blockMutex;
+
+    // Mỗi nhánh đệ quy song song cấp quad-edge từ block riêng, chỉ lấy block mới là cần khóa
+    struct Allocator {
+        DelaunayMesh *mesh;
+        Quad *cur = nullptr;
+        size_t left = 0;
+        Quad *alloc() {
+            if (left == 0) {
+                std::lock_guard<std::mutex> lock(mesh->blockMutex);
+                mesh->blocks.push_back(std::make_unique<Quad[]>(BLOCK));
+                cur = mesh->blocks.back().get();
+                left = BLOCK;
+            }
+            --left;
+            return cur++;
+        }
+    };
+
+    static QEdge *rot(QEdge *e) { return e + (((e->r + 1) & 3) - e->r); }
+    static QEdge *sym(QEdge *e) { return e + (((e->r + 2) & 3) - e->r); }
+    static QEdge *invRot(QEdge *e) { return e + (((e->r + 3) & 3) - e->r); }
+    static QEdge *onext(QEdge *e) { return e->next; }
+    static QEdge *oprev(QEdge *e) { return rot(rot(e)->next); }
+    static QEdge *lnext(QEdge *e) { return rot(invRot(e)->next); }
+    static QEdge *rprev(QEdge *e) { return sym(e)->next; }
+    static int dest(QEdge *e) { return sym(e)->org; }
+
+    QEdge *makeEdge(Allocator &al, int a, int b) {
+        Quad *q = al.alloc();
+        for (int i = 0; i < 4; ++i) q->e[i].r = i;
+        q->e[0].next = &q->e[0];
+        q->e[1].next = &q->e[3];
+        q->e[2].next = &q->e[2];
+        q->e[3].next = &q->e[1];
+        q->e[0].org = a;
+        q->e[2].org = b;
+        q->alive = true;
+        return &q->e[0];
+    }
+
+    static void splice(QEdge *a, QEdge *b) {
+        QEdge *alpha = rot(a->next), *beta = rot(b->next);
+        std::swap(a->next, b->next);
+        std::swap(alpha->next, beta->next);
+    }
+
+    QEdge *connect(Allocator &al, QEdge *a, QEdge *b) {
+        QEdge *e = makeEdge(al, dest(a), b->org);
+        splice(e, lnext(a));
+        splice(sym(e), b);
+        return e;
+    }
+
+    static void deleteEdge(QEdge *e) {
+        splice(e, oprev(e));
+        splice(sym(e), oprev(sym(e)));
+        reinterpret_cast<Quad *>(e - e->r)->alive = false;
+    }
+
+    bool ccw(int a, int b, int c) const { return pred::orient2d(sorted[a], sorted[b], sorted[c]) > 0; }
+    bool rightOf(int p, QEdge *e) const { return ccw(p, dest(e), e->org); }
+    bool leftOf(int p, QEdge *e) const { return ccw(p, e->org, dest(e)); }
+    bool inCircle(int a, int b, int c, int d) const { return pred::incircle(sorted[a], sorted[b], sorted[c], sorted[d]) > 0; }
+
+    // Tính theo thứ tự chỉ số tăng dần để cùng một tam giác luôn cho cùng tọa độ
+    Vec2 circumcenter(int i, int j, int k) const {
+        if (i > j) std::swap(i, j);
+        if (j > k) std::swap(j, k);
+        if (i > j) std::swap(i, j);
+        Vec2 a = sorted[i], b = sorted[j], c = sorted[k];
+        double bx = b.x - a.x, by = b.y - a.y, cx = c.x - a.x, cy = c.y - a.y;
+        double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+        double d = 2.0 * (bx * cy - by * cx);
+        return {a.x + (cy * b2 - by * c2) / d, a.y + (bx * c2 - cx * b2) / d};
+    }
+
+    // Tam giác hóa sorted[lo, hi); trả về (cạnh lồi ngoài cùng bên trái CCW, cạnh lồi ngoài cùng bên phải CW)
+    std::pair<QEdge *, QEdge *> recurse(int lo, int hi, Allocator &al, int depth) {
+        int n = hi - lo;
+        if (n == 2) {
+            QEdge *a = makeEdge(al, lo, lo + 1);
+            return {a, sym(a)};
+        }
+        if (n == 3) {
+            QEdge *a = makeEdge(al, lo, lo + 1), *b = makeEdge(al, lo + 1, lo + 2);
+            splice(sym(a), b);
+            if (ccw(lo, lo + 1, lo + 2)) {
+                connect(al, b, a);
+                return {a, sym(b)};
+            }
+            if (ccw(lo, lo + 2, lo + 1)) {
+                QEdge *c = connect(al, b, a);
+                return {sym(c), c};
+            }
+            return {a, sym(b)}; // Thẳng hàng
+        }
+
+        int mid = lo + n / 2;
+        std::pair<QEdge *, QEdge *> L, R;
+        if (depth > 0 && n > 4096) {
+            Allocator other{this};
+            auto job = std::async(std::launch::async, [&] { return recurse(lo, mid, other, depth - 1); });
+            R = recurse(mid, hi, al, depth - 1);
+            L = job.get();
+        } else {
+            L = recurse(lo, mid, al, 0);
+            R = recurse(mid, hi, al, 0);
+        }
+        QEdge *ldo = L.first, *ldi = L.second, *rdi = R.first, *rdo = R.second;
+
+        // Tiếp tuyến chung dưới của hai nửa
+        for (;;) {
+            if (leftOf(rdi->org, ldi)) ldi = lnext(ldi);
+            else if (rightOf(ldi->org, rdi)) rdi = rprev(rdi);
+            else break;
+        }
+        QEdge *basel = connect(al, sym(rdi), ldi);
+        if (ldi->org == ldo->org) ldo = sym(basel);
+        if (rdi->org == rdo->org) rdo = basel;
+
+        // Kéo "đường đáy" lên, mỗi bước nối thêm một cạnh chéo, xóa các cạnh vi phạm tính Delaunay
+        auto valid = [&](QEdge *e) { return rightOf(dest(e), basel); };
+        for (;;) {
+            QEdge *lcand = onext(sym(basel));
+            if (valid(lcand)) {
+                while (inCircle(dest(basel), basel->org, dest(lcand), dest(onext(lcand)))) {
+                    QEdge *t = onext(lcand);
+                    deleteEdge(lcand);
+                    lcand = t;
+                }
+            }
+            QEdge *rcand = oprev(basel);
+            if (valid(rcand)) {
+                while (inCircle(dest(basel), basel->org, dest(rcand), dest(oprev(rcand)))) {
+                    QEdge *t = oprev(rcand);
+                    deleteEdge(rcand);
+                    rcand = t;
+                }
+            }
+            bool lv = valid(lcand), rv = valid(rcand);
+            if (!lv && !rv) break;
+            if (!lv || (rv && inCircle(dest(lcand), lcand->org, rcand->org, dest(rcand))))
+                basel = connect(al, rcand, sym(basel));
+            else
+                basel = connect(al, sym(basel), sym(lcand));
+        }
+        return {ldo, rdo};
+    }
+};
+
+// ---- Xuất kết quả dạng polyline ----
+
+// Tách đồ thị thành các đường đi không dùng lại cạnh (bắt đầu từ đỉnh bậc lẻ để ít đường nhất),
+// mỗi đường đi thành một polyline thay vì mỗi cạnh một hình
+inline std::vector<std::vector<int>> chainPaths(size_t vertexCount, const std::vector<IndexEdge> &edges) {
+    std::vector<size_t> start(vertexCount + 1, 0);
+    for (const IndexEdge &e : edges) {
+        ++start[e.a + 1];
+        ++start[e.b + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) start[v + 1] += start[v];
+    std::vector<int> adj(start[vertexCount]);
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        adj[fill[edges[i].a]++] = (int)i;
+        adj[fill[edges[i].b]++] = (int)i;
+    }
+    std::vector<char> used(edges.size(), 0);
+    std::vector<size_t> cursor(start.begin(), start.end() - 1);
+    auto nextEdge = [&](int v) -> int {
+        while (cursor[v] < start[v + 1]) {
+            int e = adj[cursor[v]++];
+            if (!used[e]) return e;
+        }
+        return -1;
+    };
+
+    std::vector<std::vector<int>> paths;
+    auto walkFrom = [&](int v) {
+        for (;;) {
+            int e = nextEdge(v);
+            if (e < 0) return;
+            cursor[v]--; // Trả lại để vòng đi bắt đầu đúng từ cạnh này
+            std::vector<int> path = {v};
+            int cur = v;
+            while ((e = nextEdge(cur)) >= 0) {
+                used[e] = 1;
+                cur = edges[e].a == cur ? edges[e].b : edges[e].a;
+                path.push_back(cur);
+            }
+            paths.push_back(std::move(path));
+        }
+    };
+    for (size_t v = 0; v < vertexCount; ++v)
+        if ((start[v + 1] - start[v]) % 2 == 1) walkFrom((int)v);
+    for (size_t v = 0; v < vertexCount; ++v) walkFrom((int)v);
+    return paths;
+}
+
+} // namespace pset
+
+#endif // POINT_SETS_H
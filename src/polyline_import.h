@@ -0,0 +1,174 @@
+#ifndef POLYLINE_IMPORT_H
+#define POLYLINE_IMPORT_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdlib>
+#include <cctype>
+#include "geometry.h"
+
+// Import polyline dạng stream từ file chuỗi điểm "x y x y ..." (phân tách bởi khoảng trắng/xuống dòng).
+// Luồng nền đọc file theo buffer cố định, parse thành các khúc CHUNK_POINTS điểm và đẩy vào
+// hàng đợi có giới hạn; luồng UI lấy dần các khúc mỗi frame nên polyline hiện ra trong lúc đang tải.
+// Bộ nhớ cho parse luôn bị chặn: READ_BUFFER + MAX_QUEUED_CHUNKS * CHUNK_POINTS điểm.
+class PolylineStreamImporter {
+public:
+    static const size_t READ_BUFFER = 1 << 20;
+    static const size_t CHUNK_POINTS = 1 << 16;
+    static const size_t MAX_QUEUED_CHUNKS = 8;
+
+    ~PolylineStreamImporter() { stop(); }
+
+    bool start(const std::string &path) {
+        stop();
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        if (!probe) {
+            errorMsg = "Cannot open " + path;
+            return false;
+        }
+        totalBytes = (size_t)probe.tellg();
+        bytesRead = 0;
+        pointsParsed = 0;
+        errorMsg.clear();
+        queue.clear();
+        stopFlag = false;
+        finished = false;
+        worker = std::thread(&PolylineStreamImporter::run, this, path);
+        return true;
+    }
+
+    // Dừng luồng nền (nếu còn chạy) và bỏ các khúc chưa lấy
+    void stop() {
+        stopFlag = true;
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.clear();
+    }
+
+    // Còn dữ liệu đang đọc hoặc đang chờ lấy
+    bool active() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return worker.joinable() && (!finished || !queue.empty());
+    }
+
+    // Nối tối đa maxChunks khúc vào out; trả về số điểm đã nối
+    size_t drain(std::vector<Vec2> &out, size_t maxChunks) {
+        size_t added = 0;
+        for (size_t k = 0; k < maxChunks; ++k) {
+            std::vector<Vec2> chunk;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (queue.empty()) break;
+                chunk = std::move(queue.front());
+                queue.pop_front();
+            }
+            cv.notify_all();
+            out.insert(out.end(), chunk.begin(), chunk.end());
+            added += chunk.size();
+        }
+        return added;
+    }
+
+    float progress() const { return totalBytes ? (float)bytesRead / (float)totalBytes : 1.0f; }
+    size_t points() const { return pointsParsed; }
+    std::string error() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return errorMsg;
+    }
+
+private:
+    std::thread worker;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::vector<Vec2>> queue;
+    std::atomic<bool> stopFlag{false};
+    bool finished = false;
+    std::string errorMsg;
+    std::atomic<size_t> bytesRead{0};
+    std::atomic<size_t> pointsParsed{0};
+    size_t totalBytes = 0;
+
+    // Chờ tới khi hàng đợi còn chỗ rồi đẩy khúc vào; false nếu bị hủy
+    bool push(std::vector<Vec2> &chunk) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&] { return stopFlag || queue.size() < MAX_QUEUED_CHUNKS; });
+        if (stopFlag) return false;
+        pointsParsed += chunk.size();
+        queue.push_back(std::move(chunk));
+        chunk.clear();
+        chunk.reserve(CHUNK_POINTS);
+        return true;
+    }
+
+    void fail(const std::string &msg) {
+        std::lock_guard<std::mutex> lock(mtx);
+        errorMsg = msg;
+    }
+
+    void run(std::string path) {
+        std::ifstream ifs(path, std::ios::binary);
+        std::vector<char> buf(READ_BUFFER + 1);
+        std::vector<Vec2> chunk;
+        chunk.reserve(CHUNK_POINTS);
+        size_t carry = 0; // Số byte của token bị cắt ở cuối buffer trước
+        bool haveX = false;
+        double x = 0.0;
+
+        while (!stopFlag && ifs) {
+            ifs.read(buf.data() + carry, (std::streamsize)(READ_BUFFER - carry));
+            size_t len = carry + (size_t)ifs.gcount();
+            bytesRead += (size_t)ifs.gcount();
+            bool eof = !ifs;
+
+            // Chỉ parse tới khoảng trắng cuối cùng, phần còn lại để dành cho lần đọc sau
+            size_t end = len;
+            if (!eof) {
+                while (end > 0 && !std::isspace((unsigned char)buf[end - 1])) --end;
+                if (end == 0) {
+                    fail("Token too long");
+                    break;
+                }
+            }
+            char saved = buf[end];
+            buf[end] = '\0';
+            char *p = buf.data();
+            char *limit = buf.data() + end;
+            while (p < limit) {
+                while (p < limit && std::isspace((unsigned char)*p)) ++p;
+                if (p >= limit) break;
+                char *e = nullptr;
+                double v = std::strtod(p, &e);
+                if (e == p) {
+                    fail("Invalid number in point file");
+                    stopFlag = true;
+                    break;
+                }
+                p = e;
+                if (!haveX) {
+                    x = v;
+                    haveX = true;
+                } else {
+                    chunk.push_back({x, v});
+                    haveX = false;
+                    if (chunk.size() >= CHUNK_POINTS && !push(chunk)) break;
+                }
+            }
+            buf[end] = saved;
+            carry = len - end;
+            std::copy(buf.begin() + end, buf.begin() + len, buf.begin());
+        }
+        if (!chunk.empty() && !stopFlag) push(chunk);
+
+        std::lock_guard<std::mutex> lock(mtx);
+        finished = true;
+    }
+};
+
+#endif // POLYLINE_IMPORT_H
@@ -0,0 +1,175 @@
+#ifndef POLYLINE_INDEX_H
+#define POLYLINE_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "geometry.h"
+
+// Chỉ mục không gian cho MỘT polyline lớn: chia đỉnh thành các khúc CHUNK đỉnh liên tiếp,
+// mỗi khúc có hộp bao (AABB), rồi xếp các hộp thành cây nhị phân ngầm (BVH) từ dưới lên.
+// Khúc c phủ các đoạn thẳng [c*CHUNK, min((c+1)*CHUNK, n-1)] nên hai khúc kề nhau dùng chung 1 đỉnh.
+class PolylineIndex {
+public:
+    static const size_t CHUNK = 64;
+    static const size_t MIN_VERTICES = 256; // Polyline nhỏ hơn thì duyệt tuyến tính
+
+    struct Box {
+        double minX, minY, maxX, maxY;
+        bool intersects(double l, double b, double r, double t) const {
+            return !(maxX < l || minX > r || maxY < b || minY > t);
+        }
+        // Khoảng cách nhỏ nhất từ p tới hộp (0 nếu p nằm trong)
+        double distance(Vec2 p) const {
+            double dx = std::max(0.0, std::max(minX - p.x, p.x - maxX));
+            double dy = std::max(0.0, std::max(minY - p.y, p.y - maxY));
+            return std::sqrt(dx * dx + dy * dy);
+        }
+    };
+
+    explicit PolylineIndex(const std::vector<Vec2> &poly) { rebuild(poly); }
+
+    size_t sourceSize() const { return n; }
+    size_t chunkCount() const { return tree.empty() ? 0 : tree[0].size(); }
+
+    // Chỉ số đỉnh đầu/cuối (bao gồm) của khúc c
+    size_t chunkBegin(size_t c) const { return c * CHUNK; }
+    size_t chunkEnd(size_t c) const { return std::min((c + 1) * CHUNK, n - 1); }
+
+    void rebuild(const std::vector<Vec2> &poly) {
+        n = poly.size();
+        tree.clear();
+        if (n < 2) return;
+        size_t chunks = (n - 2) / CHUNK + 1;
+        tree.push_back(std::vector<Box>(chunks));
+        for (size_t c = 0; c < chunks; ++c)
+            tree[0][c] = chunkBox(poly, c);
+        buildParents(0);
+    }
+
+    // Cập nhật sau khi nối thêm đỉnh vào cuối poly (dùng khi import dạng stream)
+    void append(const std::vector<Vec2> &poly) {
+        if (tree.empty() || n < 2) { rebuild(poly); return; }
+        size_t oldChunks = chunkCount();
+        n = poly.size();
+        size_t chunks = (n - 2) / CHUNK + 1;
+        // Khúc cuối cũ có thể đã được nối thêm đỉnh
+        tree[0][oldChunks - 1] = chunkBox(poly, oldChunks - 1);
+        for (size_t c = oldChunks; c < chunks; ++c)
+            tree[0].push_back(chunkBox(poly, c));
+        buildParents(oldChunks - 1);
+    }
+
+    // Gọi fn(c) cho mọi khúc có hộp bao giao với khung nhìn [l,r]x[b,t]
+    template <typename Fn>
+    void forEachChunkInView(double l, double b, double r, double t, Fn fn) const {
+        if (tree.empty()) return;
+        visit(tree.size() - 1, 0, [&](const Box &bx) { return bx.intersects(l, b, r, t); }, fn);
+    }
+
+    // Gọi fn(i) cho mọi đỉnh trong bán kính radius quanh p
+    template <typename Fn>
+    void forEachVertexNear(Vec2 p, double radius, Fn fn) const {
+        forEachChunkInView(p.x - radius, p.y - radius, p.x + radius, p.y + radius, [&](size_t c) {
+            for (size_t i = chunkBegin(c); i <= chunkEnd(c); ++i) fn(i);
+        });
+    }
+
+    // Hộp bao cả polyline (gốc của cây)
+    Box bounds() const { return tree.empty() ? Box{0.0, 0.0, 0.0, 0.0} : tree.back()[0]; }
+
+    // Tịnh tiến cùng polyline gốc: hộp chỉ dịch chuyển, cấu trúc cây giữ nguyên
+    void translate(double dx, double dy) {
+        for (std::vector<Box> &lv : tree)
+            for (Box &bx : lv) { bx.minX += dx; bx.maxX += dx; bx.minY += dy; bx.maxY += dy; }
+    }
+
+    // Khoảng cách nhỏ nhất từ p tới polyline: duyệt nhánh gần trước, cắt nhánh có hộp xa hơn kết quả tốt nhất
+    double distance(const std::vector<Vec2> &poly, Vec2 p, size_t *segTests = nullptr) const {
+        double best = 1e9;
+        if (tree.empty()) return best;
+        size_t tests = 0;
+        struct Item { size_t level, idx; double d; };
+        std::vector<Item> stack;
+        size_t root = tree.size() - 1;
+        stack.push_back({root, 0, tree[root][0].distance(p)});
+        while (!stack.empty()) {
+            Item it = stack.back();
+            stack.pop_back();
+            if (it.d >= best) continue;
+            if (it.level == 0) {
+                for (size_t i = chunkBegin(it.idx); i < chunkEnd(it.idx); ++i)
+                    best = std::min(best, segmentDistance(p, poly[i], poly[i + 1]));
+                tests += chunkEnd(it.idx) - chunkBegin(it.idx);
+                continue;
+            }
+            // Đẩy con xa trước để con gần được xét trước
+            size_t lv = it.level - 1, c0 = it.idx * 2, c1 = c0 + 1;
+            double d0 = tree[lv][c0].distance(p);
+            if (c1 < tree[lv].size()) {
+                double d1 = tree[lv][c1].distance(p);
+                if (d0 < d1) { stack.push_back({lv, c1, d1}); stack.push_back({lv, c0, d0}); }
+                else         { stack.push_back({lv, c0, d0}); stack.push_back({lv, c1, d1}); }
+            } else {
+                stack.push_back({lv, c0, d0});
+            }
+        }
+        if (segTests) *segTests += tests;
+        return best;
+    }
+
+private:
+    size_t n = 0;
+    std::vector<std::vector<Box>> tree; // tree[0] = các khúc, tree.back() = gốc (1 hộp)
+
+    static double segmentDistance(Vec2 p, Vec2 a, Vec2 b) {
+        double abx = b.x - a.x, aby = b.y - a.y;
+        double apx = p.x - a.x, apy = p.y - a.y;
+        double l2 = abx * abx + aby * aby;
+        double t = (l2 > 0.0) ? (apx * abx + apy * aby) / l2 : 0.0;
+        t = std::max(0.0, std::min(1.0, t));
+        double dx = a.x + t * abx - p.x, dy = a.y + t * aby - p.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    static Box merge(const Box &a, const Box &b) {
+        return {std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+    }
+
+    Box chunkBox(const std::vector<Vec2> &poly, size_t c) const {
+        Box bx{poly[chunkBegin(c)].x, poly[chunkBegin(c)].y, poly[chunkBegin(c)].x, poly[chunkBegin(c)].y};
+        for (size_t i = chunkBegin(c) + 1; i <= chunkEnd(c); ++i) {
+            bx.minX = std::min(bx.minX, poly[i].x); bx.maxX = std::max(bx.maxX, poly[i].x);
+            bx.minY = std::min(bx.minY, poly[i].y); bx.maxY = std::max(bx.maxY, poly[i].y);
+        }
+        return bx;
+    }
+
+    // Dựng lại các tầng cha, chỉ tính lại từ nút chứa khúc firstDirty trở đi
+    void buildParents(size_t firstDirty) {
+        size_t lv = 0;
+        while (tree[lv].size() > 1) {
+            size_t count = (tree[lv].size() + 1) / 2;
+            if (lv + 1 >= tree.size()) tree.push_back(std::vector<Box>());
+            tree[lv + 1].resize(count);
+            firstDirty /= 2;
+            for (size_t i = firstDirty; i < count; ++i) {
+                size_t c0 = i * 2, c1 = c0 + 1;
+                tree[lv + 1][i] = (c1 < tree[lv].size()) ? merge(tree[lv][c0], tree[lv][c1]) : tree[lv][c0];
+            }
+            ++lv;
+        }
+        tree.resize(lv + 1);
+    }
+
+    template <typename Pred, typename Fn>
+    void visit(size_t lv, size_t idx, Pred pred, Fn &fn) const {
+        if (!pred(tree[lv][idx])) return;
+        if (lv == 0) { fn(idx); return; }
+        size_t c0 = idx * 2, c1 = c0 + 1;
+        visit(lv - 1, c0, pred, fn);
+        if (c1 < tree[lv - 1].size()) visit(lv - 1, c1, pred, fn);
+    }
+};
+
+#endif // POLYLINE_INDEX_H
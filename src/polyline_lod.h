@@ -0,0 +1,145 @@
+#ifndef POLYLINE_LOD_H
+#define POLYLINE_LOD_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "geometry.h"
+
+// Kim tự tháp LOD cho polyline lớn, dựng bằng Douglas–Peucker.
+// Mỗi đỉnh được gán "độ quan trọng" = sai số DP lúc nó được chọn (kẹp theo đỉnh cha),
+// nên level với dung sai eps đúng bằng kết quả DP(eps) mà chỉ cần duyệt một lần.
+// DP chạy độc lập trên từng block BLOCK đỉnh (hai đầu block luôn được giữ), nhờ đó
+// có thể nối thêm đỉnh vào cuối mà chỉ phải tính lại block cuối.
+class PolylineLOD {
+public:
+    static const size_t MIN_VERTICES = 256; // Polyline nhỏ hơn thì vẽ trực tiếp
+    static const size_t MIN_LEVEL_SIZE = 32;
+    static const size_t BLOCK = 1 << 16;
+
+    // Level 0 là chính polyline gốc (không lưu bản sao, pts/srcIdx rỗng)
+    struct Level {
+        double error = 0.0;           // Khoảng cách tối đa từ polyline gốc tới level này
+        std::vector<Vec2> pts;        // Đỉnh của level (dùng để vẽ)
+        std::vector<uint32_t> srcIdx; // Chỉ số đỉnh tương ứng trong polyline gốc
+    };
+
+    explicit PolylineLOD(const std::vector<Vec2> &poly) {
+        levels.push_back(Level());
+        append(poly);
+    }
+
+    size_t sourceSize() const { return n; }
+    size_t levelCount() const { return levels.size(); }
+    const Level &level(size_t i) const { return levels[i]; }
+
+    // Level thô nhất có sai số không quá maxError (đơn vị World); 0 = độ phân giải gốc
+    size_t pickLevel(double maxError) const {
+        size_t best = 0;
+        for (size_t i = 1; i < levels.size(); ++i)
+            if (levels[i].error <= maxError) best = i;
+        return best;
+    }
+
+    // Cập nhật sau khi nối thêm đỉnh vào cuối poly: chỉ tính lại từ block cuối trở đi
+    void append(const std::vector<Vec2> &poly) {
+        size_t newN = poly.size();
+        if (newN <= n) return;
+
+        for (size_t i = n; i < newN; ++i) {
+            if (i == 0) { minX = maxX = poly[0].x; minY = maxY = poly[0].y; }
+            minX = std::min(minX, poly[i].x); maxX = std::max(maxX, poly[i].x);
+            minY = std::min(minY, poly[i].y); maxY = std::max(maxY, poly[i].y);
+        }
+        double diag = std::sqrt((maxX - minX) * (maxX - minX) + (maxY - minY) * (maxY - minY));
+
+        // 1. Độ quan trọng cho block cuối (có thể chưa đầy) và các block mới
+        size_t from = (n == 0) ? 0 : ((n - 1) / BLOCK) * BLOCK;
+        importance.resize(newN);
+        for (size_t a = from; a + 1 < newN; a += BLOCK)
+            computeImportance(poly, a, std::min(a + BLOCK, newN - 1));
+        importance[0] = importance[newN - 1] = INFINITY;
+        n = newN;
+
+        // 2. Cập nhật phần đuôi của các level đã có
+        for (size_t k = 1; k < levels.size(); ++k)
+            refill(levels[k], poly, from);
+
+        // 3. Thêm level thô hơn (dung sai x4 mỗi lần) khi kích thước bao cho phép
+        if (nextEps <= 0.0) nextEps = diag * 1e-5;
+        while (nextEps > 0.0 && nextEps < diag) {
+            size_t prevSize = (levels.size() == 1) ? n : levels.back().pts.size();
+            if (prevSize <= MIN_LEVEL_SIZE) break;
+            Level lv;
+            lv.error = nextEps;
+            refill(lv, poly, 0);
+            nextEps *= 4.0;
+            if (lv.pts.size() * 4 > prevSize * 3) continue; // Giảm chưa đáng kể
+            levels.push_back(std::move(lv));
+        }
+    }
+
+    // Tịnh tiến cùng polyline gốc: độ quan trọng và sai số không đổi nên không cần dựng lại
+    void translate(double dx, double dy) {
+        for (size_t k = 1; k < levels.size(); ++k)
+            for (Vec2 &p : levels[k].pts) { p.x += dx; p.y += dy; }
+        minX += dx; maxX += dx;
+        minY += dy; maxY += dy;
+    }
+
+private:
+    size_t n = 0;
+    std::vector<double> importance;
+    std::vector<Level> levels;
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    double nextEps = 0.0; // Dung sai của level thô kế tiếp sẽ thử thêm
+
+    static double segmentDistance(Vec2 p, Vec2 a, Vec2 b) {
+        double abx = b.x - a.x, aby = b.y - a.y;
+        double apx = p.x - a.x, apy = p.y - a.y;
+        double l2 = abx * abx + aby * aby;
+        double t = (l2 > 0.0) ? (apx * abx + apy * aby) / l2 : 0.0;
+        t = std::max(0.0, std::min(1.0, t));
+        double dx = a.x + t * abx - p.x, dy = a.y + t * aby - p.y;
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    // DP không đệ quy trên đoạn đỉnh [first, last]
+    void computeImportance(const std::vector<Vec2> &poly, size_t first, size_t last) {
+        importance[first] = importance[last] = INFINITY;
+        struct Range { size_t a, b; double parent; };
+        std::vector<Range> stack;
+        stack.push_back({first, last, INFINITY});
+        while (!stack.empty()) {
+            Range r = stack.back();
+            stack.pop_back();
+            if (r.b <= r.a + 1) continue;
+            double maxD = -1.0;
+            size_t split = r.a + 1;
+            for (size_t i = r.a + 1; i < r.b; ++i) {
+                double d = segmentDistance(poly[i], poly[r.a], poly[r.b]);
+                if (d > maxD) { maxD = d; split = i; }
+            }
+            double imp = std::min(maxD, r.parent);
+            importance[split] = imp;
+            stack.push_back({r.a, split, imp});
+            stack.push_back({split, r.b, imp});
+        }
+    }
+
+    // Bỏ các đỉnh có chỉ số >= from rồi lọc lại theo dung sai của level
+    void refill(Level &lv, const std::vector<Vec2> &poly, size_t from) const {
+        size_t keep = std::lower_bound(lv.srcIdx.begin(), lv.srcIdx.end(), (uint32_t)from) - lv.srcIdx.begin();
+        lv.srcIdx.resize(keep);
+        lv.pts.resize(keep);
+        for (size_t i = from; i < n; ++i) {
+            if (importance[i] > lv.error) {
+                lv.pts.push_back(poly[i]);
+                lv.srcIdx.push_back((uint32_t)i);
+            }
+        }
+    }
+};
+
+#endif // POLYLINE_LOD_H
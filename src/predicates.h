@@ -0,0 +1,212 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include "geometry.h"
+
+// Vị từ hình học bền vững (robust predicates): hướng (orientation), trong-đường-tròn (in-circle),
+// giao đoạn thẳng. Trả về dấu CHÍNH XÁC của định thức với đầu vào double (tọa độ World).
+// Mỗi vị từ tính trước bằng double kèm cận sai số (bộ lọc kiểu Shewchuk); chỉ khi |kết quả| nhỏ hơn
+// cận sai số (gần suy biến) mới tính lại bằng số học khai triển (expansion) chính xác tuyệt đối.
+// Nhánh chính xác hiếm khi chạy: không inline để đường nhanh của bộ lọc gọn
+#if defined(__GNUC__)
+#define PRED_NOINLINE __attribute__((noinline))
+#else
+#define PRED_NOINLINE __declspec(noinline)
+#endif
+
+namespace pred {
+
+// ---- Số học khai triển: một số = tổng các double không chồng bit, tăng dần độ lớn ----
+using Expansion = std::vector<double>;
+
+const double EPSILON = 1.1102230246251565e-16; // 2^-53
+const double SPLITTER = 134217729.0;           // 2^27 + 1
+const double CCW_ERRBOUND = (3.0 + 16.0 * EPSILON) * EPSILON;
+const double ICC_ERRBOUND = (10.0 + 96.0 * EPSILON) * EPSILON;
+
+inline void twoSum(double a, double b, double &x, double &y) {
+    x = a + b;
+    double bv = x - a;
+    double av = x - bv;
+    y = (a - av) + (b - bv);
+}
+
+inline void fastTwoSum(double a, double b, double &x, double &y) {
+    x = a + b;
+    y = b - (x - a);
+}
+
+inline void twoDiff(double a, double b, double &x, double &y) {
+    x = a - b;
+    double bv = a - x;
+    double av = x + bv;
+    y = (a - av) + (bv - b);
+}
+
+inline void split(double a, double &hi, double &lo) {
+    double c = SPLITTER * a;
+    double big = c - a;
+    hi = c - big;
+    lo = a - hi;
+}
+
+inline void twoProduct(double a, double b, double &x, double &y) {
+    x = a * b;
+    double ahi, alo, bhi, blo;
+    split(a, ahi, alo);
+    split(b, bhi, blo);
+    double err1 = x - ahi * bhi;
+    double err2 = err1 - alo * bhi;
+    double err3 = err2 - ahi * blo;
+    y = alo * blo - err3;
+}
+
+// a - b dưới dạng khai triển 2 phần tử (chính xác)
+inline Expansion diff(double a, double b) {
+    double x, y;
+    twoDiff(a, b, x, y);
+    if (y == 0.0) return {x};
+    return {y, x};
+}
+
+// e + f: trộn theo độ lớn rồi cộng dồn, bỏ các phần tử 0
+inline Expansion sum(const Expansion &e, const Expansion &f) {
+    Expansion h;
+    h.reserve(e.size() + f.size());
+    size_t ei = 0, fi = 0;
+    auto takeE = [&]() { return fi >= f.size() || (ei < e.size() && (f[fi] > e[ei]) == (f[fi] > -e[ei])); };
+    double q;
+    if (takeE()) q = e[ei++];
+    else q = f[fi++];
+    while (ei < e.size() || fi < f.size()) {
+        double now = takeE() ? e[ei++] : f[fi++];
+        double qn, hh;
+        twoSum(q, now, qn, hh);
+        q = qn;
+        if (hh != 0.0) h.push_back(hh);
+    }
+    if (q != 0.0 || h.empty()) h.push_back(q);
+    return h;
+}
+
+// e * b (scale_expansion_zeroelim)
+inline Expansion scale(const Expansion &e, double b) {
+    Expansion h;
+    h.reserve(e.size() * 2);
+    double q, hh;
+    twoProduct(e[0], b, q, hh);
+    if (hh != 0.0) h.push_back(hh);
+    for (size_t i = 1; i < e.size(); ++i) {
+        double p1, p0, s;
+        twoProduct(e[i], b, p1, p0);
+        twoSum(q, p0, s, hh);
+        if (hh != 0.0) h.push_back(hh);
+        fastTwoSum(p1, s, q, hh);
+        if (hh != 0.0) h.push_back(hh);
+    }
+    if (q != 0.0 || h.empty()) h.push_back(q);
+    return h;
+}
+
+inline Expansion mul(const Expansion &e, const Expansion &f) {
+    Expansion r = scale(e, f[0]);
+    for (size_t i = 1; i < f.size(); ++i) r = sum(r, scale(e, f[i]));
+    return r;
+}
+
+inline Expansion negate(Expansion e) {
+    for (double &v : e) v = -v;
+    return e;
+}
+
+// Dấu của khai triển = dấu phần tử lớn nhất (cuối cùng)
+inline int sign(const Expansion &e) {
+    double top = e.empty() ? 0.0 : e.back();
+    return (top > 0.0) - (top < 0.0);
+}
+
+// ---- Các vị từ ----
+
+// Dấu của (b - a) x (d - c): > 0 nếu hướng cd quay ngược chiều kim đồng hồ so với ab
+PRED_NOINLINE inline int crossSignExact(Vec2 a, Vec2 b, Vec2 c, Vec2 d) {
+    Expansion ux = diff(b.x, a.x), uy = diff(b.y, a.y);
+    Expansion vx = diff(d.x, c.x), vy = diff(d.y, c.y);
+    return sign(sum(mul(ux, vy), negate(mul(uy, vx))));
+}
+
+inline int crossSign(Vec2 a, Vec2 b, Vec2 c, Vec2 d) {
+    // Cận sai số của Shewchuk đã tính cả sai số làm tròn của các phép trừ
+    double ux = b.x - a.x, uy = b.y - a.y;
+    double vx = d.x - c.x, vy = d.y - c.y;
+    double l = ux * vy, r = uy * vx;
+    double det = l - r;
+    double errBound = CCW_ERRBOUND * (std::abs(l) + std::abs(r));
+    if (std::abs(det) > errBound) return (det > 0.0) - (det < 0.0);
+    return crossSignExact(a, b, c, d);
+}
+
+// > 0 nếu a, b, c theo chiều ngược kim đồng hồ, < 0 nếu cùng chiều, 0 nếu thẳng hàng
+inline int orient2d(Vec2 a, Vec2 b, Vec2 c) {
+    double acx = a.x - c.x, bcx = b.x - c.x;
+    double acy = a.y - c.y, bcy = b.y - c.y;
+    double l = acx * bcy, r = acy * bcx;
+    double det = l - r;
+    double errBound = CCW_ERRBOUND * (std::abs(l) + std::abs(r));
+    if (std::abs(det) > errBound) return (det > 0.0) - (det < 0.0);
+    return crossSignExact(c, a, c, b);
+}
+
+PRED_NOINLINE inline int incircleExact(Vec2 a, Vec2 b, Vec2 c, Vec2 d) {
+    Expansion adx = diff(a.x, d.x), ady = diff(a.y, d.y);
+    Expansion bdx = diff(b.x, d.x), bdy = diff(b.y, d.y);
+    Expansion cdx = diff(c.x, d.x), cdy = diff(c.y, d.y);
+    Expansion alift = sum(mul(adx, adx), mul(ady, ady));
+    Expansion blift = sum(mul(bdx, bdx), mul(bdy, bdy));
+    Expansion clift = sum(mul(cdx, cdx), mul(cdy, cdy));
+    Expansion bc = sum(mul(bdx, cdy), negate(mul(cdx, bdy)));
+    Expansion ca = sum(mul(cdx, ady), negate(mul(adx, cdy)));
+    Expansion ab = sum(mul(adx, bdy), negate(mul(bdx, ady)));
+    return sign(sum(sum(mul(alift, bc), mul(blift, ca)), mul(clift, ab)));
+}
+
+// > 0 nếu d nằm trong đường tròn qua a, b, c (a, b, c ngược chiều kim đồng hồ), 0 nếu đồng viên
+inline int incircle(Vec2 a, Vec2 b, Vec2 c, Vec2 d) {
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * alift +
+                       (std::abs(cdxady) + std::abs(adxcdy)) * blift +
+                       (std::abs(adxbdy) + std::abs(bdxady)) * clift;
+    double errBound = ICC_ERRBOUND * permanent;
+    if (std::abs(det) > errBound) return (det > 0.0) - (det < 0.0);
+    return incircleExact(a, b, c, d);
+}
+
+// Đoạn ab và cd có điểm chung (kể cả chạm đầu mút hoặc chồng lên nhau khi thẳng hàng)
+inline bool segmentsIntersect(Vec2 a, Vec2 b, Vec2 c, Vec2 d) {
+    int o1 = orient2d(a, b, c), o2 = orient2d(a, b, d);
+    int o3 = orient2d(c, d, a), o4 = orient2d(c, d, b);
+    if (o1 * o2 < 0 && o3 * o4 < 0) return true;
+    // p thẳng hàng với đoạn qr: p nằm trong hộp bao của qr thì nằm trên đoạn
+    auto onSegment = [](Vec2 q, Vec2 r, Vec2 p) {
+        return std::min(q.x, r.x) <= p.x && p.x <= std::max(q.x, r.x) &&
+               std::min(q.y, r.y) <= p.y && p.y <= std::max(q.y, r.y);
+    };
+    return (o1 == 0 && onSegment(a, b, c)) || (o2 == 0 && onSegment(a, b, d)) ||
+           (o3 == 0 && onSegment(c, d, a)) || (o4 == 0 && onSegment(c, d, b));
+}
+
+} // namespace pred
+
+#endif // PREDICATES_H
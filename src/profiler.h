@@ -0,0 +1,309 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <cfloat>
+#include "imgui.h"
+
+// Các giai đoạn trong vòng lặp chính được đo thời gian
+enum ProfileStage {
+    STAGE_GRID = 0,
+    STAGE_SHAPES,
+    STAGE_HIGHLIGHT,
+    STAGE_LABELS,
+    STAGE_IMGUI_BUILD,
+    STAGE_IMGUI_RENDER,
+    STAGE_SWAP,
+    STAGE_FRAME,
+    STAGE_COUNT
+};
+
+// Đo thời gian CPU (chrono) và GPU (timer query GL_TIMESTAMP) cho từng giai đoạn.
+// Một giai đoạn có thể được begin/end nhiều lần trong frame (VD: mỗi canvas khi chia màn hình): thời gian
+// các lần được cộng dồn, mỗi lần dùng 1 cặp query riêng.
+// Kết quả GPU được đọc lại trễ vài frame để không làm CPU phải chờ GPU.
+class FrameProfiler {
+public:
+    static const int HISTORY = 240;   // Số frame lưu trong lịch sử cuộn
+    static const int GPU_LATENCY = 4; // Số bộ query luân phiên (frame in flight)
+    static const int MAX_SPANS = 16;  // Số lần đo GPU tối đa của 1 giai đoạn/frame; các lần sau gộp vào lần cuối
+
+    FrameProfiler() {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            cpuHist[s].assign(HISTORY, 0.0f);
+            gpuHist[s].assign(HISTORY, 0.0f);
+        }
+    }
+
+    // Gọi sau khi đã có OpenGL context
+    void init() {
+        gpuSupported = GLAD_GL_VERSION_3_3 != 0;
+        if (!gpuSupported) return;
+        for (int f = 0; f < GPU_LATENCY; ++f) {
+            glGenQueries(STAGE_COUNT * MAX_SPANS * 2, &queries[f][0][0]);
+            pending[f] = false;
+        }
+    }
+
+    void shutdown() {
+        if (!gpuSupported) return;
+        for (int f = 0; f < GPU_LATENCY; ++f)
+            glDeleteQueries(STAGE_COUNT * MAX_SPANS * 2, &queries[f][0][0]);
+        gpuSupported = false;
+    }
+
+    void beginFrame() {
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            cpuCur[s] = 0.0f;
+            spans[s] = 0;
+            spanOpen[s] = false;
+        }
+        if (gpuSupported) collectGpu(slot);
+        beginStage(STAGE_FRAME);
+    }
+
+    void endFrame() {
+        endStage(STAGE_FRAME);
+        for (int s = 0; s < STAGE_COUNT; ++s)
+            cpuHist[s][cpuHead] = cpuCur[s];
+        cpuHead = (cpuHead + 1) % HISTORY;
+        if (cpuCount < HISTORY) ++cpuCount;
+
+        if (gpuSupported) {
+            pending[slot] = true;
+            for (int s = 0; s < STAGE_COUNT; ++s) issued[slot][s] = spans[s];
+            slotFrame[slot] = frameIndex;
+            slot = (slot + 1) % GPU_LATENCY;
+        }
+        ++frameIndex;
+    }
+
+    void beginStage(ProfileStage s) {
+        cpuStart[s] = Clock::now();
+        // Swap không có ý nghĩa đo trên GPU (không phát lệnh vẽ)
+        if (gpuSupported && s != STAGE_SWAP) {
+            // Hết cặp query: lần này nối vào lần cuối (end của lần cuối được ghi lại), khoảng hở ở giữa bị tính thêm
+            if (spans[s] < MAX_SPANS) glQueryCounter(queries[slot][s][spans[s] * 2], GL_TIMESTAMP);
+            spanOpen[s] = true;
+        }
+    }
+
+    void endStage(ProfileStage s) {
+        std::chrono::duration<float, std::milli> d = Clock::now() - cpuStart[s];
+        cpuCur[s] += d.count();
+        if (gpuSupported && spanOpen[s]) {
+            int k = std::min(spans[s], MAX_SPANS - 1);
+            glQueryCounter(queries[slot][s][k * 2 + 1], GL_TIMESTAMP);
+            if (spans[s] < MAX_SPANS) ++spans[s];
+            spanOpen[s] = false;
+        }
+    }
+
+    bool hasGpuTimers() const { return gpuSupported; }
+
+    static const char *stageName(int s) {
+        static const char *names[STAGE_COUNT] = {
+            "Grid", "Shapes", "Highlight", "Labels", "ImGui build", "ImGui render", "Swap", "Frame"};
+        return (s >= 0 && s < STAGE_COUNT) ? names[s] : "?";
+    }
+
+    // Phân vị p (0..100) trên lịch sử cuộn của một giai đoạn
+    float cpuPercentile(int s, float p) const { return percentile(cpuHist[s], cpuCount, p); }
+    float gpuPercentile(int s, float p) const { return percentile(gpuHist[s], gpuCount, p); }
+
+    void drawPanel(bool *open) {
+        ImGui::SetNextWindowSize(ImVec2(560, 380), ImGuiCond_FirstUseEver);
+        if (!ImGui::Begin("Profiler", open)) {
+            ImGui::End();
+            return;
+        }
+        ImGui::Text("Frames: %d  GPU timers: %s", cpuCount, gpuSupported ? "on" : "n/a");
+
+        // Biểu đồ thời gian frame theo thứ tự thời gian
+        std::vector<float> frames = ordered(cpuHist[STAGE_FRAME], cpuHead, cpuCount);
+        if (!frames.empty()) {
+            float p99 = cpuPercentile(STAGE_FRAME, 99.0f);
+            ImGui::PlotLines("Frame (ms)", frames.data(), (int)frames.size(), 0, nullptr, 0.0f, p99 * 1.25f, ImVec2(0, 60));
+            ImGui::PlotHistogram("Distribution", histogramOf(frames, 0.0f, p99 * 1.25f, 40).data(), 40, 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 60));
+        }
+
+        if (ImGui::BeginTable("stages", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+            ImGui::TableSetupColumn("Stage");
+            ImGui::TableSetupColumn("CPU p50");
+            ImGui::TableSetupColumn("CPU p95");
+            ImGui::TableSetupColumn("CPU p99");
+            ImGui::TableSetupColumn("GPU p50");
+            ImGui::TableSetupColumn("GPU p95");
+            ImGui::TableSetupColumn("GPU p99");
+            ImGui::TableHeadersRow();
+            for (int s = 0; s < STAGE_COUNT; ++s) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(stageName(s));
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%.3f", cpuPercentile(s, 50.0f));
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%.3f", cpuPercentile(s, 95.0f));
+                ImGui::TableSetColumnIndex(3); ImGui::Text("%.3f", cpuPercentile(s, 99.0f));
+                if (gpuSupported && s != STAGE_SWAP) {
+                    ImGui::TableSetColumnIndex(4); ImGui::Text("%.3f", gpuPercentile(s, 50.0f));
+                    ImGui::TableSetColumnIndex(5); ImGui::Text("%.3f", gpuPercentile(s, 95.0f));
+                    ImGui::TableSetColumnIndex(6); ImGui::Text("%.3f", gpuPercentile(s, 99.0f));
+                }
+            }
+            ImGui::EndTable();
+        }
+
+        static char dumpPath[260] = "profile";
+        ImGui::InputText("Dump file", dumpPath, sizeof(dumpPath));
+        if (ImGui::Button("Dump CSV"))
+            lastDumpOk = dumpCSV((std::string(dumpPath) + ".csv").c_str());
+        ImGui::SameLine();
+        if (ImGui::Button("Dump JSON"))
+            lastDumpOk = dumpJSON((std::string(dumpPath) + ".json").c_str());
+        if (!lastDumpOk)
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Dump failed");
+        ImGui::End();
+    }
+
+    // Xuất từng frame trong lịch sử: mỗi dòng một frame, mỗi cột một giai đoạn (ms)
+    bool dumpCSV(const char *path) const {
+        std::ofstream ofs(path);
+        if (!ofs) return false;
+        ofs << "frame";
+        for (int s = 0; s < STAGE_COUNT; ++s) ofs << ",cpu_" << stageName(s);
+        for (int s = 0; s < STAGE_COUNT; ++s) ofs << ",gpu_" << stageName(s);
+        ofs << "\n";
+
+        std::vector<float> cpu[STAGE_COUNT], gpu[STAGE_COUNT];
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            cpu[s] = ordered(cpuHist[s], cpuHead, cpuCount);
+            gpu[s] = ordered(gpuHist[s], gpuHead, gpuCount);
+        }
+        // GPU trễ hơn CPU vài frame và có thể bị bỏ mẫu: ghép theo số frame
+        std::vector<long long> gpuFrames;
+        int start = (gpuCount < HISTORY) ? 0 : gpuHead;
+        for (int i = 0; i < gpuCount; ++i) gpuFrames.push_back(gpuFrameHist[(start + i) % HISTORY]);
+
+        size_t g = 0;
+        for (int i = 0; i < cpuCount; ++i) {
+            long long frame = frameIndex - cpuCount + i;
+            while (g < gpuFrames.size() && gpuFrames[g] < frame) ++g;
+            bool hasGpu = g < gpuFrames.size() && gpuFrames[g] == frame;
+            ofs << frame;
+            for (int s = 0; s < STAGE_COUNT; ++s) ofs << "," << cpu[s][i];
+            for (int s = 0; s < STAGE_COUNT; ++s) {
+                ofs << ",";
+                if (hasGpu) ofs << gpu[s][g];
+            }
+            ofs << "\n";
+        }
+        return true;
+    }
+
+    bool dumpJSON(const char *path) const {
+        std::ofstream ofs(path);
+        if (!ofs) return false;
+        ofs << "{\n  \"frames\": " << cpuCount << ",\n  \"gpuTimers\": " << (gpuSupported ? "true" : "false")
+            << ",\n  \"stages\": [\n";
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            ofs << "    { \"name\": \"" << stageName(s) << "\",\n";
+            ofs << "      \"cpu\": { \"p50\": " << cpuPercentile(s, 50.0f) << ", \"p95\": " << cpuPercentile(s, 95.0f)
+                << ", \"p99\": " << cpuPercentile(s, 99.0f) << " },\n";
+            ofs << "      \"gpu\": { \"p50\": " << gpuPercentile(s, 50.0f) << ", \"p95\": " << gpuPercentile(s, 95.0f)
+                << ", \"p99\": " << gpuPercentile(s, 99.0f) << " },\n";
+            writeJsonArray(ofs, "cpuSamples", ordered(cpuHist[s], cpuHead, cpuCount));
+            ofs << ",\n";
+            writeJsonArray(ofs, "gpuSamples", ordered(gpuHist[s], gpuHead, gpuCount));
+            ofs << "\n    }" << (s + 1 < STAGE_COUNT ? "," : "") << "\n";
+        }
+        ofs << "  ]\n}\n";
+        return true;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<float> cpuHist[STAGE_COUNT];
+    std::vector<float> gpuHist[STAGE_COUNT];
+    long long gpuFrameHist[HISTORY] = {};
+    int cpuHead = 0, cpuCount = 0;
+    int gpuHead = 0, gpuCount = 0;
+    long long frameIndex = 0;
+
+    Clock::time_point cpuStart[STAGE_COUNT];
+    float cpuCur[STAGE_COUNT] = {};
+
+    bool gpuSupported = false;
+    GLuint queries[GPU_LATENCY][STAGE_COUNT][MAX_SPANS * 2] = {};
+    bool pending[GPU_LATENCY] = {};
+    int issued[GPU_LATENCY][STAGE_COUNT] = {}; // Số cặp query đã phát của từng giai đoạn
+    long long slotFrame[GPU_LATENCY] = {};
+    int spans[STAGE_COUNT] = {};               // Số lần đo đã đóng của frame hiện tại
+    bool spanOpen[STAGE_COUNT] = {};
+    int slot = 0;
+    bool lastDumpOk = true;
+
+    // Đọc kết quả của bộ query cũ nhất (đã phát GPU_LATENCY frame trước).
+    // Nếu GPU chưa xong thì bỏ mẫu đó thay vì chặn CPU.
+    void collectGpu(int f) {
+        if (!pending[f]) return;
+        pending[f] = false;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[f][STAGE_FRAME][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+        for (int s = 0; s < STAGE_COUNT; ++s) {
+            float ms = 0.0f;
+            for (int k = 0; k < issued[f][s]; ++k) {
+                GLuint64 t0 = 0, t1 = 0;
+                glGetQueryObjectui64v(queries[f][s][k * 2], GL_QUERY_RESULT, &t0);
+                glGetQueryObjectui64v(queries[f][s][k * 2 + 1], GL_QUERY_RESULT, &t1);
+                ms += (t1 > t0) ? (float)((double)(t1 - t0) / 1.0e6) : 0.0f;
+            }
+            gpuHist[s][gpuHead] = ms;
+        }
+        gpuFrameHist[gpuHead] = slotFrame[f];
+        gpuHead = (gpuHead + 1) % HISTORY;
+        if (gpuCount < HISTORY) ++gpuCount;
+    }
+
+    static float percentile(const std::vector<float> &hist, int count, float p) {
+        if (count <= 0) return 0.0f;
+        std::vector<float> tmp(hist.begin(), hist.begin() + count);
+        size_t k = (size_t)std::min<float>((float)(count - 1), p / 100.0f * (float)(count - 1) + 0.5f);
+        std::nth_element(tmp.begin(), tmp.begin() + k, tmp.end());
+        return tmp[k];
+    }
+
+    // Trả về mẫu theo thứ tự cũ -> mới từ ring buffer
+    static std::vector<float> ordered(const std::vector<float> &hist, int head, int count) {
+        std::vector<float> out;
+        out.reserve(count);
+        int start = (count < HISTORY) ? 0 : head;
+        for (int i = 0; i < count; ++i)
+            out.push_back(hist[(start + i) % HISTORY]);
+        return out;
+    }
+
+    static std::vector<float> histogramOf(const std::vector<float> &samples, float lo, float hi, int bins) {
+        std::vector<float> h(bins, 0.0f);
+        if (hi <= lo) return h;
+        for (float v : samples) {
+            int b = (int)((v - lo) / (hi - lo) * bins);
+            h[std::max(0, std::min(bins - 1, b))] += 1.0f;
+        }
+        return h;
+    }
+
+    static void writeJsonArray(std::ofstream &ofs, const char *key, const std::vector<float> &v) {
+        ofs << "      \"" << key << "\": [";
+        for (size_t i = 0; i < v.size(); ++i)
+            ofs << (i ? ", " : "") << v[i];
+        ofs << "]";
+    }
+};
+
+#endif // PROFILER_H
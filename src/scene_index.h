@@ -0,0 +1,152 @@
+#ifndef SCENE_INDEX_H
+#define SCENE_INDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "geometry.h"
+
+// Chỉ mục không gian cho CẢ bản vẽ: mỗi hình là 1 hộp bao (AABB), id = vị trí trong mảng đầu vào.
+// Các hộp được sắp theo mã Morton của tâm (gần nhau trên mặt phẳng -> gần nhau trong mảng),
+// chia thành lá LEAF hộp liên tiếp rồi xếp thành cây nhị phân ngầm (BVH) từ dưới lên như PolylineIndex.
+// Cây tĩnh: dựng 1 lần O(n log n) rồi trả lời nhiều truy vấn (VD: mọi lần chuột di chuyển khi kéo khung chọn).
+class SceneIndex {
+public:
+    static const size_t LEAF = 16;
+
+    struct Box {
+        double minX, minY, maxX, maxY;
+        bool intersects(const Box &o) const {
+            return !(maxX < o.minX || minX > o.maxX || maxY < o.minY || minY > o.maxY);
+        }
+        bool contains(const Box &o) const {
+            return minX <= o.minX && o.maxX <= maxX && minY <= o.minY && o.maxY <= maxY;
+        }
+    };
+
+    size_t size() const { return ids.size(); }
+
+    void build(const std::vector<Box> &boxes) {
+        items.clear();
+        ids.clear();
+        tree.clear();
+        if (boxes.empty()) return;
+
+        Box all = boxes[0];
+        for (const Box &b : boxes) all = merge(all, b);
+        double sx = (all.maxX > all.minX) ? 65535.0 / (all.maxX - all.minX) : 0.0;
+        double sy = (all.maxY > all.minY) ? 65535.0 / (all.maxY - all.minY) : 0.0;
+        std::vector<std::pair<uint32_t, uint32_t>> keyed(boxes.size());
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            double cx = 0.5 * (boxes[i].minX + boxes[i].maxX), cy = 0.5 * (boxes[i].minY + boxes[i].maxY);
+            uint32_t qx = (uint32_t)((cx - all.minX) * sx), qy = (uint32_t)((cy - all.minY) * sy);
+            keyed[i] = {interleave(qx) | (interleave(qy) << 1), (uint32_t)i};
+        }
+        std::sort(keyed.begin(), keyed.end());
+
+        items.resize(boxes.size());
+        ids.resize(boxes.size());
+        for (size_t i = 0; i < keyed.size(); ++i) {
+            ids[i] = keyed[i].second;
+            items[i] = boxes[ids[i]];
+        }
+
+        size_t leaves = (items.size() + LEAF - 1) / LEAF;
+        tree.push_back(std::vector<Box>(leaves));
+        for (size_t c = 0; c < leaves; ++c) {
+            Box bx = items[c * LEAF];
+            for (size_t i = c * LEAF + 1; i < std::min((c + 1) * LEAF, items.size()); ++i) bx = merge(bx, items[i]);
+            tree[0][c] = bx;
+        }
+        while (tree.back().size() > 1) {
+            const std::vector<Box> &lower = tree.back();
+            std::vector<Box> upper((lower.size() + 1) / 2);
+            for (size_t i = 0; i < upper.size(); ++i) {
+                size_t c0 = i * 2, c1 = c0 + 1;
+                upper[i] = (c1 < lower.size()) ? merge(lower[c0], lower[c1]) : lower[c0];
+            }
+            tree.push_back(std::move(upper));
+        }
+    }
+
+    // Gọi fn(id) cho mọi hộp nằm TRỌN trong q. Nút nằm trọn trong q thì báo cả cây con, không xét từng hộp.
+    template <typename Fn>
+    void forEachInside(const Box &q, Fn fn) const {
+        if (tree.empty()) return;
+        visit(tree.size() - 1, 0, q, false, fn);
+    }
+
+    // Gọi fn(id) cho mọi hộp giao với q
+    template <typename Fn>
+    void forEachIntersecting(const Box &q, Fn fn) const {
+        if (tree.empty()) return;
+        visitIntersecting(tree.size() - 1, 0, q, fn);
+    }
+
+private:
+    std::vector<Box> items;             // Hộp theo thứ tự Morton
+    std::vector<uint32_t> ids;          // ids[i] = vị trí gốc của items[i]
+    std::vector<std::vector<Box>> tree; // tree[0] = các lá, tree.back() = gốc
+
+    static Box merge(const Box &a, const Box &b) {
+        return {std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+    }
+
+    // Chèn 1 bit 0 giữa các bit của 16 bit thấp (mã Morton 2D)
+    static uint32_t interleave(uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    // Chỉ số hộp đầu/cuối (không bao gồm) thuộc nút (lv, idx)
+    size_t nodeBegin(size_t lv, size_t idx) const { return (idx << lv) * LEAF; }
+    size_t nodeEnd(size_t lv, size_t idx) const { return std::min(((idx + 1) << lv) * LEAF, items.size()); }
+
+    template <typename Fn>
+    void visit(size_t lv, size_t idx, const Box &q, bool inside, Fn &fn) const {
+        if (!inside) {
+            const Box &node = tree[lv][idx];
+            if (!q.intersects(node)) return;
+            inside = q.contains(node);
+        }
+        if (inside || lv == 0) {
+            for (size_t i = nodeBegin(lv, idx); i < nodeEnd(lv, idx); ++i)
+                if (inside || q.contains(items[i])) fn(ids[i]);
+            return;
+        }
+        size_t c0 = idx * 2, c1 = c0 + 1;
+        visit(lv - 1, c0, q, false, fn);
+        if (c1 < tree[lv - 1].size()) visit(lv - 1, c1, q, false, fn);
+    }
+
+    template <typename Fn>
+    void visitIntersecting(size_t lv, size_t idx, const Box &q, Fn &fn) const {
+        if (!q.intersects(tree[lv][idx])) return;
+        if (lv == 0) {
+            for (size_t i = nodeBegin(0, idx); i < nodeEnd(0, idx); ++i)
+                if (q.intersects(items[i])) fn(ids[i]);
+            return;
+        }
+        size_t c0 = idx * 2, c1 = c0 + 1;
+        visitIntersecting(lv - 1, c0, q, fn);
+        if (c1 < tree[lv - 1].size()) visitIntersecting(lv - 1, c1, q, fn);
+    }
+};
+
+// Điểm p nằm trong đa giác (đóng ngầm giữa đỉnh cuối và đỉnh đầu), quy tắc chẵn-lẻ
+inline bool pointInPolygon(const std::vector<Vec2> &poly, Vec2 p) {
+    bool in = false;
+    for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+        const Vec2 &a = poly[i], &b = poly[j];
+        if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y))
+            in = !in;
+    }
+    return in;
+}
+
+#endif // SCENE_INDEX_H
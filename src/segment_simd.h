@@ -0,0 +1,200 @@
+#ifndef SEGMENT_SIMD_H
+#define SEGMENT_SIMD_H
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "geometry.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define SEGMENT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Tính khoảng cách từ 1 điểm tới nhiều đoạn thẳng cùng lúc (SIMD).
+// Dữ liệu dạng SoA: mảng x[] và y[] của chuỗi đỉnh, đoạn i = (x[i],y[i]) -> (x[i+1],y[i+1]);
+// nhờ vậy polyline và đường cong lấy mẫu không cần lưu đầu mút hai lần.
+// Kernel AVX2 / SSE2 / vô hướng được chọn một lần lúc chạy theo CPU.
+// Tọa độ World là double nên chuỗi lưu tọa độ float TƯƠNG ĐỐI so với origin (thường là điểm truy vấn):
+// khoảng cách gần điểm truy vấn vẫn chính xác khi zoom sâu mà kernel vẫn chạy bằng float.
+
+// Kết quả: khoảng cách nhỏ nhất và chỉ số đoạn đạt được (đoạn đầu tiên nếu bằng nhau)
+struct SegmentHit {
+    float dist = 1e9f;
+    size_t index = 0;
+};
+
+// Chuỗi đỉnh dạng SoA, tọa độ tính từ origin
+struct SegmentChain {
+    Vec2 origin{0.0, 0.0};
+    std::vector<float> x, y;
+
+    void clear(Vec2 o = {0.0, 0.0}) { origin = o; x.clear(); y.clear(); }
+    void reserve(size_t n) { x.reserve(n); y.reserve(n); }
+    void push(Vec2 p) { x.push_back((float)(p.x - origin.x)); y.push_back((float)(p.y - origin.y)); }
+    void assign(const Vec2 *pts, size_t n, Vec2 o = {0.0, 0.0}) {
+        origin = o;
+        x.resize(n);
+        y.resize(n);
+        for (size_t i = 0; i < n; ++i) { x[i] = (float)(pts[i].x - o.x); y[i] = (float)(pts[i].y - o.y); }
+    }
+    size_t segments() const { return x.size() < 2 ? 0 : x.size() - 1; }
+};
+
+namespace segsimd {
+
+// Bình phương khoảng cách tới đoạn i; cùng thứ tự phép tính với các kernel SIMD
+inline float segmentDistSq(const float *x, const float *y, size_t i, float px, float py) {
+    float abx = x[i + 1] - x[i], aby = y[i + 1] - y[i];
+    float apx = px - x[i], apy = py - y[i];
+    float l2 = abx * abx + aby * aby;
+    float t = (l2 > 0.0f) ? (apx * abx + apy * aby) / l2 : 0.0f;
+    t = std::max(0.0f, std::min(1.0f, t));
+    float dx = (x[i] + t * abx) - px, dy = (y[i] + t * aby) - py;
+    return dx * dx + dy * dy;
+}
+
+// Phần đuôi (và toàn bộ khi không có SIMD)
+inline void scalarRange(const float *x, const float *y, size_t begin, size_t end, float px, float py, float &best, size_t &bestIdx) {
+    for (size_t i = begin; i < end; ++i) {
+        float d = segmentDistSq(x, y, i, px, py);
+        if (d < best) { best = d; bestIdx = i; }
+    }
+}
+
+inline SegmentHit nearestScalar(const float *x, const float *y, size_t nSeg, float px, float py) {
+    float best = INFINITY;
+    size_t bestIdx = 0;
+    scalarRange(x, y, 0, nSeg, px, py, best, bestIdx);
+    return {nSeg ? std::sqrt(best) : 1e9f, bestIdx};
+}
+
+#ifdef SEGMENT_SIMD_X86
+
+// SSE2 có sẵn trên mọi CPU x86-64: 4 đoạn mỗi vòng
+inline SegmentHit nearestSSE2(const float *x, const float *y, size_t nSeg, float px, float py) {
+    const size_t W = 4;
+    size_t simdEnd = nSeg / W * W;
+    __m128 vpx = _mm_set1_ps(px), vpy = _mm_set1_ps(py);
+    __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 best = _mm_set1_ps(INFINITY);
+    __m128i bestIdx = _mm_setzero_si128();
+    __m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i step = _mm_set1_epi32((int)W);
+    for (size_t i = 0; i < simdEnd; i += W) {
+        __m128 ax = _mm_loadu_ps(x + i), ay = _mm_loadu_ps(y + i);
+        __m128 abx = _mm_sub_ps(_mm_loadu_ps(x + i + 1), ax);
+        __m128 aby = _mm_sub_ps(_mm_loadu_ps(y + i + 1), ay);
+        __m128 apx = _mm_sub_ps(vpx, ax), apy = _mm_sub_ps(vpy, ay);
+        __m128 l2 = _mm_add_ps(_mm_mul_ps(abx, abx), _mm_mul_ps(aby, aby));
+        __m128 dot = _mm_add_ps(_mm_mul_ps(apx, abx), _mm_mul_ps(apy, aby));
+        // Đoạn suy biến (l2 = 0) lấy t = 0 như bản vô hướng
+        __m128 t = _mm_and_ps(_mm_div_ps(dot, l2), _mm_cmpgt_ps(l2, zero));
+        t = _mm_max_ps(zero, _mm_min_ps(one, t));
+        __m128 dx = _mm_sub_ps(_mm_add_ps(ax, _mm_mul_ps(t, abx)), vpx);
+        __m128 dy = _mm_sub_ps(_mm_add_ps(ay, _mm_mul_ps(t, aby)), vpy);
+        __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 lt = _mm_cmplt_ps(d, best);
+        best = _mm_or_ps(_mm_and_ps(lt, d), _mm_andnot_ps(lt, best));
+        __m128i ltI = _mm_castps_si128(lt);
+        bestIdx = _mm_or_si128(_mm_and_si128(ltI, idx), _mm_andnot_si128(ltI, bestIdx));
+        idx = _mm_add_epi32(idx, step);
+    }
+    alignas(16) float lanes[W];
+    alignas(16) int32_t lanesIdx[W];
+    _mm_store_ps(lanes, best);
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanesIdx), bestIdx);
+    float b = INFINITY;
+    size_t bi = 0;
+    for (size_t k = 0; k < W; ++k)
+        if (lanes[k] < b || (lanes[k] == b && (size_t)lanesIdx[k] < bi)) { b = lanes[k]; bi = (size_t)lanesIdx[k]; }
+    scalarRange(x, y, simdEnd, nSeg, px, py, b, bi);
+    return {nSeg ? std::sqrt(b) : 1e9f, bi};
+}
+
+// AVX2: 8 đoạn mỗi vòng; chỉ gọi khi CPU hỗ trợ (biên dịch riêng cho hàm này, không cần -mavx2)
+#if defined(__GNUC__)
+__attribute__((target("avx2")))
+#endif
+inline SegmentHit nearestAVX2(const float *x, const float *y, size_t nSeg, float px, float py) {
+    const size_t W = 8;
+    size_t simdEnd = nSeg / W * W;
+    __m256 vpx = _mm256_set1_ps(px), vpy = _mm256_set1_ps(py);
+    __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    __m256 best = _mm256_set1_ps(INFINITY);
+    __m256i bestIdx = _mm256_setzero_si256();
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i step = _mm256_set1_epi32((int)W);
+    for (size_t i = 0; i < simdEnd; i += W) {
+        __m256 ax = _mm256_loadu_ps(x + i), ay = _mm256_loadu_ps(y + i);
+        __m256 abx = _mm256_sub_ps(_mm256_loadu_ps(x + i + 1), ax);
+        __m256 aby = _mm256_sub_ps(_mm256_loadu_ps(y + i + 1), ay);
+        __m256 apx = _mm256_sub_ps(vpx, ax), apy = _mm256_sub_ps(vpy, ay);
+        __m256 l2 = _mm256_add_ps(_mm256_mul_ps(abx, abx), _mm256_mul_ps(aby, aby));
+        __m256 dot = _mm256_add_ps(_mm256_mul_ps(apx, abx), _mm256_mul_ps(apy, aby));
+        __m256 t = _mm256_and_ps(_mm256_div_ps(dot, l2), _mm256_cmp_ps(l2, zero, _CMP_GT_OQ));
+        t = _mm256_max_ps(zero, _mm256_min_ps(one, t));
+        __m256 dx = _mm256_sub_ps(_mm256_add_ps(ax, _mm256_mul_ps(t, abx)), vpx);
+        __m256 dy = _mm256_sub_ps(_mm256_add_ps(ay, _mm256_mul_ps(t, aby)), vpy);
+        __m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 lt = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+        best = _mm256_blendv_ps(best, d, lt);
+        bestIdx = _mm256_blendv_epi8(bestIdx, idx, _mm256_castps_si256(lt));
+        idx = _mm256_add_epi32(idx, step);
+    }
+    alignas(32) float lanes[W];
+    alignas(32) int32_t lanesIdx[W];
+    _mm256_store_ps(lanes, best);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanesIdx), bestIdx);
+    float b = INFINITY;
+    size_t bi = 0;
+    for (size_t k = 0; k < W; ++k)
+        if (lanes[k] < b || (lanes[k] == b && (size_t)lanesIdx[k] < bi)) { b = lanes[k]; bi = (size_t)lanesIdx[k]; }
+    scalarRange(x, y, simdEnd, nSeg, px, py, b, bi);
+    return {nSeg ? std::sqrt(b) : 1e9f, bi};
+}
+
+#endif // SEGMENT_SIMD_X86
+
+enum Level { LEVEL_SCALAR, LEVEL_SSE2, LEVEL_AVX2 };
+
+// Mức SIMD tốt nhất CPU hỗ trợ (kiểm tra một lần)
+inline Level detectLevel() {
+#if defined(SEGMENT_SIMD_X86) && defined(__GNUC__)
+    static const Level level = __builtin_cpu_supports("avx2") ? LEVEL_AVX2 : LEVEL_SSE2;
+    return level;
+#elif defined(SEGMENT_SIMD_X86)
+    return LEVEL_SSE2;
+#else
+    return LEVEL_SCALAR;
+#endif
+}
+
+inline const char *levelName(Level level) {
+    switch (level) {
+    case LEVEL_AVX2: return "AVX2";
+    case LEVEL_SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+inline SegmentHit nearest(Level level, const float *x, const float *y, size_t nSeg, float px, float py) {
+#ifdef SEGMENT_SIMD_X86
+    if (level == LEVEL_AVX2) return nearestAVX2(x, y, nSeg, px, py);
+    if (level == LEVEL_SSE2) return nearestSSE2(x, y, nSeg, px, py);
+#else
+    (void)level;
+#endif
+    return nearestScalar(x, y, nSeg, px, py);
+}
+
+} // namespace segsimd
+
+// Đoạn gần p nhất trong chuỗi; dùng kernel tốt nhất của CPU hiện tại
+inline SegmentHit nearestSegment(const SegmentChain &chain, Vec2 p) {
+    return segsimd::nearest(segsimd::detectLevel(), chain.x.data(), chain.y.data(), chain.segments(),
+                            (float)(p.x - chain.origin.x), (float)(p.y - chain.origin.y));
+}
+
+#endif // SEGMENT_SIMD_H
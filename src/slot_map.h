@@ -0,0 +1,134 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <atomic>
+
+// Handle bền cho 1 phần tử của SlotMap: vẫn trỏ đúng phần tử dù các phần tử khác bị xóa;
+// phần tử của nó bị xóa thì handle hết hạn (indexOf trả về -1) thay vì trỏ nhầm sang phần tử khác.
+struct SlotHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t gen = 0;
+    bool operator==(const SlotHandle &o) const { return slot == o.slot && gen == o.gen; }
+    bool operator!=(const SlotHandle &o) const { return !(*this == o); }
+};
+
+// Slot map: phần tử nằm liền nhau trong 1 vector (duyệt/vẽ như vector thường, truy cập theo chỉ số dày),
+// thêm một bảng slot -> chỉ số dày để tra handle O(1).
+// Xóa là O(1): phần tử cuối được chuyển vào chỗ trống (thứ tự các phần tử còn lại có thể đổi).
+// Thế hệ (gen) lấy từ bộ đếm chung tăng dần nên handle không bao giờ trùng, kể cả khi cả SlotMap
+// được thay bằng bản sao cũ (Undo/Redo).
+template <typename T>
+class SlotMap {
+public:
+    using Handle = SlotHandle;
+
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    void reserve(size_t n) { items_.reserve(n); denseSlot.reserve(n); }
+
+    T &operator[](size_t i) { return items_[i]; }
+    const T &operator[](size_t i) const { return items_[i]; }
+    T &back() { return items_.back(); }
+    const T &back() const { return items_.back(); }
+    typename std::vector<T>::iterator begin() { return items_.begin(); }
+    typename std::vector<T>::iterator end() { return items_.end(); }
+    typename std::vector<T>::const_iterator begin() const { return items_.begin(); }
+    typename std::vector<T>::const_iterator end() const { return items_.end(); }
+
+    // Các phần tử theo thứ tự dày (dùng khi cần vector thường, VD: lưu file)
+    const std::vector<T> &items() const { return items_; }
+
+    Handle push_back(T v) {
+        uint32_t s;
+        if (!freeSlots.empty()) {
+            s = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            s = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        slots[s] = {(uint32_t)items_.size(), nextGeneration()};
+        items_.push_back(std::move(v));
+        denseSlot.push_back(s);
+        return {s, slots[s].gen};
+    }
+
+    Handle handleAt(size_t i) const {
+        if (i >= items_.size()) return Handle();
+        uint32_t s = denseSlot[i];
+        return {s, slots[s].gen};
+    }
+
+    // Chỉ số dày hiện tại của handle, -1 nếu phần tử đã bị xóa
+    int indexOf(Handle h) const {
+        if (h.slot >= slots.size()) return -1;
+        const Slot &s = slots[h.slot];
+        return (s.gen == h.gen && s.index != FREE) ? (int)s.index : -1;
+    }
+
+    T *get(Handle h) {
+        int i = indexOf(h);
+        return i < 0 ? nullptr : &items_[i];
+    }
+
+    // Xóa phần tử ở chỉ số dày i: O(1), phần tử cuối chuyển vào vị trí i
+    void erase(size_t i) {
+        if (i >= items_.size()) return;
+        size_t last = items_.size() - 1;
+        uint32_t s = denseSlot[i];
+        if (i != last) {
+            items_[i] = std::move(items_[last]);
+            denseSlot[i] = denseSlot[last];
+            slots[denseSlot[i]].index = (uint32_t)i;
+        }
+        items_.pop_back();
+        denseSlot.pop_back();
+        slots[s].index = FREE;
+        freeSlots.push_back(s);
+    }
+
+    // Xóa nhiều phần tử (chỉ số tăng dần, không trùng): xóa từ lớn đến nhỏ để phần tử được
+    // chuyển vào chỗ trống luôn là phần tử không bị xóa. O(số phần tử bị xóa)
+    void eraseMany(const std::vector<int> &idx) {
+        for (size_t k = idx.size(); k-- > 0;) erase((size_t)idx[k]);
+    }
+
+    void clear() {
+        for (uint32_t s : denseSlot) {
+            slots[s].index = FREE;
+            freeSlots.push_back(s);
+        }
+        items_.clear();
+        denseSlot.clear();
+    }
+
+    // Thay toàn bộ nội dung (VD: mở file); mọi handle cũ hết hạn
+    void assign(std::vector<T> v) {
+        clear();
+        reserve(v.size());
+        for (T &x : v) push_back(std::move(x));
+    }
+
+private:
+    static const uint32_t FREE = UINT32_MAX;
+    struct Slot {
+        uint32_t index = FREE; // Chỉ số dày, FREE nếu slot trống
+        uint32_t gen = 0;
+    };
+
+    std::vector<T> items_;
+    std::vector<uint32_t> denseSlot; // denseSlot[i] = slot của items_[i]
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    static uint32_t nextGeneration() {
+        static std::atomic<uint32_t> counter{0};
+        return ++counter;
+    }
+};
+
+#endif // SLOT_MAP_H
@@ -0,0 +1,122 @@
+#ifndef TILE_EXPORT_H
+#define TILE_EXPORT_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <glad/glad.h>
+#include "png_writer.h"
+
+// Xuất ảnh độ phân giải tùy ý (VD: 32k x 32k) theo từng dải ngang: mỗi dải cao TILE_H hàng, chia thành
+// các tile TILE_W x TILE_H vẽ lần lượt vào 1 framebuffer ẩn (FBO) rồi đọc về bộ đệm của dải; dải xong
+// được ghi thẳng ra PNG. Bộ nhớ chỉ cần 1 dải (chiều rộng x TILE_H x 3 byte), không bao giờ giữ cả ảnh.
+// Mọi lệnh GL chạy trên luồng UI: gọi step() vài lần mỗi frame để UI không bị treo trong lúc xuất.
+class TiledImageExport {
+public:
+    static const int TILE_W = 2048;
+    static const int TILE_H = 256;
+    static const int MAX_SIZE = 65536; // Bộ đệm dải tối đa 65536 x 256 x 3 = 48 MB
+
+    bool start(const std::string &path, int width, int height) {
+        cancel();
+        err.clear();
+        if (width < 1 || height < 1 || width > MAX_SIZE || height > MAX_SIZE) {
+            err = "Image size must be 1.." + std::to_string(MAX_SIZE);
+            return false;
+        }
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, TILE_W, TILE_H);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            err = "Offscreen framebuffer not supported";
+            release();
+            return false;
+        }
+        if (!png.open(path, (uint32_t)width, (uint32_t)height)) {
+            err = png.error();
+            release();
+            return false;
+        }
+        w = width;
+        h = height;
+        nextRow = 0;
+        strip.assign((size_t)w * TILE_H * 3, 0);
+        return true;
+    }
+
+    bool active() const { return png.isOpen(); }
+    int width() const { return w; }
+    int height() const { return h; }
+    float progress() const { return h > 0 ? (float)nextRow / (float)h : 0.0f; }
+    const std::string &error() const { return err; }
+
+    // Vẽ và ghi dải kế tiếp. drawTile(x0, y0, tw, th) vẽ vùng ảnh [x0, x0 + tw) x [y0, y0 + th)
+    // (y0 tính từ mép TRÊN ảnh) vào FBO đang bind, viewport (0, 0, tw, th) đã đặt sẵn.
+    // Trả về true nếu còn dải để vẽ; false khi đã vẽ hết (gọi finish) hoặc lỗi (error() khác rỗng).
+    template <typename DrawTile>
+    bool step(DrawTile drawTile) {
+        if (!active() || nextRow >= h) return false;
+        int th = std::min(TILE_H, h - nextRow);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        // Đọc thẳng vào đúng cột của tile trong bộ đệm dải (hàng dài w pixel)
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glPixelStorei(GL_PACK_ROW_LENGTH, w);
+        for (int x0 = 0; x0 < w; x0 += TILE_W) {
+            int tw = std::min(TILE_W, w - x0);
+            glViewport(0, 0, tw, th);
+            drawTile(x0, nextRow, tw, th);
+            glReadPixels(0, 0, tw, th, GL_RGB, GL_UNSIGNED_BYTE, strip.data() + (size_t)x0 * 3);
+        }
+        glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // glReadPixels trả hàng DƯỚI cùng trước, PNG ghi từ trên xuống
+        for (int r = th - 1; r >= 0; --r) {
+            if (!png.writeRow(strip.data() + (size_t)r * w * 3)) {
+                err = png.error();
+                cancel();
+                return false;
+            }
+        }
+        nextRow += th;
+        return nextRow < h;
+    }
+
+    // Ghi phần kết của file sau khi step() đã vẽ hết
+    bool finish() {
+        bool ok = png.close();
+        if (!ok) err = png.error();
+        release();
+        return ok;
+    }
+
+    // Bỏ dở: xóa file đang ghi và giải phóng FBO (cần context GL còn sống)
+    void cancel() {
+        png.abort();
+        release();
+    }
+
+private:
+    PngStreamWriter png;
+    GLuint fbo = 0, color = 0;
+    int w = 0, h = 0;
+    int nextRow = 0;            // Hàng ảnh (từ trên) của dải kế tiếp
+    std::vector<uint8_t> strip; // RGB của 1 dải, hàng dưới cùng trước (thứ tự của glReadPixels)
+    std::string err;
+
+    void release() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (color) glDeleteRenderbuffers(1, &color);
+        fbo = color = 0;
+        std::vector<uint8_t>().swap(strip);
+    }
+};
+
+#endif // TILE_EXPORT_H
@@ -0,0 +1,471 @@
+#ifndef VECTOR_EXPORT_H
+#define VECTOR_EXPORT_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include "geometry.h"
+
+// Xuất vector (SVG/PDF) theo kiểu stream: mỗi hình được định dạng vào bộ đệm nhỏ rồi ghi thẳng ra file,
+// không dựng cây tài liệu trong bộ nhớ. Hình giữ dạng chính xác (đường tròn/elip, Bézier) thay vì
+// hàng trăm đỉnh tessellate như khi vẽ lên màn hình.
+// Cả 2 writer có chung giao diện (dùng qua template), nhận tọa độ World và tự đổi sang tọa độ trang.
+
+// Vùng World [l, r] x [b, t] phủ kín trang width x height (px với SVG, pt với PDF).
+// Trang phải cùng tỉ lệ với vùng World để đường tròn vẫn là đường tròn.
+struct VectorPage {
+    double l = 0.0, r = 1.0, b = 0.0, t = 1.0;
+    double width = 1.0, height = 1.0;
+};
+
+// Phần chung: file, bộ đệm, định dạng số và phép đổi World -> trang
+class VectorStream {
+public:
+    const std::string &error() const { return err; }
+
+protected:
+    static const size_t FLUSH_BYTES = 1 << 16;
+
+    std::ofstream out;
+    std::string buf;
+    std::string err;
+    VectorPage page;
+    double scale = 1.0; // Đơn vị trang / đơn vị World
+
+    bool openFile(const std::string &path, const VectorPage &pg) {
+        err.clear();
+        page = pg;
+        scale = pg.width / (pg.r - pg.l);
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            err = "Cannot open " + path;
+            return false;
+        }
+        buf.clear();
+        buf.reserve(FLUSH_BYTES * 2);
+        return true;
+    }
+
+    void put(const char *s) { buf += s; }
+    void put(const std::string &s) { buf += s; }
+
+    // Số với tối đa 2 chữ số thập phân (1/100 px), bỏ số 0 thừa
+    void num(double v) {
+        char tmp[32];
+        int n = snprintf(tmp, sizeof(tmp), "%.2f", v);
+        while (n > 0 && tmp[n - 1] == '0') --n;
+        if (n > 0 && tmp[n - 1] == '.') --n;
+        if (n == 2 && tmp[0] == '-' && tmp[1] == '0') n = 1, tmp[0] = '0'; // "-0"
+        buf.append(tmp, n);
+    }
+
+    void numSp(double v) {
+        num(v);
+        buf += ' ';
+    }
+
+    double px(double x) const { return (x - page.l) * scale; }
+    double len(double d) const { return d * scale; }
+
+    // Ghi bộ đệm ra file khi đủ lớn
+    bool flushIfFull() {
+        if (buf.size() < FLUSH_BYTES) return true;
+        return flush();
+    }
+
+    bool flush() {
+        out.write(buf.data(), (std::streamsize)buf.size());
+        buf.clear();
+        if (!out && err.empty()) err = "Write error";
+        return (bool)out;
+    }
+};
+
+class SvgWriter : public VectorStream {
+public:
+    bool open(const std::string &path, const VectorPage &pg) {
+        if (!openFile(path, pg)) return false;
+        put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+        num(pg.width);
+        put("\" height=\"");
+        num(pg.height);
+        put("\" viewBox=\"0 0 ");
+        numSp(pg.width);
+        num(pg.height);
+        put("\">\n<rect width=\"100%\" height=\"100%\" fill=\"#1f1f1f\"/>\n"
+            "<g fill=\"none\" stroke-width=\"1\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n");
+        return flushIfFull();
+    }
+
+    bool close() {
+        put("</g>\n</svg>\n");
+        bool ok = flush();
+        out.close();
+        return ok;
+    }
+
+    void line(Vec2 a, Vec2 b, const Color &c) {
+        put("<line x1=\"");
+        num(px(a.x));
+        put("\" y1=\"");
+        num(py(a.y));
+        put("\" x2=\"");
+        num(px(b.x));
+        put("\" y2=\"");
+        num(py(b.y));
+        stroke(c);
+    }
+
+    void polyline(const Vec2 *p, size_t n, const Color &c) {
+        if (n < 2) return;
+        put("<polyline points=\"");
+        for (size_t i = 0; i < n; ++i) {
+            num(px(p[i].x));
+            buf += ',';
+            num(py(p[i].y));
+            if (i + 1 < n) buf += ' ';
+            if (buf.size() >= FLUSH_BYTES) flush(); // Polyline hàng triệu đỉnh: không giữ cả phần tử trong bộ đệm
+        }
+        stroke(c);
+    }
+
+    void circle(Vec2 center, double r, const Color &c) {
+        put("<circle cx=\"");
+        num(px(center.x));
+        put("\" cy=\"");
+        num(py(center.y));
+        put("\" r=\"");
+        num(len(r));
+        stroke(c);
+    }
+
+    // angle: radian, ngược chiều kim đồng hồ trong World (trục y của SVG hướng xuống nên đổi dấu)
+    void ellipse(Vec2 center, double a, double b, double angle, const Color &c) {
+        double cx = px(center.x), cy = py(center.y);
+        put("<ellipse cx=\"");
+        num(cx);
+        put("\" cy=\"");
+        num(cy);
+        put("\" rx=\"");
+        num(len(a));
+        put("\" ry=\"");
+        num(len(b));
+        if (angle != 0.0) {
+            put("\" transform=\"rotate(");
+            numSp(-angle * 180.0 / 3.14159265358979323846);
+            numSp(cx);
+            num(cy);
+            buf += ')';
+        }
+        stroke(c);
+    }
+
+    void quadratic(Vec2 p0, Vec2 ctrl, Vec2 p1, const Color &c) {
+        put("<path d=\"M");
+        point(p0);
+        buf += 'Q';
+        point(ctrl);
+        buf += ' ';
+        point(p1);
+        stroke(c);
+    }
+
+    // Chuỗi Bézier bậc 3 bắt đầu tại start; ctrl gồm 3 điểm mỗi đoạn (c1, c2, điểm cuối)
+    void cubics(Vec2 start, const Vec2 *ctrl, size_t segments, const Color &c) {
+        if (segments == 0) return;
+        put("<path d=\"M");
+        point(start);
+        buf += 'C';
+        for (size_t i = 0; i < segments * 3; ++i) {
+            point(ctrl[i]);
+            if (i + 1 < segments * 3) buf += ' ';
+        }
+        stroke(c);
+    }
+
+    // Chấm tròn đặc đường kính diameter (đơn vị trang)
+    void dot(Vec2 p, double diameter, const Color &c) {
+        put("<circle cx=\"");
+        num(px(p.x));
+        put("\" cy=\"");
+        num(py(p.y));
+        put("\" r=\"");
+        num(0.5 * diameter);
+        put("\" stroke=\"none\" fill=\"");
+        color(c);
+        put("\"/>\n");
+        flushIfFull();
+    }
+
+    // Nhãn đặt lệch (dx, dy) đơn vị trang so với p, dy > 0 là lên trên
+    void text(Vec2 p, const std::string &s, double size, double dx, double dy, const Color &c) {
+        put("<text x=\"");
+        num(px(p.x) + dx);
+        put("\" y=\"");
+        num(py(p.y) - dy);
+        put("\" font-family=\"sans-serif\" font-size=\"");
+        num(size);
+        put("\" stroke=\"none\" fill=\"");
+        color(c);
+        put("\">");
+        for (char ch : s) {
+            if (ch == '&') put("&amp;");
+            else if (ch == '<') put("&lt;");
+            else if (ch == '>') put("&gt;");
+            else buf += ch;
+        }
+        put("</text>\n");
+        flushIfFull();
+    }
+
+private:
+    double py(double y) const { return (page.t - y) * scale; }
+
+    void point(Vec2 p) {
+        num(px(p.x));
+        buf += ',';
+        num(py(p.y));
+    }
+
+    void color(const Color &c) {
+        char tmp[8];
+        snprintf(tmp, sizeof(tmp), "#%02x%02x%02x", channel(c.r), channel(c.g), channel(c.b));
+        buf += tmp;
+    }
+
+    static int channel(float v) { return (int)std::lround(std::min(1.0f, std::max(0.0f, v)) * 255.0f); }
+
+    void stroke(const Color &c) {
+        put("\" stroke=\"");
+        color(c);
+        put("\"/>\n");
+        flushIfFull();
+    }
+};
+
+// PDF 1 trang. Content stream được ghi thẳng ra file; độ dài của nó (chỉ biết khi xong) nằm ở
+// 1 object riêng tham chiếu gián tiếp, bảng xref ghi ở cuối theo vị trí byte đã ghi lại.
+// Content không nén (không có zlib); đường tròn/elip là 4 cung Bézier bậc 3 (sai số ~0.03% bán kính).
+class PdfWriter : public VectorStream {
+public:
+    bool open(const std::string &path, const VectorPage &pg) {
+        if (!openFile(path, pg)) return false;
+        written = 0;
+        offsets.clear();
+        put("%PDF-1.4\n%\xE2\xE3\xCF\xD3\n");
+        beginObject(1);
+        put("<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+        beginObject(2);
+        put("<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+        beginObject(3);
+        put("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 ");
+        numSp(pg.width);
+        num(pg.height);
+        put("] /Contents 4 0 R /Resources << /Font << /F1 6 0 R >> >> >>\nendobj\n");
+        beginObject(4);
+        put("<< /Length 5 0 R >>\nstream\n");
+        streamStart = written + buf.size();
+        // Nền, nét 1 đơn vị, đầu/khớp nét tròn
+        put("0.122 0.122 0.122 rg 0 0 ");
+        numSp(pg.width);
+        num(pg.height);
+        put(" re f\n1 w 1 J 1 j\n");
+        return flushIfFull();
+    }
+
+    bool close() {
+        size_t streamLen = written + buf.size() - streamStart;
+        put("\nendstream\nendobj\n");
+        beginObject(5);
+        put(std::to_string(streamLen));
+        put("\nendobj\n");
+        beginObject(6);
+        put("<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>\nendobj\n");
+        size_t xref = written + buf.size();
+        put("xref\n0 7\n0000000000 65535 f \n");
+        for (size_t off : offsets) {
+            char tmp[24];
+            snprintf(tmp, sizeof(tmp), "%010zu 00000 n \n", off);
+            put(tmp);
+        }
+        put("trailer\n<< /Size 7 /Root 1 0 R >>\nstartxref\n");
+        put(std::to_string(xref));
+        put("\n%%EOF\n");
+        bool ok = flush();
+        out.close();
+        return ok;
+    }
+
+    void line(Vec2 a, Vec2 b, const Color &c) {
+        strokeColor(c);
+        move(a);
+        lineTo(b);
+        put("S\n");
+        flushIfFull();
+    }
+
+    void polyline(const Vec2 *p, size_t n, const Color &c) {
+        if (n < 2) return;
+        strokeColor(c);
+        move(p[0]);
+        for (size_t i = 1; i < n; ++i) {
+            lineTo(p[i]);
+            if (buf.size() >= FLUSH_BYTES) flush();
+        }
+        put("S\n");
+        flushIfFull();
+    }
+
+    void circle(Vec2 center, double r, const Color &c) { ellipse(center, r, r, 0.0, c); }
+
+    void ellipse(Vec2 center, double a, double b, double angle, const Color &c) {
+        strokeColor(c);
+        conicPath(center, a, b, angle);
+        put("S\n");
+        flushIfFull();
+    }
+
+    // Bézier bậc 2 nâng lên bậc 3 (chính xác)
+    void quadratic(Vec2 p0, Vec2 ctrl, Vec2 p1, const Color &c) {
+        strokeColor(c);
+        move(p0);
+        Vec2 c1 = {p0.x + 2.0 / 3.0 * (ctrl.x - p0.x), p0.y + 2.0 / 3.0 * (ctrl.y - p0.y)};
+        Vec2 c2 = {p1.x + 2.0 / 3.0 * (ctrl.x - p1.x), p1.y + 2.0 / 3.0 * (ctrl.y - p1.y)};
+        curveTo(c1, c2, p1);
+        put("S\n");
+        flushIfFull();
+    }
+
+    void cubics(Vec2 start, const Vec2 *ctrl, size_t segments, const Color &c) {
+        if (segments == 0) return;
+        strokeColor(c);
+        move(start);
+        for (size_t i = 0; i < segments; ++i) curveTo(ctrl[3 * i], ctrl[3 * i + 1], ctrl[3 * i + 2]);
+        put("S\n");
+        flushIfFull();
+    }
+
+    void dot(Vec2 p, double diameter, const Color &c) {
+        fillColor(c);
+        double r = 0.5 * diameter / scale;
+        conicPath(p, r, r, 0.0);
+        put("f\n");
+        flushIfFull();
+    }
+
+    void text(Vec2 p, const std::string &s, double size, double dx, double dy, const Color &c) {
+        fillColor(c);
+        put("BT /F1 ");
+        numSp(size);
+        put("Tf ");
+        numSp(px(p.x) + dx);
+        numSp(py(p.y) + dy);
+        put("Td (");
+        for (char ch : s) {
+            if (ch == '(' || ch == ')' || ch == '\\') buf += '\\';
+            buf += ch;
+        }
+        put(") Tj ET\n");
+        flushIfFull();
+    }
+
+private:
+    std::vector<size_t> offsets; // Vị trí byte của object 1..6
+    size_t written = 0;          // Số byte đã ghi ra file
+    size_t streamStart = 0;
+    Color curStroke{-1.0f, 0.0f, 0.0f}, curFill{-1.0f, 0.0f, 0.0f};
+
+    double py(double y) const { return (y - page.b) * scale; }
+
+    void beginObject(int id) {
+        offsets.push_back(written + buf.size());
+        put(std::to_string(id));
+        put(" 0 obj\n");
+    }
+
+    // Như của VectorStream nhưng đếm số byte đã ghi (cho xref)
+    bool flush() {
+        written += buf.size();
+        return VectorStream::flush();
+    }
+    bool flushIfFull() { return buf.size() < FLUSH_BYTES || flush(); }
+
+    void point(Vec2 p) {
+        numSp(px(p.x));
+        numSp(py(p.y));
+    }
+    void move(Vec2 p) {
+        point(p);
+        put("m ");
+    }
+    void lineTo(Vec2 p) {
+        point(p);
+        put("l ");
+    }
+    void curveTo(Vec2 c1, Vec2 c2, Vec2 p) {
+        point(c1);
+        point(c2);
+        point(p);
+        put("c ");
+    }
+
+    // Elip tâm center, bán trục a, b, quay angle: ảnh affine của 4 cung Bézier xấp xỉ đường tròn đơn vị
+    // (phép affine giữ nguyên Bézier nên sai số tương đối như của đường tròn)
+    void conicPath(Vec2 center, double a, double b, double angle) {
+        const double k = 0.5522847498307936; // 4/3 * (sqrt(2) - 1)
+        double ca = std::cos(angle), sa = std::sin(angle);
+        auto map = [&](double u, double v) {
+            return Vec2{center.x + a * u * ca - b * v * sa, center.y + a * u * sa + b * v * ca};
+        };
+        move(map(1, 0));
+        curveTo(map(1, k), map(k, 1), map(0, 1));
+        curveTo(map(-k, 1), map(-1, k), map(-1, 0));
+        curveTo(map(-1, -k), map(-k, -1), map(0, -1));
+        curveTo(map(k, -1), map(1, -k), map(1, 0));
+        put("h ");
+    }
+
+    void setColor(Color &cur, const Color &c, const char *op) {
+        if (cur.r == c.r && cur.g == c.g && cur.b == c.b) return;
+        cur = c;
+        char tmp[48];
+        snprintf(tmp, sizeof(tmp), "%.3g %.3g %.3g %s\n", c.r, c.g, c.b, op);
+        put(tmp);
+    }
+    void strokeColor(const Color &c) { setColor(curStroke, c, "RG"); }
+    void fillColor(const Color &c) { setColor(curFill, c, "rg"); }
+};
+
+// Xấp xỉ cung tham số P(u), u thuộc [u0, u1], bằng các đoạn Bézier bậc 3 Hermite (đúng điểm và tiếp tuyến
+// ở 2 đầu), chia đôi tới khi các điểm 1/4, 1/2, 3/4 lệch khỏi cung dưới tol. out nhận 3 điểm mỗi đoạn.
+template <typename P, typename D>
+inline void fitCubics(P point, D deriv, double u0, double u1, double tol, std::vector<Vec2> &out, int depth = 0) {
+    Vec2 p0 = point(u0), p1 = point(u1), d0 = deriv(u0), d1 = deriv(u1);
+    double h = (u1 - u0) / 3.0;
+    Vec2 c1 = {p0.x + d0.x * h, p0.y + d0.y * h};
+    Vec2 c2 = {p1.x - d1.x * h, p1.y - d1.y * h};
+    bool ok = depth >= 16;
+    for (int q = 1; q <= 3 && !ok; ++q) {
+        double t = 0.25 * q, s = 1.0 - t;
+        double bx = s * s * s * p0.x + 3 * s * s * t * c1.x + 3 * s * t * t * c2.x + t * t * t * p1.x;
+        double by = s * s * s * p0.y + 3 * s * s * t * c1.y + 3 * s * t * t * c2.y + t * t * t * p1.y;
+        Vec2 e = point(u0 + t * (u1 - u0));
+        if (std::hypot(bx - e.x, by - e.y) > tol) break;
+        if (q == 3) ok = true;
+    }
+    if (!ok) {
+        double um = 0.5 * (u0 + u1);
+        fitCubics(point, deriv, u0, um, tol, out, depth + 1);
+        fitCubics(point, deriv, um, u1, tol, out, depth + 1);
+        return;
+    }
+    out.push_back(c1);
+    out.push_back(c2);
+    out.push_back(p1);
+}
+
+#endif // VECTOR_EXPORT_H
@@ -0,0 +1,28 @@
+#ifndef VERTEX_H
+#define VERTEX_H
+
+#include <cstdint>
+
+// Định dạng đỉnh gửi lên GPU: vị trí NDC 2 float + màu RGBA8 (chuẩn hóa về [0,1] trong shader).
+// 12 byte/đỉnh thay vì 6 float (24 byte): z luôn bằng 0 nên bỏ, màu 3 float nén thành 4 byte.
+struct VertexColor {
+    uint8_t r, g, b, a;
+};
+
+struct Vertex {
+    float x, y;
+    VertexColor color;
+};
+
+static_assert(sizeof(Vertex) == 12, "Vertex phải gọn 12 byte để khớp glVertexAttribPointer");
+
+// Màu float [0,1] -> RGBA8 (làm tròn, kẹp biên)
+inline VertexColor packColor(float r, float g, float b, float a = 1.0f) {
+    auto to8 = [](float v) -> uint8_t {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return (uint8_t)(v * 255.0f + 0.5f);
+    };
+    return {to8(r), to8(g), to8(b), to8(a)};
+}
+
+#endif // VERTEX_H